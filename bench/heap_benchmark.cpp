@@ -0,0 +1,155 @@
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "binaryheap.hpp"
+#include "daryheap.hpp"
+#include "fiboheap.hpp"
+#include "heaptrace.hpp"
+#include "indexedbinaryheap.hpp"
+#include "multilevelbuckets.hpp"
+#include "pairingheap.hpp"
+#include "radixheap.hpp"
+#include "rankpairingheap.hpp"
+#include "referenceheap.hpp"
+#include "skewheap.hpp"
+
+using namespace std;
+
+using Operations = shared_ptr<const vector<HeapOperation>>;
+
+// Register the replay of a workload on one heap; a heap that pops other keys than the reference fails its benchmark
+template <typename PriorityQueue>
+void registerReplay(const string &workload, const string &heap, const Operations &operations, uint64_t expected)
+{
+    benchmark::RegisterBenchmark((workload + "/" + heap).c_str(), [operations, expected](benchmark::State &state)
+                                 {
+        // Like a query workspace, the heap keeps its storage from one replay to the next
+        PriorityQueue pq;
+        uint64_t checksum = expected;
+        for (auto _ : state)
+        {
+            checksum = replayHeapTrace(*operations, pq);
+            benchmark::DoNotOptimize(checksum);
+        }
+        if (checksum != expected)
+        {
+            state.SkipWithError("popped keys differ from ReferenceHeap");
+        }
+        auto count = static_cast<double>(operations->size());
+        state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(operations->size()));
+        state.counters["time_per_op"] = benchmark::Counter(count, benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert); });
+}
+
+// Register a workload on every heap of the query benchmark; monotone workloads also run on the monotone integer queues
+void registerHeaps(const string &workload, vector<HeapOperation> decoded, bool monotone)
+{
+    Operations operations = make_shared<const vector<HeapOperation>>(std::move(decoded));
+    ReferenceHeap<NearestRecord, greater<NearestRecord>> reference;
+    uint64_t expected = replayHeapTrace(*operations, reference);
+
+    registerReplay<FiboHeap<NearestRecord>>(workload, "fibonacci", operations, expected);
+    registerReplay<BinaryHeap<NearestRecord>>(workload, "binary", operations, expected);
+    registerReplay<SkewHeap<NearestRecord>>(workload, "skew", operations, expected);
+    registerReplay<DaryHeap<NearestRecord, 4>>(workload, "4-ary", operations, expected);
+    registerReplay<DaryHeap<NearestRecord, 8>>(workload, "8-ary", operations, expected);
+    registerReplay<DaryHeap<NearestRecord, 16>>(workload, "16-ary", operations, expected);
+    registerReplay<PairingHeap<NearestRecord, TwoPass>>(workload, "pairing", operations, expected);
+    registerReplay<PairingHeap<NearestRecord, MultiPass>>(workload, "pairing-multipass", operations, expected);
+    registerReplay<RankPairingHeap<NearestRecord>>(workload, "rank-pairing", operations, expected);
+    registerReplay<IndexedBinaryHeap<NearestRecord>>(workload, "indexed-binary", operations, expected);
+    registerReplay<FiboHeap<NearestRecord, NewDeletePool>>(workload, "fibonacci-new-delete", operations, expected);
+    registerReplay<SkewHeap<NearestRecord, NewDeletePool>>(workload, "skew-new-delete", operations, expected);
+    if (monotone)
+    {
+        registerReplay<RadixHeap<NearestRecord>>(workload, "radix", operations, expected);
+        registerReplay<BucketQueue<NearestRecord>>(workload, "bucket", operations, expected);
+        registerReplay<MultiLevelBuckets<NearestRecord>>(workload, "multilevel", operations, expected);
+    }
+}
+
+// Print the options this program adds to those of Google Benchmark
+void printUsage(const string &program)
+{
+    cerr << "Usage: " << program << " [--trace=<trace_filename>]... [--patterns=<list>] [--steps=<n>] [--seed=<n>] [benchmark options]\n"
+         << "  --trace=<file>     replay a trace recorded with \"pathfinder trace\"; may be repeated\n"
+         << "  --patterns=<list>  comma-separated synthetic patterns: monotone, random, duplicates, or none (default: all)\n"
+         << "  --steps=<n>        pushes and pops of every synthetic trace (default 1000000)\n"
+         << "  --seed=<n>         seed of the synthetic traces (default 1)\n";
+}
+
+int main(int argc, char *argv[])
+{
+    benchmark::Initialize(&argc, argv);
+
+    // Google Benchmark has removed its own flags; what remains is ours
+    vector<string> traces;
+    vector<string> patterns = {"monotone", "random", "duplicates"};
+    size_t steps = 1'000'000;
+    unsigned seed = 1;
+    try
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            string arg = argv[i];
+            auto value = [&](const string &option)
+            { return arg.rfind(option + "=", 0) == 0 ? arg.substr(option.size() + 1) : string(); };
+            if (!value("--trace").empty())
+            {
+                traces.push_back(value("--trace"));
+            }
+            else if (arg.rfind("--patterns=", 0) == 0)
+            {
+                patterns.clear();
+                string list = value("--patterns");
+                for (size_t start = 0; start <= list.size() && list != "none";)
+                {
+                    size_t end = min(list.find(',', start), list.size());
+                    patterns.push_back(list.substr(start, end - start));
+                    start = end + 1;
+                }
+            }
+            else if (!value("--steps").empty())
+            {
+                steps = stoul(value("--steps"));
+            }
+            else if (!value("--seed").empty())
+            {
+                seed = static_cast<unsigned>(stoul(value("--seed")));
+            }
+            else
+            {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+
+        for (const string &filename : traces)
+        {
+            HeapTrace trace = loadHeapTrace(filename);
+            cerr << filename << ": " << trace.operationCount() << " operations, " << trace.pushCount() << " pushes, "
+                 << trace.clearCount() << " queries\n";
+            // Recorded Dijkstra searches never push below the last popped key
+            registerHeaps("trace:" + filesystem::path(filename).stem().string(), trace.operations(), true);
+        }
+        for (const string &name : patterns)
+        {
+            HeapPattern pattern = parseHeapPattern(name);
+            registerHeaps(name, syntheticHeapTrace(pattern, steps, seed).operations(), pattern != HeapPattern::Random);
+        }
+    }
+    catch (const exception &e)
+    {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+/**
+ * @file alignedallocator.hpp
+ * @brief A standard allocator that returns memory aligned to a fixed boundary.
+ */
+
+/**
+ * @class AlignedAllocator
+ * @brief Allocates arrays whose first element starts on an Alignment-byte boundary.
+ *
+ * Used with std::vector to place heap arrays on cache-line boundaries, so that a
+ * group of siblings can be loaded with aligned vector instructions.
+ *
+ * @tparam T The element type.
+ * @tparam Alignment The alignment in bytes; a power of two.
+ */
+template <typename T, std::size_t Alignment>
+class AlignedAllocator
+{
+public:
+    using value_type = T;
+
+    template <typename U>
+    struct rebind
+    {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() noexcept = default;
+
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment> &) noexcept
+    {
+    }
+
+    T *allocate(std::size_t count)
+    {
+        return static_cast<T *>(::operator new(count * sizeof(T), std::align_val_t(Alignment)));
+    }
+
+    void deallocate(T *pointer, std::size_t) noexcept
+    {
+        ::operator delete(pointer, std::align_val_t(Alignment));
+    }
+
+    friend bool operator==(const AlignedAllocator &, const AlignedAllocator &)
+    {
+        return true;
+    }
+};
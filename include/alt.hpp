@@ -0,0 +1,712 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <numbers>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "astar.hpp"
+#include "daryheap.hpp"
+#include "graph.hpp"
+#include "graphcache.hpp"
+#include "mappedfile.hpp"
+#include "parallel.hpp"
+#include "pathfinder.hpp"
+
+/**
+ * @file alt.hpp
+ * @brief ALT: A* with landmarks and the triangle inequality (Goldberg and Harrelson).
+ *
+ * A few landmark vertices are chosen in a preprocessing step, and the distances
+ * from every landmark to every vertex and from every vertex to every landmark
+ * are stored. By the triangle inequality, for any landmark L
+ *
+ *     d(v, t) >= d(L, t) - d(L, v)    and    d(v, t) >= d(v, L) - d(t, L),
+ *
+ * and the largest of these bounds is a consistent potential for astar<>. It
+ * works on any graph, with or without coordinates, and landmarks "behind" the
+ * destination give much tighter bounds than straight-line distances on
+ * travel-time graphs.
+ *
+ * Landmark table file layout (all integers in the byte order of the writer):
+ *
+ *     LandmarkTableHeader                        64 bytes
+ *     landmarks[landmarkCount]                   int32, starts on a 64-byte boundary
+ *     fromLandmark[vertexCount * landmarkCount]  int32, starts on a 64-byte boundary
+ *     toLandmark[vertexCount * landmarkCount]    int32, starts on a 64-byte boundary
+ */
+
+/**
+ * @brief Landmark selection heuristics.
+ */
+enum class LandmarkSelection
+{
+    Farthest, ///< Repeatedly add the vertex farthest from the landmarks chosen so far.
+    Avoid,    ///< Add a leaf of the part of a shortest path tree that the current landmarks cover worst.
+    Planar,   ///< Split the plane around a central vertex into sectors and take the farthest vertex of each.
+};
+
+// Heap used by the preprocessing searches
+using LandmarkSearchHeap = DaryHeap<NearestRecord, 4>;
+
+/**
+ * @class LandmarkTable
+ * @brief The landmarks of a graph and the distances between them and every vertex.
+ *
+ * Both distance arrays are stored vertex-major: the k distances of one vertex
+ * are adjacent, so evaluating the potential of a vertex reads one short row.
+ * Unreachable pairs hold INF. Like Graph, the arrays are views into storage
+ * that is either owned or a memory-mapped table file, and copies share it.
+ */
+class LandmarkTable
+{
+public:
+    /**
+     * @brief Constructs an empty table without landmarks.
+     */
+    LandmarkTable() : storage(), vertices(0), landmarks(), fromLandmark(), toLandmark() {}
+
+    /**
+     * @brief Adopts arrays that live in externally managed memory.
+     *
+     * @param storage The object that owns the memory the spans point into.
+     * @param vertexCount The number of vertices of the graph.
+     * @param landmarks The landmark vertices.
+     * @param fromLandmark fromLandmark[v * k + i] is the distance from landmark i to v.
+     * @param toLandmark toLandmark[v * k + i] is the distance from v to landmark i.
+     */
+    LandmarkTable(std::shared_ptr<const void> storage, int vertexCount, std::span<const int> landmarks,
+                  std::span<const int> fromLandmark, std::span<const int> toLandmark)
+        : storage(std::move(storage)), vertices(vertexCount), landmarks(landmarks), fromLandmark(fromLandmark), toLandmark(toLandmark)
+    {
+    }
+
+    int vertexCount() const
+    {
+        return vertices;
+    }
+
+    int landmarkCount() const
+    {
+        return static_cast<int>(landmarks.size());
+    }
+
+    /**
+     * @brief Returns the distances from every landmark to v.
+     */
+    const int *fromRow(int v) const
+    {
+        return fromLandmark.data() + static_cast<size_t>(v) * landmarks.size();
+    }
+
+    /**
+     * @brief Returns the distances from v to every landmark.
+     */
+    const int *toRow(int v) const
+    {
+        return toLandmark.data() + static_cast<size_t>(v) * landmarks.size();
+    }
+
+    /**
+     * @brief Raw access to the arrays, used when serializing the table.
+     */
+    std::span<const int> landmarkArray() const { return landmarks; }
+    std::span<const int> fromArray() const { return fromLandmark; }
+    std::span<const int> toArray() const { return toLandmark; }
+
+private:
+    std::shared_ptr<const void> storage; ///< Keeps the memory behind the spans alive.
+    int vertices;                        ///< The number of vertices of the graph.
+    std::span<const int> landmarks;      ///< The landmark vertices.
+    std::span<const int> fromLandmark;   ///< Distances from the landmarks, vertex-major.
+    std::span<const int> toLandmark;     ///< Distances to the landmarks, vertex-major.
+};
+
+/**
+ * @class LandmarkPotential
+ * @brief The ALT lower bound, for use with astar<>.
+ *
+ * For every landmark, the two triangle-inequality bounds are taken where the
+ * distances they need are finite, and the largest bound wins. If a landmark
+ * reaches v but not t, or reaches t while v cannot reach the landmark, v cannot
+ * reach t at all; the potential then returns INF and A* prunes v.
+ */
+class LandmarkPotential
+{
+public:
+    /**
+     * @param table The landmark table of the graph the potential is used on.
+     */
+    explicit LandmarkPotential(LandmarkTable table) : table(std::move(table)) {}
+
+    int estimate(int v, int target) const
+    {
+        const int *fromV = table.fromRow(v);
+        const int *fromT = table.fromRow(target);
+        const int *toV = table.toRow(v);
+        const int *toT = table.toRow(target);
+
+        int bound = 0;
+        for (int i = 0, k = table.landmarkCount(); i < k; i++)
+        {
+            // d(v, t) >= d(L, t) - d(L, v)
+            if (fromV[i] != INF)
+            {
+                if (fromT[i] == INF)
+                    return INF;
+                bound = std::max(bound, fromT[i] - fromV[i]);
+            }
+            // d(v, t) >= d(v, L) - d(t, L)
+            if (toT[i] != INF)
+            {
+                if (toV[i] == INF)
+                    return INF;
+                bound = std::max(bound, toV[i] - toT[i]);
+            }
+        }
+        return bound;
+    }
+
+private:
+    LandmarkTable table; ///< The distances the bounds are computed from.
+};
+
+// The arrays behind a landmark table that was computed rather than mapped from a file
+struct LandmarkArrays
+{
+    std::vector<int> landmarks;
+    std::vector<int> fromLandmark;
+    std::vector<int> toLandmark;
+};
+
+// Fill column i of the vertex-major arrays: job 0 with the distances from the landmark, job 1 with those to it
+inline void fillLandmarkColumn(LandmarkArrays &arrays, size_t stride, size_t i, int landmark, long long job, const Graph &graph,
+                               const Graph &reverse)
+{
+    bool forward = job == 0;
+    std::vector<int> distances = one_to_all_dijkstra<LandmarkSearchHeap>({landmark}, forward ? graph : reverse);
+    std::vector<int> &column = forward ? arrays.fromLandmark : arrays.toLandmark;
+    for (size_t v = 0; v < distances.size(); v++)
+    {
+        column[v * stride + i] = distances[v];
+    }
+}
+
+/**
+ * @brief Picks landmarks by repeatedly adding the vertex farthest from those chosen so far.
+ *
+ * The first landmark is the vertex farthest from a random start vertex.
+ * Vertices unreachable from the current landmarks are taken once no reachable
+ * vertex is left, so every strongly connected part of the graph gets covered.
+ *
+ * @param graph The graph.
+ * @param count The number of landmarks; at most the number of vertices are returned.
+ * @param seed Seed of the random start vertex.
+ * @param landmarks Landmarks chosen before, which are kept and extended.
+ * @return The landmarks.
+ */
+inline std::vector<int> selectFarthestLandmarks(const Graph &graph, int count, unsigned seed = 1, std::vector<int> landmarks = {})
+{
+    int n = graph.vertexCount();
+    count = std::min(count, n);
+    if (landmarks.empty() && count > 0)
+    {
+        std::mt19937 random(seed);
+        int root = static_cast<int>(random() % static_cast<unsigned>(n));
+        std::vector<int> distances = one_to_all_dijkstra<LandmarkSearchHeap>({root}, graph);
+        landmarks.push_back(static_cast<int>(std::max_element(distances.begin(), distances.end(),
+                                                              [](int a, int b)
+                                                              { return (a == INF ? -1 : a) < (b == INF ? -1 : b); }) -
+                                             distances.begin()));
+    }
+
+    while (static_cast<int>(landmarks.size()) < count)
+    {
+        std::vector<int> distances = one_to_all_dijkstra<LandmarkSearchHeap>(landmarks, graph);
+
+        // The farthest reachable vertex, or any vertex the landmarks cannot reach
+        int best = -1;
+        for (int v = 0; v < n; v++)
+        {
+            if (best < 0 || (distances[best] != INF && (distances[v] == INF || distances[v] > distances[best])))
+            {
+                best = v;
+            }
+        }
+        if (distances[best] == 0)
+        {
+            break; // every vertex is a landmark
+        }
+        landmarks.push_back(best);
+    }
+    return landmarks;
+}
+
+/**
+ * @brief Picks landmarks with the avoid heuristic of Goldberg and Harrelson.
+ *
+ * For each new landmark, a shortest path tree is grown from a random root. Every
+ * vertex v is weighted by how badly the current landmarks bound d(root, v), the
+ * distance minus the ALT bound, and subtrees that already contain a landmark
+ * count as covered. Starting from the vertex with the heaviest subtree, the walk
+ * descends into the heaviest child until it reaches a leaf, which becomes the
+ * next landmark. It is placed "behind" the region the landmarks serve worst.
+ *
+ * The selection needs the distances from and to every landmark chosen so far,
+ * which are exactly the columns of the landmark table, so it fills the table as
+ * it goes: every landmark search runs once, and no second copy of the
+ * distances is kept.
+ *
+ * @param graph The graph.
+ * @param count The number of landmarks.
+ * @param seed Seed of the random roots.
+ * @param threads The number of threads; the two searches of each landmark run in parallel.
+ * @return The table of the chosen landmarks.
+ */
+inline LandmarkTable buildAvoidLandmarkTable(const Graph &graph, int count, unsigned seed = 1, int threads = defaultThreadCount())
+{
+    int n = graph.vertexCount();
+    count = std::max(0, std::min(count, n));
+    Graph reversible = graph;
+    if (!reversible.hasReverse())
+    {
+        reversible.computeReverse();
+    }
+
+    // Vertex-major with a stride of count; compacted at the end if fewer landmarks are found
+    auto stride = static_cast<size_t>(count);
+    size_t cells = static_cast<size_t>(n) * stride;
+    auto owned = std::make_shared<LandmarkArrays>(LandmarkArrays{{}, std::vector<int>(cells), std::vector<int>(cells)});
+    std::vector<int> &landmarks = owned->landmarks;
+    const std::vector<int> &fromLandmark = owned->fromLandmark;
+    const std::vector<int> &toLandmark = owned->toLandmark;
+
+    std::mt19937 random(seed);
+    std::vector<int> parents;
+    std::vector<long long> size(static_cast<size_t>(n));
+    std::vector<char> isLandmark(static_cast<size_t>(n), 0);
+    std::vector<char> covered(static_cast<size_t>(n));
+    std::vector<int> heaviestChild(static_cast<size_t>(n));
+    std::vector<int> firstChild(static_cast<size_t>(n) + 1); // children of v: children[firstChild[v], firstChild[v + 1])
+    std::vector<int> children(static_cast<size_t>(n));
+    std::vector<int> cursor(static_cast<size_t>(n));
+    std::vector<int> order;
+
+    while (static_cast<int>(landmarks.size()) < count)
+    {
+        int root = static_cast<int>(random() % static_cast<unsigned>(n));
+        std::vector<int> distances = one_to_all_dijkstra<LandmarkSearchHeap>({root}, graph, &parents);
+
+        // Breadth-first order of the shortest path tree: parents come before their children
+        std::fill(firstChild.begin(), firstChild.end(), 0);
+        for (int v = 0; v < n; v++)
+        {
+            if (parents[v] >= 0)
+            {
+                firstChild[parents[v] + 1]++;
+            }
+        }
+        for (int v = 0; v < n; v++)
+        {
+            firstChild[v + 1] += firstChild[v];
+        }
+        std::copy(firstChild.begin(), firstChild.end() - 1, cursor.begin());
+        for (int v = 0; v < n; v++)
+        {
+            if (parents[v] >= 0)
+            {
+                children[cursor[parents[v]]++] = v;
+            }
+        }
+        order.assign(1, root);
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            int v = order[i];
+            order.insert(order.end(), children.begin() + firstChild[v], children.begin() + firstChild[v + 1]);
+        }
+
+        for (int v : order)
+        {
+            // Weight: the gap between d(root, v) and the best landmark bound on it
+            const int *fromRoot = fromLandmark.data() + static_cast<size_t>(root) * stride;
+            const int *toRoot = toLandmark.data() + static_cast<size_t>(root) * stride;
+            const int *fromV = fromLandmark.data() + static_cast<size_t>(v) * stride;
+            const int *toV = toLandmark.data() + static_cast<size_t>(v) * stride;
+            int bound = 0;
+            for (size_t i = 0; i < landmarks.size(); i++)
+            {
+                if (fromRoot[i] != INF && fromV[i] != INF)
+                    bound = std::max(bound, fromV[i] - fromRoot[i]);
+                if (toRoot[i] != INF && toV[i] != INF)
+                    bound = std::max(bound, toRoot[i] - toV[i]);
+            }
+            size[v] = distances[v] - bound;
+            covered[v] = isLandmark[v];
+            heaviestChild[v] = -1;
+        }
+        for (auto it = order.rbegin(); it != order.rend(); ++it)
+        {
+            int v = *it;
+            if (covered[v])
+            {
+                size[v] = 0;
+            }
+            int parent = parents[v];
+            if (parent >= 0)
+            {
+                covered[parent] = covered[parent] || covered[v];
+                size[parent] += size[v];
+                if (heaviestChild[parent] < 0 || size[v] > size[heaviestChild[parent]])
+                {
+                    heaviestChild[parent] = v;
+                }
+            }
+        }
+
+        int heaviest = *std::max_element(order.begin(), order.end(), [&](int a, int b)
+                                         { return (covered[a] ? 0 : size[a]) < (covered[b] ? 0 : size[b]); });
+        if (covered[heaviest] || size[heaviest] <= 0)
+        {
+            // Nothing left to improve from this root: fall back to the farthest vertex
+            std::vector<int> extended = selectFarthestLandmarks(graph, static_cast<int>(landmarks.size()) + 1, seed, landmarks);
+            if (extended.size() == landmarks.size())
+            {
+                break;
+            }
+            heaviest = extended.back();
+        }
+        else
+        {
+            while (heaviestChild[heaviest] >= 0)
+            {
+                heaviest = heaviestChild[heaviest];
+            }
+        }
+
+        parallelForStealing(std::min(threads, 2), 2, [&](int, long long job)
+                            { fillLandmarkColumn(*owned, stride, landmarks.size(), heaviest, job, graph, reversible.reverse()); });
+        landmarks.push_back(heaviest);
+        isLandmark[heaviest] = 1;
+    }
+
+    size_t k = landmarks.size();
+    if (k < stride)
+    {
+        for (auto *column : {&owned->fromLandmark, &owned->toLandmark})
+        {
+            for (size_t v = 1; v < static_cast<size_t>(n); v++)
+            {
+                std::copy_n(column->begin() + static_cast<std::ptrdiff_t>(v * stride), k, column->begin() + static_cast<std::ptrdiff_t>(v * k));
+            }
+            column->resize(static_cast<size_t>(n) * k);
+            column->shrink_to_fit();
+        }
+    }
+    std::span<const int> l = owned->landmarks, f = owned->fromLandmark, t = owned->toLandmark;
+    return LandmarkTable(std::move(owned), n, l, f, t);
+}
+
+/**
+ * @brief Picks landmarks with the avoid heuristic of Goldberg and Harrelson; see buildAvoidLandmarkTable().
+ *
+ * @param graph The graph.
+ * @param count The number of landmarks.
+ * @param seed Seed of the random roots.
+ * @return The landmarks.
+ */
+inline std::vector<int> selectAvoidLandmarks(const Graph &graph, int count, unsigned seed = 1)
+{
+    LandmarkTable table = buildAvoidLandmarkTable(graph, count, seed);
+    std::span<const int> landmarks = table.landmarkArray();
+    return std::vector<int>(landmarks.begin(), landmarks.end());
+}
+
+/**
+ * @brief Picks landmarks spread around the map.
+ *
+ * The plane is divided into count sectors of equal angle around the vertex
+ * closest to the mean coordinate, and the vertex of every sector that is
+ * farthest from that centre in the graph becomes a landmark. Sectors without
+ * vertices are filled with the farthest heuristic.
+ *
+ * @param graph The graph.
+ * @param coordinates One coordinate per vertex.
+ * @param count The number of landmarks.
+ * @return The landmarks.
+ * @throws std::invalid_argument If the number of coordinates differs from the number of vertices.
+ */
+inline std::vector<int> selectPlanarLandmarks(const Graph &graph, const std::vector<Coordinate> &coordinates, int count)
+{
+    int n = graph.vertexCount();
+    if (static_cast<int>(coordinates.size()) != n)
+    {
+        throw std::invalid_argument("There must be one coordinate per vertex");
+    }
+    count = std::min(count, n);
+    if (count <= 0)
+    {
+        return {};
+    }
+
+    double meanX = 0.0;
+    double meanY = 0.0;
+    for (const Coordinate &coordinate : coordinates)
+    {
+        meanX += coordinate.longitude;
+        meanY += coordinate.latitude;
+    }
+    meanX /= n;
+    meanY /= n;
+    auto squaredOffset = [&](int v)
+    {
+        double dx = coordinates[v].longitude - meanX;
+        double dy = coordinates[v].latitude - meanY;
+        return dx * dx + dy * dy;
+    };
+    int center = 0;
+    for (int v = 1; v < n; v++)
+    {
+        if (squaredOffset(v) < squaredOffset(center))
+        {
+            center = v;
+        }
+    }
+
+    std::vector<int> distances = one_to_all_dijkstra<LandmarkSearchHeap>({center}, graph);
+    std::vector<int> farthest(static_cast<size_t>(count), -1);
+    for (int v = 0; v < n; v++)
+    {
+        if (distances[v] == INF || v == center)
+        {
+            continue;
+        }
+        double angle = std::atan2(coordinates[v].latitude - coordinates[center].latitude,
+                                  coordinates[v].longitude - coordinates[center].longitude);
+        int sector = std::min(count - 1, static_cast<int>((angle + std::numbers::pi) / (2 * std::numbers::pi) * count));
+        if (farthest[sector] < 0 || distances[v] > distances[farthest[sector]])
+        {
+            farthest[sector] = v;
+        }
+    }
+
+    std::vector<int> landmarks;
+    for (int v : farthest)
+    {
+        if (v >= 0)
+        {
+            landmarks.push_back(v);
+        }
+    }
+    return selectFarthestLandmarks(graph, count, 1, std::move(landmarks));
+}
+
+/**
+ * @brief Picks landmarks with the given heuristic.
+ *
+ * @param graph The graph.
+ * @param count The number of landmarks.
+ * @param method The heuristic.
+ * @param coordinates One coordinate per vertex; required by LandmarkSelection::Planar only.
+ * @return The landmarks.
+ * @throws std::invalid_argument If the planar heuristic is requested without coordinates.
+ */
+inline std::vector<int> selectLandmarks(const Graph &graph, int count, LandmarkSelection method, const std::vector<Coordinate> *coordinates = nullptr)
+{
+    switch (method)
+    {
+    case LandmarkSelection::Farthest:
+        return selectFarthestLandmarks(graph, count);
+    case LandmarkSelection::Avoid:
+        return selectAvoidLandmarks(graph, count);
+    case LandmarkSelection::Planar:
+        if (coordinates == nullptr)
+        {
+            throw std::invalid_argument("Planar landmark selection needs coordinates");
+        }
+        return selectPlanarLandmarks(graph, *coordinates, count);
+    }
+    throw std::invalid_argument("Unknown landmark selection method");
+}
+
+/**
+ * @brief Computes the distance table of the given landmarks.
+ *
+ * The 2k one-to-all searches (forward on the graph, backward on the reverse
+ * graph) are independent and run in parallel; each writes its own column of
+ * the vertex-major arrays.
+ *
+ * @param graph The graph.
+ * @param landmarks The landmark vertices.
+ * @param threads The number of threads.
+ * @return The table.
+ */
+inline LandmarkTable buildLandmarkTable(const Graph &graph, const std::vector<int> &landmarks, int threads = defaultThreadCount())
+{
+    Graph reversible = graph;
+    if (!reversible.hasReverse())
+    {
+        reversible.computeReverse();
+    }
+
+    size_t k = landmarks.size();
+    size_t cells = static_cast<size_t>(graph.vertexCount()) * k;
+    auto owned = std::make_shared<LandmarkArrays>(LandmarkArrays{landmarks, std::vector<int>(cells), std::vector<int>(cells)});
+
+    // Each landmark needs two independent searches: job 2i fills column i forwards, job 2i+1 backwards
+    parallelForStealing(threads, static_cast<long long>(2 * k), [&](int, long long job)
+                        {
+        auto i = static_cast<size_t>(job) / 2;
+        fillLandmarkColumn(*owned, k, i, landmarks[i], job % 2, graph, reversible.reverse()); });
+
+    std::span<const int> l = owned->landmarks, f = owned->fromLandmark, t = owned->toLandmark;
+    return LandmarkTable(std::move(owned), graph.vertexCount(), l, f, t);
+}
+
+/**
+ * @brief Picks landmarks with the given heuristic and computes their distance table.
+ *
+ * The avoid heuristic already computes the table while it selects, so it is
+ * returned as is; the other heuristics select first and call buildLandmarkTable().
+ *
+ * @param graph The graph.
+ * @param count The number of landmarks.
+ * @param method The heuristic.
+ * @param coordinates One coordinate per vertex; required by LandmarkSelection::Planar only.
+ * @param threads The number of threads of the landmark searches.
+ * @return The landmark table.
+ * @throws std::invalid_argument If the planar heuristic is requested without coordinates.
+ */
+inline LandmarkTable selectLandmarkTable(const Graph &graph, int count, LandmarkSelection method,
+                                         const std::vector<Coordinate> *coordinates = nullptr, int threads = defaultThreadCount())
+{
+    if (method == LandmarkSelection::Avoid)
+    {
+        return buildAvoidLandmarkTable(graph, count, 1, threads);
+    }
+    return buildLandmarkTable(graph, selectLandmarks(graph, count, method, coordinates), threads);
+}
+
+// Magic bytes at the start of every landmark table file
+inline constexpr char LANDMARK_TABLE_MAGIC[8] = {'P', 'F', 'L', 'M', 'A', 'R', 'K', '\0'};
+
+// Format version; bump it whenever the layout changes
+inline constexpr uint32_t LANDMARK_TABLE_VERSION = 1;
+
+/**
+ * @struct LandmarkTableHeader
+ * @brief The fixed-size header at the start of a landmark table file.
+ */
+struct LandmarkTableHeader
+{
+    char magic[8];              ///< LANDMARK_TABLE_MAGIC.
+    uint32_t version;           ///< LANDMARK_TABLE_VERSION.
+    uint32_t byteOrder;         ///< GRAPH_CACHE_BYTE_ORDER.
+    uint64_t vertexCount;       ///< Number of vertices of the graph.
+    uint64_t landmarkCount;     ///< Number of landmarks.
+    uint64_t landmarksPosition; ///< File offset of the landmark array.
+    uint64_t fromPosition;      ///< File offset of the distances from the landmarks.
+    uint64_t toPosition;        ///< File offset of the distances to the landmarks.
+    uint64_t checksum;          ///< graphCacheChecksum() of the three arrays.
+};
+
+static_assert(sizeof(LandmarkTableHeader) == 64, "LandmarkTableHeader must stay 64 bytes");
+
+/**
+ * @brief Writes a landmark table to disk.
+ *
+ * @param table The table to write.
+ * @param filename The output file, which is overwritten.
+ * @throws std::runtime_error If the file cannot be written.
+ */
+inline void writeLandmarkTable(const LandmarkTable &table, const std::string &filename)
+{
+    std::array<uint64_t, 3> positions = alignedSectionPositions<3>(
+        sizeof(LandmarkTableHeader), {table.landmarkArray().size(), table.fromArray().size(), table.toArray().size()});
+
+    LandmarkTableHeader header{};
+    std::memcpy(header.magic, LANDMARK_TABLE_MAGIC, sizeof(header.magic));
+    header.version = LANDMARK_TABLE_VERSION;
+    header.byteOrder = GRAPH_CACHE_BYTE_ORDER;
+    header.vertexCount = static_cast<uint64_t>(table.vertexCount());
+    header.landmarkCount = static_cast<uint64_t>(table.landmarkCount());
+    header.landmarksPosition = positions[0];
+    header.fromPosition = positions[1];
+    header.toPosition = positions[2];
+    header.checksum = graphCacheChecksum(table.landmarkArray(), table.fromArray(), table.toArray());
+
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Error opening " + filename + " for writing");
+    }
+
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    writeAlignedSections<3>(file, positions, {table.landmarkArray(), table.fromArray(), table.toArray()});
+
+    if (!file)
+    {
+        throw std::runtime_error("Error writing " + filename);
+    }
+}
+
+/**
+ * @brief Maps a landmark table file and returns a table that views it without copying.
+ *
+ * @param filename The landmark table file.
+ * @param graph The graph the table is used with; its vertex count must match.
+ * @param verifyChecksum Whether to recompute and compare the payload checksum.
+ * @return The mapped table.
+ * @throws std::runtime_error If the file is not a valid landmark table for the graph.
+ */
+inline LandmarkTable loadLandmarkTable(const std::string &filename, const Graph &graph, bool verifyChecksum = false)
+{
+    auto file = std::make_shared<MappedFile>(filename);
+
+    LandmarkTableHeader header{};
+    if (file->size() < sizeof(header))
+    {
+        throw std::runtime_error(filename + ": file too small for a landmark table header");
+    }
+    std::memcpy(&header, file->data(), sizeof(header));
+
+    if (std::memcmp(header.magic, LANDMARK_TABLE_MAGIC, sizeof(header.magic)) != 0)
+    {
+        throw std::runtime_error(filename + ": not a landmark table file");
+    }
+    if (header.byteOrder != GRAPH_CACHE_BYTE_ORDER)
+    {
+        throw std::runtime_error(filename + ": landmark table was written with a different byte order");
+    }
+    if (header.version != LANDMARK_TABLE_VERSION)
+    {
+        throw std::runtime_error(filename + ": unsupported landmark table version " + std::to_string(header.version));
+    }
+    if (header.vertexCount != static_cast<uint64_t>(graph.vertexCount()))
+    {
+        throw std::runtime_error(filename + ": landmark table does not belong to this graph");
+    }
+    if (header.landmarkCount > header.vertexCount)
+    {
+        throw std::runtime_error(filename + ": too many landmarks");
+    }
+
+    uint64_t distanceCount = header.vertexCount * header.landmarkCount;
+    auto [landmarks, fromLandmark, toLandmark] = mapAlignedSections<3>(
+        *file, {header.landmarksPosition, header.fromPosition, header.toPosition}, {header.landmarkCount, distanceCount, distanceCount}, filename);
+
+    if (verifyChecksum && graphCacheChecksum(landmarks, fromLandmark, toLandmark) != header.checksum)
+    {
+        throw std::runtime_error(filename + ": checksum mismatch");
+    }
+
+    return LandmarkTable(std::move(file), graph.vertexCount(), landmarks, fromLandmark, toLandmark);
+}
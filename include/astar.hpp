@@ -0,0 +1,202 @@
+#pragma once
+
+#include <cmath>
+#include <limits>
+#include <numbers>
+#include <stdexcept>
+#include <vector>
+
+#include "graph.hpp"
+#include "pathfinder.hpp"
+
+/**
+ * @file astar.hpp
+ * @brief Goal-directed search: A* with a lower bound derived from vertex coordinates.
+ *
+ * A* is Dijkstra's algorithm with every key raised by a potential pi(v), a lower
+ * bound on the distance from v to the destination. If the potential is
+ * consistent, pi(u) - pi(v) <= w(u, v) for every arc, the reduced arc weights
+ * stay non-negative: every vertex is still popped once with its final distance,
+ * popped keys never decrease (so the monotone integer queues work too), and the
+ * search is pulled towards the destination instead of growing a ball.
+ */
+
+/**
+ * @class GeometricPotential
+ * @brief A consistent potential from the straight-line distance between vertex positions.
+ *
+ * Every vertex is placed on the unit sphere, and the bound is the chord between a
+ * vertex and the destination. The chord is a Euclidean distance, so it obeys the
+ * triangle inequality, and it never exceeds the great-circle distance. It is
+ * turned into graph units by a scale factor: the smallest ratio of arc weight
+ * to chord length over all arcs. Because the scale is measured on the graph
+ * itself, the bound is valid for any metric: distances (-d graphs) and travel
+ * times (-t graphs) each get their own scale. The scale is lowered by a tiny
+ * safety factor against rounding, and the bound is rounded down; both keep it
+ * consistent.
+ */
+class GeometricPotential
+{
+public:
+    /**
+     * @brief Measures the scale of the graph and precomputes the vertex positions.
+     *
+     * @param graph The graph the potential is used on.
+     * @param coordinates One coordinate per vertex of the graph.
+     * @throws std::invalid_argument If the number of coordinates differs from the number of vertices.
+     */
+    GeometricPotential(const Graph &graph, const std::vector<Coordinate> &coordinates) : points(), scale(0.0)
+    {
+        if (static_cast<int>(coordinates.size()) != graph.vertexCount())
+        {
+            throw std::invalid_argument("There must be one coordinate per vertex");
+        }
+
+        points.reserve(coordinates.size());
+        for (const Coordinate &coordinate : coordinates)
+        {
+            double longitude = coordinate.longitude * RADIANS_PER_UNIT;
+            double latitude = coordinate.latitude * RADIANS_PER_UNIT;
+            points.push_back({std::cos(latitude) * std::cos(longitude), std::cos(latitude) * std::sin(longitude), std::sin(latitude)});
+        }
+
+        // The largest scale for which no arc is shorter than its bound
+        double ratio = std::numeric_limits<double>::infinity();
+        for (int u = 0; u < graph.vertexCount(); u++)
+        {
+            for (int e = graph.beginArc(u), last = graph.endArc(u); e < last; e++)
+            {
+                double length = chord(points[u], points[graph.target(e)]);
+                if (length > 0.0)
+                {
+                    ratio = std::min(ratio, graph.weight(e) / length);
+                }
+            }
+        }
+        scale = std::isinf(ratio) ? 0.0 : ratio * SAFETY_FACTOR;
+    }
+
+    /**
+     * @brief Returns a lower bound on the distance from v to target, in graph units.
+     */
+    int estimate(int v, int target) const
+    {
+        return static_cast<int>(scale * chord(points[v], points[target]));
+    }
+
+    /**
+     * @brief Returns the factor that converts chord lengths on the unit sphere into graph units.
+     */
+    double unitsPerChord() const
+    {
+        return scale;
+    }
+
+private:
+    /**
+     * @struct Point
+     * @brief A position on the unit sphere.
+     */
+    struct Point
+    {
+        double x;
+        double y;
+        double z;
+    };
+
+    // DIMACS coordinates are in millionths of a degree
+    static constexpr double RADIANS_PER_UNIT = std::numbers::pi / 180.0 / 1e6;
+
+    // Margin that keeps the bound consistent despite floating-point rounding
+    static constexpr double SAFETY_FACTOR = 1.0 - 1e-6;
+
+    std::vector<Point> points; ///< Position of every vertex.
+    double scale;              ///< Graph units per unit of chord length.
+
+    static double chord(const Point &a, const Point &b)
+    {
+        double dx = a.x - b.x;
+        double dy = a.y - b.y;
+        double dz = a.z - b.z;
+        return std::sqrt(dx * dx + dy * dy + dz * dz);
+    }
+};
+
+/**
+ * @brief A* search from start to destination.
+ *
+ * Records are queued with key distance + potential. With a consistent potential
+ * the first pop of a vertex carries its final distance, so later records of the
+ * same vertex are skipped through the settled bitset of the workspace.
+ *
+ * @tparam PriorityQueue The type of priority queue; any heap works.
+ * @tparam Potential A type with int estimate(int v, int target) const returning a consistent lower bound,
+ *         or INF if v provably cannot reach target; such vertices are never queued.
+ *
+ * @param start The starting vertex.
+ * @param destination The destination vertex.
+ * @param graph The graph.
+ * @param potential The lower bound that directs the search.
+ * @param workspace The distances, settled bits and heap to run on; reset first.
+ *
+ * @return The shortest path length from the start vertex to the destination vertex, or INF if there is no path.
+ */
+template <typename PriorityQueue, typename Potential>
+int astar(int start, int destination, const Graph &graph, const Potential &potential, QueryWorkspace<PriorityQueue> &workspace)
+{
+    workspace.reset(graph.vertexCount());
+    workspace.setDistance(start, 0);
+
+    int startBound = potential.estimate(start, destination);
+    if (startBound == INF)
+        return INF;
+
+    PriorityQueue &pq = workspace.queue();
+    auto &stats = heapStats(pq);
+    pq.push({startBound, start});
+
+    while (!pq.empty())
+    {
+        int u = pq.pop().vertex;
+
+        if (u == destination)
+            return workspace.distance(u);
+
+        if (workspace.isSettled(u))
+        {
+            stats.stalePop();
+            continue;
+        }
+        workspace.settle(u);
+        stats.settle();
+
+        int du = workspace.distance(u);
+        for (int e = graph.beginArc(u), last = graph.endArc(u); e < last; e++)
+        {
+            stats.relax();
+            int v = graph.target(e);
+            int candidate = du + graph.weight(e);
+
+            if (candidate < workspace.distance(v))
+            {
+                int bound = potential.estimate(v, destination);
+                if (bound == INF)
+                    continue;
+                workspace.setDistance(v, candidate);
+                pq.push({candidate + bound, v});
+            }
+        }
+    }
+
+    return INF; // If the destination is not reachable
+}
+
+/**
+ * @brief Runs A* with a workspace of its own; see the overload above.
+ */
+template <typename PriorityQueue, typename Potential>
+int astar(int start, int destination, const Graph &graph, const Potential &potential)
+{
+    QueryWorkspace<PriorityQueue> workspace(graph.vertexCount());
+    return astar<PriorityQueue>(start, destination, graph, potential, workspace);
+}
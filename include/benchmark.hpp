@@ -0,0 +1,642 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <ostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "parallel.hpp"
+#include "perfcounters.hpp"
+#include "queryworkspace.hpp"
+#include "stats.hpp"
+
+/**
+ * @file benchmark.hpp
+ * @brief Timing harness for query batches: warmup, repetitions, shuffling, latency percentiles and reports.
+ *
+ * runBenchmark() answers a batch of queries several times and records the
+ * wall-clock and CPU time of every single query; BenchmarkReport prints the
+ * results as text, JSON or CSV. Nothing is printed while the clock runs.
+ * When the heaps count their operations (PATHFINDER_COUNT_OPERATIONS, see
+ * stats.hpp), the counts of every query are collected and reported as well,
+ * and so are the hardware counters of perfcounters.hpp when asked for.
+ */
+
+/**
+ * @enum ReportFormat
+ * @brief How a BenchmarkReport prints its results.
+ */
+enum class ReportFormat
+{
+    Text, ///< Readable sections with every distance, as the benchmark has always printed them.
+    Json, ///< One JSON document with a record per section, including the distances.
+    Csv   ///< One CSV row per section, without the distances.
+};
+
+/**
+ * @brief Parses "text", "json" or "csv".
+ *
+ * @throws std::invalid_argument If the name is unknown.
+ */
+inline ReportFormat parseReportFormat(const std::string &name)
+{
+    if (name == "text")
+    {
+        return ReportFormat::Text;
+    }
+    if (name == "json")
+    {
+        return ReportFormat::Json;
+    }
+    if (name == "csv")
+    {
+        return ReportFormat::Csv;
+    }
+    throw std::invalid_argument("Unknown report format " + name);
+}
+
+/**
+ * @struct BenchmarkOptions
+ * @brief How often and in which order a batch of queries is run.
+ */
+struct BenchmarkOptions
+{
+    int threads = 1;           ///< Worker threads per batch.
+    int warmup = 0;            ///< Untimed runs of the batch before the measured ones.
+    int repetitions = 1;       ///< Measured runs of the batch.
+    bool shuffle = false;      ///< Whether every run answers the queries in a fresh random order.
+    unsigned seed = 1;         ///< Seed of the shuffles.
+    bool perfCounters = false; ///< Whether every query is measured with hardware performance counters.
+};
+
+/**
+ * @struct LatencySummary
+ * @brief Percentiles of a set of per-query times, in microseconds.
+ */
+struct LatencySummary
+{
+    double p50 = 0.0;
+    double p90 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+};
+
+/**
+ * @brief Computes nearest-rank percentiles of times given in nanoseconds.
+ */
+inline LatencySummary summarizeLatencies(std::vector<int64_t> nanoseconds)
+{
+    LatencySummary summary;
+    if (nanoseconds.empty())
+    {
+        return summary;
+    }
+
+    std::sort(nanoseconds.begin(), nanoseconds.end());
+    auto rank = [&](double fraction)
+    {
+        auto index = static_cast<size_t>(std::ceil(fraction * static_cast<double>(nanoseconds.size())));
+        return static_cast<double>(nanoseconds[std::max<size_t>(index, 1) - 1]) / 1e3;
+    };
+    summary.p50 = rank(0.50);
+    summary.p90 = rank(0.90);
+    summary.p99 = rank(0.99);
+    summary.max = static_cast<double>(nanoseconds.back()) / 1e3;
+    return summary;
+}
+
+// The operation counts in the order and under the names the reports use
+inline constexpr std::pair<const char *, int64_t OperationCounts::*> OPERATION_FIELDS[] = {
+    {"pushes", &OperationCounts::pushes},
+    {"pops", &OperationCounts::pops},
+    {"stale_pops", &OperationCounts::stalePops},
+    {"decrease_keys", &OperationCounts::decreaseKeys},
+    {"peak_size", &OperationCounts::peakSize},
+    {"settled", &OperationCounts::settled},
+    {"relaxed", &OperationCounts::relaxed},
+    {"links", &OperationCounts::links},
+    {"consolidations", &OperationCounts::consolidations},
+};
+
+/**
+ * @brief Moves the operation counts of the last query out of a workspace.
+ *
+ * @return Whether the heap of the workspace counts its operations; if not, counts is left alone.
+ */
+template <class PriorityQueue>
+bool takeOperationCounts(QueryWorkspace<PriorityQueue> &workspace, OperationCounts &counts)
+{
+    if constexpr (requires { workspace.queue().stats().take(); })
+    {
+        counts = workspace.queue().stats().take();
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+// Both searches of a bidirectional query add up
+template <class PriorityQueue>
+bool takeOperationCounts(BidirectionalWorkspace<PriorityQueue> &workspace, OperationCounts &counts)
+{
+    OperationCounts backward;
+    if (!takeOperationCounts(workspace.forward, counts) || !takeOperationCounts(workspace.backward, backward))
+    {
+        return false;
+    }
+    counts += backward;
+    return true;
+}
+
+// Workspaces without a heap have nothing to count
+template <class Workspace>
+bool takeOperationCounts(Workspace &, OperationCounts &)
+{
+    return false;
+}
+
+// CPU time consumed by the calling thread, in nanoseconds
+inline int64_t threadCpuNanoseconds()
+{
+    timespec now{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1'000'000'000 + now.tv_nsec;
+}
+
+/**
+ * @struct BenchmarkResult
+ * @brief Everything measured for one section: one algorithm with one heap.
+ */
+struct BenchmarkResult
+{
+    std::string name{};                        ///< Title of the section.
+    std::string algorithm{};                   ///< Algorithm key, as selected with --algorithms.
+    std::string heap{};                        ///< Heap key, as selected with --heaps.
+    int vertices = 0;                          ///< Vertices of the graph the queries ran on.
+    int arcs = 0;                              ///< Arcs of the graph the queries ran on.
+    int threads = 1;                           ///< Worker threads per batch.
+    std::vector<int> distances{};              ///< Answer to every query, in input order.
+    std::vector<int64_t> wallNanoseconds{};    ///< Wall-clock time of every query in every measured run.
+    std::vector<int64_t> cpuNanoseconds{};     ///< CPU time of every query in every measured run.
+    std::vector<int64_t> runNanoseconds{};     ///< Wall-clock time of every measured run of the whole batch.
+    std::vector<OperationCounts> operations{}; ///< Operations of every query in the last run, in input order; empty unless counted.
+    std::vector<PerfSample> counters{};        ///< Hardware counters of every query in the last run, in input order; empty unless measured.
+
+    // Summed per-query wall-clock time, averaged over the runs, in microseconds
+    double totalMicroseconds() const
+    {
+        double sum = static_cast<double>(std::accumulate(wallNanoseconds.begin(), wallNanoseconds.end(), int64_t{0}));
+        return runNanoseconds.empty() ? 0.0 : sum / 1e3 / static_cast<double>(runNanoseconds.size());
+    }
+
+    // Wall-clock time of one run of the batch, averaged over the runs, in microseconds
+    double wallMicroseconds() const
+    {
+        double sum = static_cast<double>(std::accumulate(runNanoseconds.begin(), runNanoseconds.end(), int64_t{0}));
+        return runNanoseconds.empty() ? 0.0 : sum / 1e3 / static_cast<double>(runNanoseconds.size());
+    }
+
+    double queriesPerSecond() const
+    {
+        double wall = wallMicroseconds();
+        return wall > 0.0 ? static_cast<double>(distances.size()) * 1e6 / wall : 0.0;
+    }
+
+    // Mean of one operation count over the queries; 0 if nothing was counted
+    double meanOperations(int64_t OperationCounts::*field) const
+    {
+        int64_t sum = 0;
+        for (const OperationCounts &counts : operations)
+        {
+            sum += counts.*field;
+        }
+        return operations.empty() ? 0.0 : static_cast<double>(sum) / static_cast<double>(operations.size());
+    }
+
+    // Mean of one hardware counter over the queries where it could be read
+    std::optional<double> meanCounter(size_t event) const
+    {
+        int64_t sum = 0;
+        int64_t samples = 0;
+        for (const PerfSample &sample : counters)
+        {
+            if (sample.values[event] >= 0)
+            {
+                sum += sample.values[event];
+                samples++;
+            }
+        }
+        if (samples == 0)
+        {
+            return std::nullopt;
+        }
+        return static_cast<double>(sum) / static_cast<double>(samples);
+    }
+};
+
+/**
+ * @brief Runs a batch of queries as often as the options say and times every query.
+ *
+ * Each thread creates its own Workspace on first use and keeps it for all
+ * runs, so warmup runs also warm the workspaces. Operation counts are taken
+ * from the workspace after every query, outside the timed interval. Hardware
+ * counters are opened on every worker thread of every run, since they count
+ * the thread that opens them, and read just outside the timed interval.
+ *
+ * @tparam Workspace The per-thread state of the searches, constructible from the vertex count.
+ * @tparam Search A callable int(int start, int destination, Workspace &) answering one query.
+ *
+ * @param vertexCount The number of vertices, passed to the workspaces.
+ * @param queries The queries, in the IDs search expects.
+ * @param options Threads, warmup, repetitions and shuffling.
+ * @param search The search to time.
+ *
+ * @return The measurements, with name, algorithm, heap and arcs left empty.
+ * @throws std::invalid_argument If the options ask for less than one thread or repetition.
+ */
+template <class Workspace, class Search>
+BenchmarkResult runBenchmark(int vertexCount, const std::vector<std::pair<int, int>> &queries, const BenchmarkOptions &options, Search search)
+{
+    if (options.threads < 1 || options.repetitions < 1 || options.warmup < 0)
+    {
+        throw std::invalid_argument("A benchmark needs at least one thread and one repetition");
+    }
+
+    BenchmarkResult result;
+    result.threads = options.threads;
+    result.vertices = vertexCount;
+    result.distances.assign(queries.size(), INF);
+    std::vector<int64_t> wall(queries.size());
+    std::vector<int64_t> cpu(queries.size());
+    std::vector<OperationCounts> operations(queries.size());
+    std::vector<char> counted(queries.size(), 0);
+    std::vector<PerfSample> samples(options.perfCounters ? queries.size() : 0);
+    std::vector<std::unique_ptr<PerfCounters>> perf(static_cast<size_t>(options.threads));
+    std::vector<std::unique_ptr<Workspace>> workspaces(static_cast<size_t>(options.threads));
+    std::vector<size_t> order(queries.size());
+    std::mt19937 random(options.seed);
+
+    for (int run = 0; run < options.warmup + options.repetitions; run++)
+    {
+        std::iota(order.begin(), order.end(), size_t{0});
+        if (options.shuffle)
+        {
+            std::shuffle(order.begin(), order.end(), random);
+        }
+
+        // The worker threads are new in every run
+        for (auto &threadCounters : perf)
+        {
+            threadCounters.reset();
+        }
+
+        auto runStart = std::chrono::steady_clock::now();
+        parallelForStealing(options.threads, static_cast<long long>(queries.size()), [&](int thread, long long position)
+                            {
+            auto &workspace = workspaces[static_cast<size_t>(thread)];
+            if (!workspace)
+            {
+                workspace = std::make_unique<Workspace>(vertexCount);
+            }
+            auto &threadCounters = perf[static_cast<size_t>(thread)];
+            if (options.perfCounters && !threadCounters)
+            {
+                threadCounters = std::make_unique<PerfCounters>();
+            }
+            size_t i = order[static_cast<size_t>(position)];
+            PerfSample before = threadCounters ? threadCounters->read() : PerfSample();
+            int64_t cpuStart = threadCpuNanoseconds();
+            auto start = std::chrono::steady_clock::now();
+            result.distances[i] = search(queries[i].first, queries[i].second, *workspace);
+            auto end = std::chrono::steady_clock::now();
+            cpu[i] = threadCpuNanoseconds() - cpuStart;
+            if (threadCounters)
+            {
+                samples[i] = threadCounters->read().since(before);
+            }
+            wall[i] = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+            counted[i] = takeOperationCounts(*workspace, operations[i]) ? 1 : 0; });
+        auto runEnd = std::chrono::steady_clock::now();
+
+        if (run >= options.warmup)
+        {
+            result.runNanoseconds.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(runEnd - runStart).count());
+            result.wallNanoseconds.insert(result.wallNanoseconds.end(), wall.begin(), wall.end());
+            result.cpuNanoseconds.insert(result.cpuNanoseconds.end(), cpu.begin(), cpu.end());
+        }
+    }
+
+    // The counts of the last run are kept, provided the workspaces count at all
+    if (!queries.empty() && std::find(counted.begin(), counted.end(), 0) == counted.end())
+    {
+        result.operations = std::move(operations);
+    }
+    result.counters = std::move(samples);
+    return result;
+}
+
+/**
+ * @class BenchmarkReport
+ * @brief Prints benchmark results in one of the report formats as they arrive.
+ *
+ * Text reports print every section completely; JSON and CSV reports print one
+ * record per section, and finish() closes the JSON document. Lines end in '\n'
+ * and the stream is flushed once per section, after its timing is done.
+ * A size sweep prints one report over several graphs and query batches.
+ */
+class BenchmarkReport
+{
+public:
+    /**
+     * @param out The stream to print to.
+     * @param format The report format.
+     * @param queries The queries in the IDs of the input files, printed with the text report.
+     * @param options The options the sections ran with, recorded in the JSON report.
+     */
+    BenchmarkReport(std::ostream &out, ReportFormat format, const std::vector<std::pair<int, int>> &queries, const BenchmarkOptions &options)
+        : out(out), format(format), queries(&queries), options(options), sections(0)
+    {
+    }
+
+    BenchmarkReport(const BenchmarkReport &) = delete;
+    BenchmarkReport &operator=(const BenchmarkReport &) = delete;
+
+    /**
+     * @brief Prints the results of one section.
+     */
+    void add(const BenchmarkResult &result);
+
+    /**
+     * @brief Completes the report after the last section.
+     */
+    void finish();
+
+    /**
+     * @brief Switches to another query batch, printed with the sections added from now on.
+     */
+    void setQueries(const std::vector<std::pair<int, int>> &batch)
+    {
+        queries = &batch;
+    }
+
+private:
+    std::ostream &out;
+    ReportFormat format;
+    const std::vector<std::pair<int, int>> *queries;
+    BenchmarkOptions options;
+    int sections; ///< Sections printed so far.
+
+    void addText(const BenchmarkResult &result, const LatencySummary &wall, const LatencySummary &cpu);
+    void addJson(const BenchmarkResult &result, const LatencySummary &wall, const LatencySummary &cpu);
+    void addCsv(const BenchmarkResult &result, const LatencySummary &wall, const LatencySummary &cpu);
+
+    // Print a string as a quoted JSON or CSV field
+    static void quoted(std::ostream &out, const std::string &text, bool json);
+};
+
+inline void BenchmarkReport::quoted(std::ostream &out, const std::string &text, bool json)
+{
+    out << '"';
+    for (char c : text)
+    {
+        if (c == '"')
+        {
+            out << (json ? "\\\"" : "\"\"");
+        }
+        else if (c == '\\' && json)
+        {
+            out << "\\\\";
+        }
+        else
+        {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+inline void BenchmarkReport::add(const BenchmarkResult &result)
+{
+    LatencySummary wall = summarizeLatencies(result.wallNanoseconds);
+    LatencySummary cpu = summarizeLatencies(result.cpuNanoseconds);
+    switch (format)
+    {
+    case ReportFormat::Text:
+        addText(result, wall, cpu);
+        break;
+    case ReportFormat::Json:
+        addJson(result, wall, cpu);
+        break;
+    case ReportFormat::Csv:
+        addCsv(result, wall, cpu);
+        break;
+    }
+    sections++;
+    out.flush();
+}
+
+inline void BenchmarkReport::addText(const BenchmarkResult &result, const LatencySummary &wall, const LatencySummary &cpu)
+{
+    out << result.name << ":\n";
+    for (size_t i = 0; i < queries->size(); i++)
+    {
+        out << "Shortest distance from vertex " << (*queries)[i].first + 1 << " to vertex " << (*queries)[i].second + 1 << ": ";
+        if (result.distances[i] == INF)
+        {
+            out << "INF\n";
+        }
+        else
+        {
+            out << result.distances[i] << '\n';
+        }
+    }
+    out << "Total time: " << static_cast<int64_t>(result.totalMicroseconds()) << " microseconds\n";
+    out << "Wall time: " << static_cast<int64_t>(result.wallMicroseconds()) << " microseconds on " << result.threads << " threads, "
+        << result.queriesPerSecond() << " queries/sec\n";
+    out << "Latency (microseconds, " << result.wallNanoseconds.size() << " samples): p50 " << wall.p50 << ", p90 " << wall.p90
+        << ", p99 " << wall.p99 << ", max " << wall.max << "; CPU p50 " << cpu.p50 << ", p90 " << cpu.p90 << ", p99 " << cpu.p99
+        << ", max " << cpu.max << '\n';
+    if (!result.operations.empty())
+    {
+        out << "Operations (mean per query):";
+        for (size_t f = 0; f < std::size(OPERATION_FIELDS); f++)
+        {
+            std::string label = OPERATION_FIELDS[f].first;
+            std::replace(label.begin(), label.end(), '_', ' ');
+            out << (f > 0 ? ", " : " ") << label << ' ' << result.meanOperations(OPERATION_FIELDS[f].second);
+        }
+        out << '\n';
+    }
+    if (!result.counters.empty())
+    {
+        out << "Hardware counters (mean per query):";
+        for (size_t e = 0; e < PERF_EVENTS; e++)
+        {
+            std::string label = PERF_EVENT_NAMES[e];
+            std::replace(label.begin(), label.end(), '_', ' ');
+            out << (e > 0 ? ", " : " ") << label << ' ';
+            if (std::optional<double> mean = result.meanCounter(e))
+            {
+                out << *mean;
+            }
+            else
+            {
+                out << "n/a";
+            }
+        }
+        std::optional<double> cycles = result.meanCounter(0);
+        std::optional<double> instructions = result.meanCounter(1);
+        if (cycles && instructions && *cycles > 0.0)
+        {
+            out << "; IPC " << *instructions / *cycles;
+        }
+        out << '\n';
+    }
+}
+
+inline void BenchmarkReport::addJson(const BenchmarkResult &result, const LatencySummary &wall, const LatencySummary &cpu)
+{
+    if (sections == 0)
+    {
+        out << "{\"threads\": " << options.threads << ", \"warmup\": " << options.warmup << ", \"repetitions\": " << options.repetitions
+            << ", \"shuffle\": " << (options.shuffle ? "true" : "false") << ", \"seed\": " << options.seed << ", \"queries\": " << queries->size()
+            << ",\n \"sections\": [\n";
+    }
+    else
+    {
+        out << ",\n";
+    }
+
+    auto summary = [&](const LatencySummary &s)
+    {
+        out << "{\"p50\": " << s.p50 << ", \"p90\": " << s.p90 << ", \"p99\": " << s.p99 << ", \"max\": " << s.max << "}";
+    };
+    out << "  {\"name\": ";
+    quoted(out, result.name, true);
+    out << ", \"algorithm\": ";
+    quoted(out, result.algorithm, true);
+    out << ", \"heap\": ";
+    quoted(out, result.heap, true);
+    out << ", \"vertices\": " << result.vertices << ", \"arcs\": " << result.arcs << ", \"total_us\": " << result.totalMicroseconds() << ", \"wall_us\": " << result.wallMicroseconds()
+        << ", \"queries_per_second\": " << result.queriesPerSecond() << ",\n   \"latency_us\": ";
+    summary(wall);
+    out << ", \"cpu_us\": ";
+    summary(cpu);
+    out << ",\n   \"distances\": [";
+    for (size_t i = 0; i < result.distances.size(); i++)
+    {
+        out << (i > 0 ? ", " : "");
+        if (result.distances[i] == INF)
+        {
+            out << "null";
+        }
+        else
+        {
+            out << result.distances[i];
+        }
+    }
+    out << ']';
+    if (!result.operations.empty())
+    {
+        out << ",\n   \"operations\": [";
+        for (size_t i = 0; i < result.operations.size(); i++)
+        {
+            out << (i > 0 ? ", " : "") << '{';
+            for (size_t f = 0; f < std::size(OPERATION_FIELDS); f++)
+            {
+                out << (f > 0 ? ", " : "") << '"' << OPERATION_FIELDS[f].first << "\": " << result.operations[i].*OPERATION_FIELDS[f].second;
+            }
+            out << '}';
+        }
+        out << ']';
+    }
+    if (!result.counters.empty())
+    {
+        out << ",\n   \"counters\": [";
+        for (size_t i = 0; i < result.counters.size(); i++)
+        {
+            out << (i > 0 ? ", " : "") << '{';
+            for (size_t e = 0; e < PERF_EVENTS; e++)
+            {
+                out << (e > 0 ? ", " : "") << '"' << PERF_EVENT_NAMES[e] << "\": ";
+                if (result.counters[i].values[e] >= 0)
+                {
+                    out << result.counters[i].values[e];
+                }
+                else
+                {
+                    out << "null";
+                }
+            }
+            out << '}';
+        }
+        out << ']';
+    }
+    out << '}';
+}
+
+inline void BenchmarkReport::addCsv(const BenchmarkResult &result, const LatencySummary &wall, const LatencySummary &cpu)
+{
+    if (sections == 0)
+    {
+        out << "name,algorithm,heap,vertices,arcs,queries,threads,repetitions,total_us,wall_us,queries_per_second,"
+               "p50_us,p90_us,p99_us,max_us,cpu_p50_us,cpu_p90_us,cpu_p99_us,cpu_max_us";
+        for (const auto &[field, member] : OPERATION_FIELDS)
+        {
+            out << ",mean_" << field;
+        }
+        for (const char *event : PERF_EVENT_NAMES)
+        {
+            out << ",mean_" << event;
+        }
+        out << '\n';
+    }
+    quoted(out, result.name, false);
+    out << ',';
+    quoted(out, result.algorithm, false);
+    out << ',';
+    quoted(out, result.heap, false);
+    out << ',' << result.vertices << ',' << result.arcs << ',' << result.distances.size() << ',' << result.threads << ',' << result.runNanoseconds.size() << ','
+        << result.totalMicroseconds() << ',' << result.wallMicroseconds() << ',' << result.queriesPerSecond() << ','
+        << wall.p50 << ',' << wall.p90 << ',' << wall.p99 << ',' << wall.max << ','
+        << cpu.p50 << ',' << cpu.p90 << ',' << cpu.p99 << ',' << cpu.max;
+    // The operation and counter columns stay empty for sections that did not measure them
+    for (const auto &[field, member] : OPERATION_FIELDS)
+    {
+        out << ',';
+        if (!result.operations.empty())
+        {
+            out << result.meanOperations(member);
+        }
+    }
+    for (size_t e = 0; e < PERF_EVENTS; e++)
+    {
+        out << ',';
+        if (std::optional<double> mean = result.meanCounter(e))
+        {
+            out << *mean;
+        }
+    }
+    out << '\n';
+}
+
+inline void BenchmarkReport::finish()
+{
+    if (format == ReportFormat::Json)
+    {
+        out << (sections == 0 ? "{\"sections\": [" : "\n ") << "]}\n";
+    }
+    out.flush();
+}
@@ -1,6 +1,9 @@
+#pragma once
+
 #include "heap.hpp"
+#include "stats.hpp"
 
-template <typename T>
+template <typename T, typename Stats = NoStats>
 /**
  * @class BinaryHeap
  * @brief A binary heap implementation of a heap data structure.
@@ -10,35 +13,51 @@ template <typename T>
  * the Heap<T> interface.
  * 
  * @tparam T The type of elements stored in the heap.
+ * @tparam Stats The operation counting policy; see stats.hpp.
  */
 class BinaryHeap : public Heap<T>
 {
 public:
-    BinaryHeap() : data() {}
+    BinaryHeap() : data(), counters() {}
     void push(const T &value) override;
     T pop() override;
     bool empty() const override;
+    void clear() override;
+
+    // The smallest element, without removing it; the heap must not be empty
+    const T &top() const
+    {
+        return data.front();
+    }
+
+    Stats &stats()
+    {
+        return counters;
+    }
 
 private:
     std::vector<T> data;
+    [[no_unique_address]] Stats counters;
     void heapifyUp(int index);
     void heapifyDown(int index);
 };
 
-template <typename T>
-void BinaryHeap<T>::push(const T &value)
+template <typename T, typename Stats>
+void BinaryHeap<T, Stats>::push(const T &value)
 {
+    counters.push();
     data.push_back(value);
     heapifyUp(static_cast<int>(data.size() - 1));
 }
 
-template <typename T>
-T BinaryHeap<T>::pop()
+template <typename T, typename Stats>
+T BinaryHeap<T, Stats>::pop()
 {
     if (empty())
     {
         throw std::runtime_error("Heap is empty");
     }
+    counters.pop();
     T minValue = data.front();
     data.front() = data.back();
     data.pop_back();
@@ -49,14 +68,21 @@ T BinaryHeap<T>::pop()
     return minValue;
 }
 
-template <typename T>
-bool BinaryHeap<T>::empty() const
+template <typename T, typename Stats>
+bool BinaryHeap<T, Stats>::empty() const
 {
     return data.empty();
 }
 
-template <typename T>
-void BinaryHeap<T>::heapifyUp(int index)
+template <typename T, typename Stats>
+void BinaryHeap<T, Stats>::clear()
+{
+    counters.clear();
+    data.clear();
+}
+
+template <typename T, typename Stats>
+void BinaryHeap<T, Stats>::heapifyUp(int index)
 {
     while (index > 0)
     {
@@ -70,8 +96,8 @@ void BinaryHeap<T>::heapifyUp(int index)
     }
 }
 
-template <typename T>
-void BinaryHeap<T>::heapifyDown(int index)
+template <typename T, typename Stats>
+void BinaryHeap<T, Stats>::heapifyDown(int index)
 {
     auto size = static_cast<int>(data.size());
     while (index < size)
@@ -0,0 +1,738 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "daryheap.hpp"
+#include "graph.hpp"
+#include "graphcache.hpp"
+#include "mappedfile.hpp"
+#include "parallel.hpp"
+#include "pathfinder.hpp"
+
+/**
+ * @file contractionhierarchy.hpp
+ * @brief Contraction Hierarchies (Geisberger, Sanders, Schultes and Delling).
+ *
+ * Preprocessing contracts the vertices one after another in order of importance.
+ * Removing a vertex v inserts a shortcut u -> x of weight w(u, v) + w(v, x) for
+ * every pair of neighbours whose shortest path ran through v, unless a witness
+ * search finds a path of at most that length around v. The rank of a vertex is
+ * its position in the contraction order, and every arc of the hierarchy, original
+ * or shortcut, leads from a vertex to a vertex of higher rank or comes from one.
+ *
+ * Every shortest path then has a version that first climbs and then descends in
+ * rank, so a query runs two searches that only go upwards: forward from the start
+ * over the upward arcs, and backward from the destination over the downward arcs.
+ * On road networks these searches settle a few hundred vertices each instead of
+ * millions.
+ *
+ * Vertices are contracted in rounds of independent sets: vertices whose priority
+ * is lower than that of all their neighbours. Vertices of one set share no arc,
+ * so their shortcuts only connect vertices that stay, and the contractions run
+ * in parallel. A witness that passes through another vertex of the same set
+ * only counts if it is strictly shorter than the path through v; two vertices
+ * can then never rely on each other's path and both drop a needed shortcut.
+ *
+ * Priorities are updated lazily. The priority of a vertex is its edge
+ * difference (shortcuts added minus arcs removed) plus its number of
+ * contracted neighbours and its depth in the hierarchy. The last two are kept
+ * current as neighbours are contracted, but the edge difference needs witness
+ * searches, so it is only recomputed when the vertex is about to be contracted.
+ * A vertex whose fresh priority no longer beats its neighbours waits for a later
+ * round; otherwise the shortcuts found along the way are inserted.
+ *
+ * Hierarchy file layout (all integers in the byte order of the writer; every
+ * array starts on a 64-byte boundary, in this order):
+ *
+ *     ContractionHierarchyHeader               64 bytes
+ *     ranks[vertexCount]
+ *     upward offsets, targets, weights         CSR of the upward graph
+ *     downward offsets, targets, weights       CSR of the downward graph
+ */
+
+// Witness searches give up after settling this many vertices and insert the shortcut instead
+inline constexpr int CH_WITNESS_SETTLE_LIMIT = 2000;
+
+/**
+ * @class ContractionHierarchy
+ * @brief The contraction order of a graph and its upward and downward search graphs.
+ *
+ * The upward graph holds every arc u -> v of the augmented graph with
+ * rank(u) < rank(v). The downward graph holds every arc u -> v with
+ * rank(u) > rank(v) reversed, as v -> u, so the backward search also walks
+ * upwards. Vertex numbers are those of the original graph.
+ */
+class ContractionHierarchy
+{
+public:
+    /**
+     * @brief Constructs an empty hierarchy without vertices.
+     */
+    ContractionHierarchy() : storage(), ranks(), upwardGraph(), downwardGraph() {}
+
+    /**
+     * @brief Assembles a hierarchy from its parts.
+     *
+     * @param storage The object that owns the memory ranks points into.
+     * @param ranks The position of every vertex in the contraction order.
+     * @param upward The upward graph.
+     * @param downward The reversed downward graph.
+     */
+    ContractionHierarchy(std::shared_ptr<const void> storage, std::span<const int> ranks, Graph upward, Graph downward)
+        : storage(std::move(storage)), ranks(ranks), upwardGraph(std::move(upward)), downwardGraph(std::move(downward))
+    {
+    }
+
+    int vertexCount() const
+    {
+        return static_cast<int>(ranks.size());
+    }
+
+    /**
+     * @brief Returns the position of vertex v in the contraction order.
+     */
+    int rank(int v) const
+    {
+        return ranks[v];
+    }
+
+    /**
+     * @brief Returns the arcs to higher-ranked vertices, searched forward from the start.
+     */
+    const Graph &upward() const
+    {
+        return upwardGraph;
+    }
+
+    /**
+     * @brief Returns the reversed arcs from higher-ranked vertices, searched backward from the destination.
+     */
+    const Graph &downward() const
+    {
+        return downwardGraph;
+    }
+
+    /**
+     * @brief Raw access to the ranks, used when serializing the hierarchy.
+     */
+    std::span<const int> rankArray() const { return ranks; }
+
+private:
+    std::shared_ptr<const void> storage; ///< Keeps the memory behind ranks alive.
+    std::span<const int> ranks;          ///< Contraction order position per vertex.
+    Graph upwardGraph;                   ///< Arcs u -> v with rank(u) < rank(v).
+    Graph downwardGraph;                 ///< Arcs u -> v with rank(u) > rank(v), stored as v -> u.
+};
+
+/**
+ * @class ContractionHierarchyBuilder
+ * @brief Contracts a graph in parallel rounds of independent vertex sets.
+ *
+ * The remaining graph is kept as adjacency vectors in both directions, which
+ * witness searches read concurrently; they are only modified between the
+ * parallel phases.
+ */
+class ContractionHierarchyBuilder
+{
+public:
+    /**
+     * @param graph The graph to contract.
+     * @param threads The number of threads for the witness searches.
+     */
+    ContractionHierarchyBuilder(const Graph &graph, int threads);
+
+    /**
+     * @brief Contracts every vertex and returns the hierarchy.
+     */
+    ContractionHierarchy build();
+
+private:
+    /**
+     * @struct Edge
+     * @brief An arc of the remaining graph, stored at one of its endpoints.
+     */
+    struct Edge
+    {
+        int vertex; ///< The other endpoint.
+        int weight; ///< The weight of the arc.
+    };
+
+    /**
+     * @struct WitnessSearch
+     * @brief The scratch state of the witness searches of one thread.
+     */
+    struct WitnessSearch
+    {
+        QueryWorkspace<DaryHeap<NearestRecord, 4>> workspace; ///< Distances and heap of the search.
+        std::vector<char> viaBatch;                            ///< Whether the path found to a vertex passes the current set.
+        std::vector<char> isTarget;                            ///< Out-neighbours of the vertex being contracted.
+
+        explicit WitnessSearch(int n) : workspace(n), viaBatch(static_cast<size_t>(n)), isTarget(static_cast<size_t>(n)) {}
+    };
+
+    int n;                                     ///< The number of vertices.
+    int threads;                               ///< The number of worker threads.
+    std::vector<std::vector<Edge>> out;        ///< Arcs leaving each remaining vertex.
+    std::vector<std::vector<Edge>> in;         ///< Arcs entering each remaining vertex.
+    std::vector<int> edgeDifference;           ///< Shortcuts minus removed arcs, as of the last witness searches.
+    std::vector<int> contractedNeighbours;     ///< Number of contracted neighbours per vertex.
+    std::vector<int> depth;                    ///< Upper bound on the number of hierarchy levels below each vertex.
+    std::vector<char> inBatch;                 ///< Candidates of the current round.
+    std::vector<std::unique_ptr<WitnessSearch>> searches; ///< Witness search state per thread.
+
+    // The witness search state of a worker thread, created by that thread
+    WitnessSearch &search(int thread)
+    {
+        auto &slot = searches[static_cast<size_t>(thread)];
+        if (!slot)
+        {
+            slot = std::make_unique<WitnessSearch>(n);
+        }
+        return *slot;
+    }
+
+    // Insert an arc, or lower the weight of an existing arc to the same vertex
+    static void addOrLower(std::vector<Edge> &edges, int vertex, int weight)
+    {
+        for (Edge &edge : edges)
+        {
+            if (edge.vertex == vertex)
+            {
+                edge.weight = std::min(edge.weight, weight);
+                return;
+            }
+        }
+        edges.push_back({vertex, weight});
+    }
+
+    static void removeEdge(std::vector<Edge> &edges, int vertex)
+    {
+        auto it = std::find_if(edges.begin(), edges.end(), [vertex](const Edge &edge)
+                               { return edge.vertex == vertex; });
+        if (it != edges.end())
+        {
+            *it = edges.back();
+            edges.pop_back();
+        }
+    }
+
+    // Pseudo-random tie-breaker, so that equal priorities do not contract in id order one per round
+    static uint32_t scramble(int v)
+    {
+        return static_cast<uint32_t>(v) * 0x9E3779B1u;
+    }
+
+    // Contraction priority; lower is contracted first
+    int priority(int v) const
+    {
+        return 2 * edgeDifference[v] + contractedNeighbours[v] + depth[v];
+    }
+
+    // Whether v is contracted before w
+    bool precedes(int v, int w) const
+    {
+        int pv = priority(v);
+        int pw = priority(w);
+        return pv != pw ? pv < pw : scramble(v) < scramble(w);
+    }
+
+    bool isLocalMinimum(int v) const
+    {
+        for (const Edge &edge : out[v])
+        {
+            if (precedes(edge.vertex, v))
+                return false;
+        }
+        for (const Edge &edge : in[v])
+        {
+            if (precedes(edge.vertex, v))
+                return false;
+        }
+        return true;
+    }
+
+    void findShortcuts(int v, WitnessSearch &witness, std::vector<Arc> &shortcuts) const;
+
+    // Find the shortcuts of the given vertices in parallel and refresh their edge differences
+    void simulate(const std::vector<int> &vertices, std::vector<std::vector<Arc>> &shortcuts)
+    {
+        shortcuts.resize(std::max(shortcuts.size(), vertices.size()));
+        parallelForStealing(threads, static_cast<long long>(vertices.size()), [&](int thread, long long i)
+                            {
+            auto index = static_cast<size_t>(i);
+            int v = vertices[index];
+            findShortcuts(v, search(thread), shortcuts[index]);
+            edgeDifference[v] = static_cast<int>(shortcuts[index].size()) - static_cast<int>(in[v].size() + out[v].size()); });
+    }
+};
+
+inline ContractionHierarchyBuilder::ContractionHierarchyBuilder(const Graph &graph, int threads)
+    : n(graph.vertexCount()), threads(std::max(1, threads)), out(static_cast<size_t>(n)), in(static_cast<size_t>(n)),
+      edgeDifference(static_cast<size_t>(n)), contractedNeighbours(static_cast<size_t>(n)), depth(static_cast<size_t>(n)),
+      inBatch(static_cast<size_t>(n)), searches(static_cast<size_t>(this->threads))
+{
+    // Parallel arcs collapse to the lightest one; loops never lie on a shortest path
+    for (int u = 0; u < n; u++)
+    {
+        for (int e = graph.beginArc(u), last = graph.endArc(u); e < last; e++)
+        {
+            int v = graph.target(e);
+            if (v != u)
+            {
+                addOrLower(out[u], v, graph.weight(e));
+                addOrLower(in[v], u, graph.weight(e));
+            }
+        }
+    }
+}
+
+inline void ContractionHierarchyBuilder::findShortcuts(int v, WitnessSearch &witness, std::vector<Arc> &shortcuts) const
+{
+    shortcuts.clear();
+    if (in[v].empty() || out[v].empty())
+    {
+        return;
+    }
+    int maxOut = 0;
+    for (const Edge &edge : out[v])
+    {
+        maxOut = std::max(maxOut, edge.weight);
+        witness.isTarget[edge.vertex] = 1;
+    }
+    auto targetCount = static_cast<int>(out[v].size());
+
+    for (const Edge &incoming : in[v])
+    {
+        int u = incoming.vertex;
+        int limit = incoming.weight + maxOut; // no shortcut from u is longer than this
+
+        // Dijkstra from u around v, stopped at the limit or after enough settled vertices;
+        // among equally short paths, one that avoids the current set is preferred
+        QueryWorkspace<DaryHeap<NearestRecord, 4>> &search = witness.workspace;
+        search.reset(n);
+        search.setDistance(u, 0);
+        witness.viaBatch[u] = 0;
+        auto &pq = search.queue();
+        pq.push({0, u});
+        int settled = 0;
+        int targetsLeft = targetCount - witness.isTarget[u];
+        while (!pq.empty() && targetsLeft > 0)
+        {
+            auto [dist, x] = pq.pop();
+            if (dist > search.distance(x))
+                continue;
+            if (dist > limit || ++settled > CH_WITNESS_SETTLE_LIMIT)
+                break;
+            targetsLeft -= witness.isTarget[x];
+
+            for (const Edge &edge : out[x])
+            {
+                int y = edge.vertex;
+                int candidate = dist + edge.weight;
+                if (y == v || candidate > limit)
+                    continue;
+                char viaBatch = witness.viaBatch[x] || inBatch[y];
+                if (candidate < search.distance(y))
+                {
+                    search.setDistance(y, candidate);
+                    witness.viaBatch[y] = viaBatch;
+                    pq.push({candidate, y});
+                }
+                else if (candidate == search.distance(y) && !viaBatch)
+                {
+                    witness.viaBatch[y] = 0;
+                }
+            }
+        }
+
+        for (const Edge &outgoing : out[v])
+        {
+            int x = outgoing.vertex;
+            int via = incoming.weight + outgoing.weight;
+            int witnessLength = search.distance(x);
+            bool witnessed = witnessLength < via || (witnessLength == via && !witness.viaBatch[x]);
+            if (x != u && !witnessed)
+            {
+                shortcuts.push_back({u, x, via});
+            }
+        }
+    }
+
+    for (const Edge &edge : out[v])
+    {
+        witness.isTarget[edge.vertex] = 0;
+    }
+}
+
+inline ContractionHierarchy ContractionHierarchyBuilder::build()
+{
+    std::vector<int> remaining(static_cast<size_t>(n));
+    for (int v = 0; v < n; v++)
+    {
+        remaining[v] = v;
+    }
+    std::vector<std::vector<Arc>> shortcuts;
+    simulate(remaining, shortcuts);
+
+    auto ranks = std::make_shared<std::vector<int>>(static_cast<size_t>(n), -1);
+    std::vector<Arc> upwardArcs;
+    std::vector<Arc> downwardArcs;
+    std::vector<int> candidates;
+    int nextRank = 0;
+
+    // A neighbour of a contracted vertex moves one level up
+    auto touch = [&](int x, int v)
+    {
+        contractedNeighbours[x]++;
+        depth[x] = std::max(depth[x], depth[v] + 1);
+    };
+
+    while (!remaining.empty())
+    {
+        candidates.clear();
+        for (int v : remaining)
+        {
+            if (isLocalMinimum(v))
+            {
+                candidates.push_back(v);
+            }
+        }
+        for (int v : candidates)
+        {
+            inBatch[v] = 1;
+        }
+
+        // Candidates are independent, so their neighbours' priorities do not change during the round;
+        // a candidate whose fresh priority still wins is contracted. Once every priority in a
+        // neighbourhood is fresh, its minimum wins, so the loop always makes progress.
+        simulate(candidates, shortcuts);
+        for (size_t i = 0; i < candidates.size(); i++)
+        {
+            int v = candidates[i];
+            if (!isLocalMinimum(v))
+            {
+                continue;
+            }
+
+            (*ranks)[v] = nextRank++;
+            for (const Edge &edge : out[v])
+            {
+                upwardArcs.push_back({v, edge.vertex, edge.weight});
+                removeEdge(in[edge.vertex], v);
+                touch(edge.vertex, v);
+            }
+            for (const Edge &edge : in[v])
+            {
+                downwardArcs.push_back({v, edge.vertex, edge.weight});
+                removeEdge(out[edge.vertex], v);
+                touch(edge.vertex, v);
+            }
+            for (const Arc &shortcut : shortcuts[i])
+            {
+                addOrLower(out[shortcut.from], shortcut.to, shortcut.weight);
+                addOrLower(in[shortcut.to], shortcut.from, shortcut.weight);
+            }
+            std::vector<Edge>().swap(out[v]);
+            std::vector<Edge>().swap(in[v]);
+        }
+        for (int v : candidates)
+        {
+            inBatch[v] = 0;
+        }
+
+        std::erase_if(remaining, [&](int v)
+                      { return (*ranks)[v] >= 0; });
+    }
+
+    std::span<const int> rankSpan = *ranks;
+    return ContractionHierarchy(std::move(ranks), rankSpan, Graph(n, upwardArcs), Graph(n, downwardArcs));
+}
+
+/**
+ * @brief Builds the contraction hierarchy of a graph.
+ *
+ * @param graph The graph.
+ * @param threads The number of threads.
+ * @return The hierarchy.
+ */
+inline ContractionHierarchy buildContractionHierarchy(const Graph &graph, int threads = defaultThreadCount())
+{
+    return ContractionHierarchyBuilder(graph, threads).build();
+}
+
+/**
+ * @brief Shortest path query on a contraction hierarchy.
+ *
+ * Two lazy-insertion Dijkstra searches, forward over the upward graph and
+ * backward over the downward graph, alternate; a side stops once it pops a key
+ * of at least the best meeting distance found so far. With stall-on-demand, a
+ * vertex that is reached more cheaply through a higher-ranked neighbour, read
+ * from the opposite graph, is not expanded: its tentative distance cannot be
+ * part of a shortest up-down path.
+ *
+ * @tparam PriorityQueue The type of priority queue used by both searches; any heap works.
+ *
+ * @param start The starting vertex.
+ * @param destination The destination vertex.
+ * @param hierarchy The contraction hierarchy of the graph.
+ * @param workspace The state of both searches, reset first.
+ *
+ * @return The shortest path length from the start vertex to the destination vertex, or INF if there is no path.
+ */
+template <typename PriorityQueue>
+int ch_query(int start, int destination, const ContractionHierarchy &hierarchy, BidirectionalWorkspace<PriorityQueue> &workspace)
+{
+    QueryWorkspace<PriorityQueue> *sides[2] = {&workspace.forward, &workspace.backward};
+    const Graph *graphs[2] = {&hierarchy.upward(), &hierarchy.downward()};
+    int sources[2] = {start, destination};
+    bool active[2] = {true, true};
+    for (int side = 0; side < 2; side++)
+    {
+        sides[side]->reset(hierarchy.vertexCount());
+        sides[side]->setDistance(sources[side], 0);
+        sides[side]->queue().push({0, sources[side]});
+    }
+
+    int best = INF;
+    int side = 0;
+    while (active[0] || active[1])
+    {
+        if (!active[side])
+            side = 1 - side;
+
+        QueryWorkspace<PriorityQueue> &self = *sides[side];
+        const QueryWorkspace<PriorityQueue> &other = *sides[1 - side];
+        const Graph &g = *graphs[side];
+        const Graph &opposite = *graphs[1 - side];
+        PriorityQueue &pq = self.queue();
+        auto &stats = heapStats(pq);
+
+        if (pq.empty())
+        {
+            active[side] = false;
+            continue;
+        }
+        auto [dist, u] = pq.pop();
+        if (dist > self.distance(u))
+        {
+            stats.stalePop();
+            continue;
+        }
+        if (dist >= best)
+        {
+            active[side] = false;
+            continue;
+        }
+
+        if (other.distance(u) != INF)
+            best = std::min(best, dist + other.distance(u));
+
+        // Stall-on-demand: the opposite graph lists the arcs entering u from higher-ranked vertices
+        bool stalled = false;
+        for (int e = opposite.beginArc(u), last = opposite.endArc(u); e < last && !stalled; e++)
+        {
+            int w = self.distance(opposite.target(e));
+            stalled = w != INF && w + opposite.weight(e) < dist;
+        }
+
+        if (!stalled)
+        {
+            stats.settle();
+            for (int e = g.beginArc(u), last = g.endArc(u); e < last; e++)
+            {
+                stats.relax();
+                int v = g.target(e);
+                int candidate = dist + g.weight(e);
+
+                if (candidate < self.distance(v))
+                {
+                    self.setDistance(v, candidate);
+                    pq.push({candidate, v});
+                }
+            }
+        }
+
+        side = 1 - side;
+    }
+
+    return best;
+}
+
+/**
+ * @brief Runs a hierarchy query with a workspace of its own; see the overload above.
+ */
+template <typename PriorityQueue>
+int ch_query(int start, int destination, const ContractionHierarchy &hierarchy)
+{
+    BidirectionalWorkspace<PriorityQueue> workspace(hierarchy.vertexCount());
+    return ch_query<PriorityQueue>(start, destination, hierarchy, workspace);
+}
+
+// Magic bytes at the start of every hierarchy file
+inline constexpr char CONTRACTION_HIERARCHY_MAGIC[8] = {'P', 'F', 'C', 'H', 'I', 'E', 'R', '\0'};
+
+// Format version; bump it whenever the layout changes
+inline constexpr uint32_t CONTRACTION_HIERARCHY_VERSION = 1;
+
+/**
+ * @struct ContractionHierarchyHeader
+ * @brief The fixed-size header at the start of a hierarchy file.
+ */
+struct ContractionHierarchyHeader
+{
+    char magic[8];             ///< CONTRACTION_HIERARCHY_MAGIC.
+    uint32_t version;          ///< CONTRACTION_HIERARCHY_VERSION.
+    uint32_t byteOrder;        ///< GRAPH_CACHE_BYTE_ORDER.
+    uint64_t vertexCount;      ///< Number of vertices.
+    uint64_t upwardArcCount;   ///< Number of arcs of the upward graph.
+    uint64_t downwardArcCount; ///< Number of arcs of the downward graph.
+    uint64_t checksum;         ///< graphCacheChecksum() of the seven arrays, in file order.
+    uint64_t reserved[2];      ///< Zero.
+};
+
+static_assert(sizeof(ContractionHierarchyHeader) == 64, "ContractionHierarchyHeader must stay 64 bytes");
+
+// The lengths of the seven arrays of a hierarchy file, in file order
+inline std::array<uint64_t, 7> contractionHierarchySectionSizes(const ContractionHierarchyHeader &header)
+{
+    return {header.vertexCount,
+            header.vertexCount + 1, header.upwardArcCount, header.upwardArcCount,
+            header.vertexCount + 1, header.downwardArcCount, header.downwardArcCount};
+}
+
+/**
+ * @brief Writes a contraction hierarchy to disk.
+ *
+ * @param hierarchy The hierarchy to write.
+ * @param filename The output file, which is overwritten.
+ * @throws std::runtime_error If the file cannot be written.
+ */
+inline void writeContractionHierarchy(const ContractionHierarchy &hierarchy, const std::string &filename)
+{
+    const Graph &up = hierarchy.upward();
+    const Graph &down = hierarchy.downward();
+    std::array<std::span<const int>, 7> sections = {hierarchy.rankArray(),
+                                                    up.offsetArray(), up.targetArray(), up.weightArray(),
+                                                    down.offsetArray(), down.targetArray(), down.weightArray()};
+
+    ContractionHierarchyHeader header{};
+    std::memcpy(header.magic, CONTRACTION_HIERARCHY_MAGIC, sizeof(header.magic));
+    header.version = CONTRACTION_HIERARCHY_VERSION;
+    header.byteOrder = GRAPH_CACHE_BYTE_ORDER;
+    header.vertexCount = static_cast<uint64_t>(hierarchy.vertexCount());
+    header.upwardArcCount = static_cast<uint64_t>(up.arcCount());
+    header.downwardArcCount = static_cast<uint64_t>(down.arcCount());
+    header.checksum = 0xcbf29ce484222325ULL;
+    for (std::span<const int> section : sections)
+    {
+        header.checksum = graphCacheChecksum(section, header.checksum);
+    }
+
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Error opening " + filename + " for writing");
+    }
+
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    writeAlignedSections(file, alignedSectionPositions(sizeof(header), contractionHierarchySectionSizes(header)), sections);
+
+    if (!file)
+    {
+        throw std::runtime_error("Error writing " + filename);
+    }
+}
+
+/**
+ * @brief Maps a hierarchy file and returns a hierarchy that views it without copying.
+ *
+ * The arc offsets and targets of both graphs and the ranks are always validated,
+ * as in loadGraphCache(); the checksum also covers the weights.
+ *
+ * @param filename The hierarchy file.
+ * @param verifyChecksum Whether to recompute and compare the payload checksum.
+ * @return The mapped hierarchy.
+ * @throws std::runtime_error If the file is not a valid hierarchy file.
+ */
+inline ContractionHierarchy loadContractionHierarchy(const std::string &filename, bool verifyChecksum = false)
+{
+    auto file = std::make_shared<MappedFile>(filename);
+
+    ContractionHierarchyHeader header{};
+    if (file->size() < sizeof(header))
+    {
+        throw std::runtime_error(filename + ": file too small for a hierarchy header");
+    }
+    std::memcpy(&header, file->data(), sizeof(header));
+
+    if (std::memcmp(header.magic, CONTRACTION_HIERARCHY_MAGIC, sizeof(header.magic)) != 0)
+    {
+        throw std::runtime_error(filename + ": not a contraction hierarchy file");
+    }
+    if (header.byteOrder != GRAPH_CACHE_BYTE_ORDER)
+    {
+        throw std::runtime_error(filename + ": hierarchy was written with a different byte order");
+    }
+    if (header.version != CONTRACTION_HIERARCHY_VERSION)
+    {
+        throw std::runtime_error(filename + ": unsupported hierarchy version " + std::to_string(header.version));
+    }
+    if (header.vertexCount >= static_cast<uint64_t>(std::numeric_limits<int>::max()) ||
+        header.upwardArcCount > static_cast<uint64_t>(std::numeric_limits<int>::max()) ||
+        header.downwardArcCount > static_cast<uint64_t>(std::numeric_limits<int>::max()))
+    {
+        throw std::runtime_error(filename + ": hierarchy too large");
+    }
+
+    std::array<uint64_t, 7> sizes = contractionHierarchySectionSizes(header);
+    std::array<std::span<const int>, 7> sections = mapAlignedSections(*file, alignedSectionPositions(sizeof(header), sizes), sizes, filename);
+    auto vertexCount = static_cast<int>(header.vertexCount);
+    for (size_t offsets : {size_t{1}, size_t{4}})
+    {
+        const std::span<const int> &arcs = sections[offsets];
+        if (arcs.front() != 0 || static_cast<uint64_t>(arcs.back()) != sizes[offsets + 1] || !std::is_sorted(arcs.begin(), arcs.end()))
+        {
+            throw std::runtime_error(filename + ": inconsistent arc offsets");
+        }
+        if (!arcTargetsInRange(sections[offsets + 1], vertexCount))
+        {
+            throw std::runtime_error(filename + ": arc target outside the graph");
+        }
+    }
+
+    // The hub label builder indexes its arrays by rank, so the ranks must be a permutation of the vertices
+    std::vector<char> ranked(header.vertexCount, 0);
+    for (int rank : sections[0])
+    {
+        if (rank < 0 || rank >= vertexCount || ranked[static_cast<size_t>(rank)])
+        {
+            throw std::runtime_error(filename + ": ranks are not a permutation of the vertices");
+        }
+        ranked[static_cast<size_t>(rank)] = 1;
+    }
+    if (verifyChecksum)
+    {
+        uint64_t checksum = 0xcbf29ce484222325ULL;
+        for (std::span<const int> section : sections)
+        {
+            checksum = graphCacheChecksum(section, checksum);
+        }
+        if (checksum != header.checksum)
+        {
+            throw std::runtime_error(filename + ": checksum mismatch");
+        }
+    }
+
+    Graph up(file, sections[1], sections[2], sections[3]);
+    Graph down(file, sections[4], sections[5], sections[6]);
+    return ContractionHierarchy(std::move(file), sections[0], std::move(up), std::move(down));
+}
@@ -0,0 +1,265 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <utility>
+
+#include "heap.hpp"
+#include "stats.hpp"
+#include "alignedallocator.hpp"
+
+#if defined(__AVX2__) || defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
+
+/**
+ * @file daryheap.hpp
+ * @brief Implementation of an implicit d-ary heap with a compile-time arity.
+ *
+ * A wider fan-out makes the tree shallower, so a pop walks fewer levels and
+ * takes fewer cache misses, at the price of comparing more children per level.
+ * The array is shifted by D - 1 slots so that the children of every node start on
+ * a multiple of D; with the 64-byte aligned storage a whole sibling group then
+ * sits in as few cache lines as possible. For elements with an int HeapKey the
+ * keys are mirrored in a separate array, and for D = 4, 8 and 16 the smallest
+ * child is found with one or two SSE/AVX2 vector minimums instead of D - 1
+ * scalar comparisons.
+ *
+ * @tparam T The type of elements stored in the heap.
+ */
+
+/**
+ * @class DaryHeap
+ * @brief A d-ary min-heap whose arity is a template parameter.
+ *
+ * @tparam T The type of elements stored in the heap.
+ * @tparam D The number of children per node.
+ * @tparam Stats The operation counting policy; see stats.hpp.
+ */
+template <typename T, int D = 4, typename Stats = NoStats>
+class DaryHeap : public Heap<T>
+{
+    static_assert(D >= 2, "A d-ary heap needs at least two children per node");
+
+public:
+    DaryHeap() : values(D - 1), keys(useKeys ? D - 1 : 0, KEY_PADDING), count(0), counters() {}
+    void push(const T &value) override;
+    T pop() override;
+    bool empty() const override;
+    void clear() override;
+
+    // The smallest element, without removing it; the heap must not be empty
+    const T &top() const
+    {
+        return values[OFFSET];
+    }
+
+    Stats &stats()
+    {
+        return counters;
+    }
+
+private:
+    // Mirror the keys in their own array when they are plain 32-bit integers
+    static constexpr bool useKeys = HeapKey<T>::enabled && std::is_same_v<decltype(HeapKey<T>::get(std::declval<T>())), int>;
+
+    // Key stored in unused slots, so a partial sibling group can be scanned as a whole
+    static constexpr int KEY_PADDING = std::numeric_limits<int>::max();
+
+    // Number of unused slots in front of the root that align every sibling group
+    static constexpr int OFFSET = D - 1;
+
+    std::vector<T, AlignedAllocator<T, 64>> values;    ///< Elements at physical index logical + OFFSET.
+    std::vector<int, AlignedAllocator<int, 64>> keys; ///< Keys of the elements (only when useKeys), padded with KEY_PADDING.
+    int count;                                        ///< The number of elements in the heap.
+    [[no_unique_address]] Stats counters;
+
+    void heapifyUp(int index, const T &value);
+    void heapifyDown(int index, const T &value);
+    int smallestChild(int first) const;
+
+    // Store a value at a logical index, keeping the key mirror in sync
+    void place(int index, const T &value)
+    {
+        values[index + OFFSET] = value;
+        if constexpr (useKeys)
+        {
+            keys[index + OFFSET] = HeapKey<T>::get(value);
+        }
+    }
+
+    // Compare two elements, using the mirrored key when available
+    static bool less(const T &a, const T &b)
+    {
+        if constexpr (useKeys)
+        {
+            return HeapKey<T>::get(a) < HeapKey<T>::get(b);
+        }
+        else
+        {
+            return a < b;
+        }
+    }
+};
+
+template <typename T, int D, typename Stats>
+void DaryHeap<T, D, Stats>::push(const T &value)
+{
+    counters.push();
+
+    // Grow to the end of the next sibling group so that every group is complete
+    if (count + OFFSET == static_cast<int>(values.size()))
+    {
+        size_t size = (values.size() / D + 1) * D;
+        values.resize(size);
+        if constexpr (useKeys)
+        {
+            keys.resize(size, KEY_PADDING);
+        }
+    }
+    heapifyUp(count++, value);
+}
+
+template <typename T, int D, typename Stats>
+T DaryHeap<T, D, Stats>::pop()
+{
+    if (empty())
+    {
+        throw std::runtime_error("Heap is empty");
+    }
+    counters.pop();
+    T minValue = values[OFFSET];
+    T last = values[count - 1 + OFFSET];
+    count--;
+    if constexpr (useKeys)
+    {
+        keys[count + OFFSET] = KEY_PADDING;
+    }
+    if (!empty())
+    {
+        heapifyDown(0, last);
+    }
+    return minValue;
+}
+
+template <typename T, int D, typename Stats>
+bool DaryHeap<T, D, Stats>::empty() const
+{
+    return count == 0;
+}
+
+template <typename T, int D, typename Stats>
+void DaryHeap<T, D, Stats>::clear()
+{
+    if constexpr (useKeys)
+    {
+        std::fill(keys.begin() + OFFSET, keys.begin() + OFFSET + count, KEY_PADDING);
+    }
+    counters.clear();
+    count = 0;
+}
+
+template <typename T, int D, typename Stats>
+void DaryHeap<T, D, Stats>::heapifyUp(int index, const T &value)
+{
+    // Move parents down into the hole until the value fits
+    while (index > 0)
+    {
+        int parentIndex = (index - 1) / D;
+        if (!less(value, values[parentIndex + OFFSET]))
+        {
+            break;
+        }
+        place(index, values[parentIndex + OFFSET]);
+        index = parentIndex;
+    }
+    place(index, value);
+}
+
+template <typename T, int D, typename Stats>
+void DaryHeap<T, D, Stats>::heapifyDown(int index, const T &value)
+{
+    // Move the smallest child up into the hole until the value fits
+    while (true)
+    {
+        int first = D * index + 1;
+        if (first >= count)
+        {
+            break;
+        }
+        int smallest = smallestChild(first);
+        if (!less(values[smallest + OFFSET], value))
+        {
+            break;
+        }
+        place(index, values[smallest + OFFSET]);
+        index = smallest;
+    }
+    place(index, value);
+}
+
+template <typename T, int D, typename Stats>
+int DaryHeap<T, D, Stats>::smallestChild(int first) const
+{
+    if constexpr (useKeys)
+    {
+        // The group starts at a multiple of D and unused slots hold KEY_PADDING, so the
+        // whole group can be scanned; ties resolve to the lowest index, which is a real child
+        const int *group = keys.data() + first + OFFSET;
+#if defined(__AVX2__)
+        if constexpr (D == 8 || D == 16)
+        {
+            __m256i lo = _mm256_load_si256(reinterpret_cast<const __m256i *>(group));
+            __m256i m = lo;
+            if constexpr (D == 16)
+            {
+                m = _mm256_min_epi32(m, _mm256_load_si256(reinterpret_cast<const __m256i *>(group + 8)));
+            }
+            // Horizontal minimum: fold the 128-bit halves, then the 64-bit and 32-bit lanes
+            m = _mm256_min_epi32(m, _mm256_permute2x128_si256(m, m, 1));
+            m = _mm256_min_epi32(m, _mm256_shuffle_epi32(m, 0x4E));
+            m = _mm256_min_epi32(m, _mm256_shuffle_epi32(m, 0xB1));
+            auto mask = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(lo, m))));
+            if constexpr (D == 16)
+            {
+                __m256i hi = _mm256_load_si256(reinterpret_cast<const __m256i *>(group + 8));
+                mask |= static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(hi, m)))) << 8;
+            }
+            return first + std::countr_zero(mask);
+        }
+#endif
+#if defined(__SSE4_1__)
+        if constexpr (D == 4)
+        {
+            __m128i v = _mm_load_si128(reinterpret_cast<const __m128i *>(group));
+            __m128i m = _mm_min_epi32(v, _mm_shuffle_epi32(v, 0x4E));
+            m = _mm_min_epi32(m, _mm_shuffle_epi32(m, 0xB1));
+            auto mask = static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v, m))));
+            return first + std::countr_zero(mask);
+        }
+#endif
+        int smallest = 0;
+        for (int i = 1; i < D; i++)
+        {
+            if (group[i] < group[smallest])
+            {
+                smallest = i;
+            }
+        }
+        return first + smallest;
+    }
+    else
+    {
+        int last = std::min(first + D, count);
+        int smallest = first;
+        for (int i = first + 1; i < last; i++)
+        {
+            if (values[i + OFFSET] < values[smallest + OFFSET])
+            {
+                smallest = i;
+            }
+        }
+        return smallest;
+    }
+}
@@ -0,0 +1,535 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <stdexcept>
+
+#include "graph.hpp"
+#include "mappedfile.hpp"
+#include "parallel.hpp"
+
+/**
+ * @file dimacs.hpp
+ * @brief Parallel parser for DIMACS shortest-path graph (.gr) and query files, plus coordinate (.co) files.
+ *
+ * The input is memory-mapped and split into newline-aligned chunks, one per
+ * thread. Every thread parses its chunk with std::from_chars directly out of the
+ * mapping, so no memory is allocated per line. The CSR arrays are filled with a
+ * parallel counting sort by source vertex:
+ *
+ * 1. every thread parses its chunk and counts out-degrees into a shared array;
+ * 2. the degrees are turned into offsets with a blocked parallel prefix sum;
+ * 3. every thread parses its chunk again and scatters its arcs to their slots;
+ * 4. every adjacency range is sorted, so the result does not depend on the
+ *    order in which the threads claimed slots.
+ *
+ * The problem line and the number of arcs are validated against each other.
+ * The writers at the end produce files in the same formats, for generated graphs.
+ */
+
+/**
+ * @class DimacsScanner
+ * @brief Cursor over a character range with the few primitives the DIMACS formats need.
+ */
+class DimacsScanner
+{
+public:
+    DimacsScanner(const char *begin, const char *end) : current(begin), end(end) {}
+
+    bool atEnd() const
+    {
+        return current == end;
+    }
+
+    char peek() const
+    {
+        return *current;
+    }
+
+    const char *position() const
+    {
+        return current;
+    }
+
+    /**
+     * @brief Advances past the next newline, or to the end of the range.
+     */
+    void skipLine()
+    {
+        while (current != end && *current++ != '\n')
+        {
+        }
+    }
+
+    /**
+     * @brief Advances past the current character.
+     */
+    void skipChar()
+    {
+        ++current;
+    }
+
+    /**
+     * @brief Skips blanks and parses a decimal integer.
+     *
+     * @param value Receives the parsed integer.
+     * @return true on success, false if no integer could be parsed.
+     */
+    bool readInt(int &value)
+    {
+        skipBlanks();
+        auto [next, error] = std::from_chars(current, end, value);
+        if (error != std::errc())
+        {
+            return false;
+        }
+        current = next;
+        return true;
+    }
+
+    /**
+     * @brief Skips blanks and one whitespace-delimited word.
+     *
+     * @return true if a word was skipped.
+     */
+    bool skipWord()
+    {
+        skipBlanks();
+        const char *start = current;
+        while (current != end && !isSpace(*current))
+        {
+            ++current;
+        }
+        return current != start;
+    }
+
+    /**
+     * @brief Skips blanks and reports whether only the line terminator remains.
+     */
+    bool atLineEnd()
+    {
+        skipBlanks();
+        return current == end || *current == '\n' || *current == '\r';
+    }
+
+private:
+    static bool isSpace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    void skipBlanks()
+    {
+        while (current != end && (*current == ' ' || *current == '\t'))
+        {
+            ++current;
+        }
+    }
+
+    const char *current; ///< The next character to read.
+    const char *end;     ///< One past the last character of the range.
+};
+
+/**
+ * @brief Builds the error message for a malformed input position.
+ */
+inline std::string dimacsError(const std::string &filename, const MappedFile &file, const char *where, const std::string &message)
+{
+    return filename + ": " + message + " at byte " + std::to_string(where - file.data());
+}
+
+/**
+ * @brief Parses every arc line in [begin, end) and calls onArc(u, v, w) with 0-based endpoints.
+ *
+ * Comment and blank lines are skipped; anything else is an error.
+ */
+template <typename OnArc>
+void parseDimacsArcs(const std::string &filename, const MappedFile &file, const char *begin, const char *end, int n, OnArc &&onArc)
+{
+    DimacsScanner scanner(begin, end);
+    while (!scanner.atEnd())
+    {
+        const char *line = scanner.position();
+        char kind = scanner.peek();
+        if (kind == 'a')
+        {
+            scanner.skipChar();
+            int u, v, w;
+            if (!scanner.readInt(u) || !scanner.readInt(v) || !scanner.readInt(w) || !scanner.atLineEnd())
+            {
+                throw std::runtime_error(dimacsError(filename, file, line, "malformed arc line"));
+            }
+            if (u < 1 || u > n || v < 1 || v > n)
+            {
+                throw std::runtime_error(dimacsError(filename, file, line, "arc endpoint out of range"));
+            }
+            if (w < 0)
+            {
+                throw std::runtime_error(dimacsError(filename, file, line, "negative arc weight"));
+            }
+            onArc(u - 1, v - 1, w);
+        }
+        else if (kind == 'p')
+        {
+            throw std::runtime_error(dimacsError(filename, file, line, "duplicate problem line"));
+        }
+        else if (kind != 'c' && kind != '\n' && kind != '\r')
+        {
+            throw std::runtime_error(dimacsError(filename, file, line, "unexpected line"));
+        }
+        scanner.skipLine();
+    }
+}
+
+/**
+ * @brief Reads a DIMACS .gr file into a CSR graph using all available cores.
+ *
+ * @param filename The .gr file.
+ * @param threads The number of parser threads.
+ * @return The parsed graph, with vertices renumbered from 0.
+ * @throws std::runtime_error If the file is missing or malformed, or if the
+ *         number of arc lines differs from the problem line.
+ */
+inline Graph readGraphFromFile(const std::string &filename, int threads = defaultThreadCount())
+{
+    MappedFile file(filename);
+    file.advise(MADV_WILLNEED);
+    const char *fileEnd = file.data() + file.size();
+
+    // Find and validate the problem line "p <type> <n> <m>"; only comments may precede it
+    DimacsScanner header(file.data(), fileEnd);
+    int n = -1, m = -1;
+    while (!header.atEnd() && n < 0)
+    {
+        const char *line = header.position();
+        char kind = header.peek();
+        if (kind == 'p')
+        {
+            header.skipChar();
+            if (!header.skipWord() || !header.readInt(n) || !header.readInt(m) || !header.atLineEnd() || n < 0 || m < 0)
+            {
+                throw std::runtime_error(dimacsError(filename, file, line, "malformed problem line"));
+            }
+        }
+        else if (kind != 'c' && kind != '\n' && kind != '\r')
+        {
+            throw std::runtime_error(dimacsError(filename, file, line, "expected problem line"));
+        }
+        header.skipLine();
+    }
+    if (n < 0)
+    {
+        throw std::runtime_error(filename + ": missing problem line");
+    }
+
+    // Split the body into newline-aligned chunks, one per thread
+    const char *body = header.position();
+    threads = std::max(1, std::min(threads, static_cast<int>((fileEnd - body) / (1 << 16)) + 1));
+    std::vector<const char *> chunks(static_cast<size_t>(threads) + 1, fileEnd);
+    chunks[0] = body;
+    for (int i = 1; i < threads; i++)
+    {
+        const char *split = std::max(chunks[i - 1], body + (fileEnd - body) * i / threads);
+        DimacsScanner scanner(split, fileEnd);
+        if (split != body && split[-1] != '\n')
+        {
+            scanner.skipLine();
+        }
+        chunks[i] = scanner.position();
+    }
+
+    // Pass 1: count out-degrees (shifted by one, so the prefix sum yields offsets)
+    std::vector<int> offsets(static_cast<size_t>(n) + 1, 0);
+    std::vector<long long> chunkArcs(static_cast<size_t>(threads), 0);
+    runOnThreads(threads, [&](int t)
+                 { parseDimacsArcs(filename, file, chunks[t], chunks[t + 1], n, [&](int u, int, int)
+                                   {
+                                       std::atomic_ref<int>(offsets[u + 1]).fetch_add(1, std::memory_order_relaxed);
+                                       chunkArcs[t]++; }); });
+
+    long long arcs = 0;
+    for (long long count : chunkArcs)
+    {
+        arcs += count;
+    }
+    if (arcs != m)
+    {
+        throw std::runtime_error(filename + ": problem line declares " + std::to_string(m) + " arcs but the file contains " + std::to_string(arcs));
+    }
+
+    // Blocked parallel prefix sum: per-block totals, a serial scan over the blocks, then a local scan per block
+    std::vector<int> blockBase(static_cast<size_t>(threads) + 1, 0);
+    auto blockBegin = [&](int t)
+    {
+        return static_cast<int>(static_cast<long long>(n) * t / threads);
+    };
+    runOnThreads(threads, [&](int t)
+                 {
+        int sum = 0;
+        for (int u = blockBegin(t); u < blockBegin(t + 1); u++)
+        {
+            sum += offsets[u + 1];
+        }
+        blockBase[t + 1] = sum; });
+    for (int t = 0; t < threads; t++)
+    {
+        blockBase[t + 1] += blockBase[t];
+    }
+    runOnThreads(threads, [&](int t)
+                 {
+        int sum = blockBase[t];
+        for (int u = blockBegin(t); u < blockBegin(t + 1); u++)
+        {
+            sum += offsets[u + 1];
+            offsets[u + 1] = sum;
+        } });
+
+    // Pass 2: scatter every arc into the next free slot of its source vertex
+    std::vector<int> cursor(offsets.begin(), offsets.end() - 1);
+    std::vector<int> targets(static_cast<size_t>(m));
+    std::vector<int> weights(static_cast<size_t>(m));
+    runOnThreads(threads, [&](int t)
+                 { parseDimacsArcs(filename, file, chunks[t], chunks[t + 1], n, [&](int u, int v, int w)
+                                   {
+                                       int e = std::atomic_ref<int>(cursor[u]).fetch_add(1, std::memory_order_relaxed);
+                                       targets[e] = v;
+                                       weights[e] = w; }); });
+    cursor = {};
+
+    // Slot order depends on thread timing; sort each adjacency range by (target, weight) to make it canonical
+    parallelForBlocks(threads, n, [&](long long begin, long long end)
+                      {
+        std::vector<std::pair<int, int>> scratch;
+        for (long long u = begin; u < end; u++)
+        {
+            int first = offsets[u], last = offsets[u + 1];
+            if (last - first < 2)
+            {
+                continue;
+            }
+            scratch.clear();
+            for (int e = first; e < last; e++)
+            {
+                scratch.emplace_back(targets[e], weights[e]);
+            }
+            std::sort(scratch.begin(), scratch.end());
+            for (int e = first; e < last; e++)
+            {
+                targets[e] = scratch[e - first].first;
+                weights[e] = scratch[e - first].second;
+            }
+        } });
+
+    return Graph::fromArrays(std::move(offsets), std::move(targets), std::move(weights));
+}
+
+/**
+ * @brief Reads a query file with one "start destination" pair per line.
+ *
+ * @param filename The query file; vertex numbers are 1-based.
+ * @return The queries with 0-based vertex numbers.
+ * @throws std::runtime_error If the file is missing or a line is malformed.
+ */
+inline std::vector<std::pair<int, int>> readQueriesFromFile(const std::string &filename)
+{
+    MappedFile file(filename);
+    std::vector<std::pair<int, int>> queries;
+
+    DimacsScanner scanner(file.data(), file.data() + file.size());
+    while (!scanner.atEnd())
+    {
+        const char *line = scanner.position();
+        if (scanner.atLineEnd())
+        {
+            scanner.skipLine();
+            continue;
+        }
+        int start, end;
+        if (!scanner.readInt(start) || !scanner.readInt(end) || !scanner.atLineEnd())
+        {
+            throw std::runtime_error(dimacsError(filename, file, line, "malformed query line"));
+        }
+        queries.emplace_back(start - 1, end - 1);
+        scanner.skipLine();
+    }
+    return queries;
+}
+
+/**
+ * @brief Reads a vertex list with one vertex per line, such as the sources or targets of a distance table.
+ *
+ * @param filename The vertex file; vertex numbers are 1-based.
+ * @return The vertices, 0-based, in file order.
+ * @throws std::runtime_error If the file is missing or a line is malformed.
+ */
+inline std::vector<int> readVerticesFromFile(const std::string &filename)
+{
+    MappedFile file(filename);
+    std::vector<int> vertices;
+
+    DimacsScanner scanner(file.data(), file.data() + file.size());
+    while (!scanner.atEnd())
+    {
+        const char *line = scanner.position();
+        if (scanner.atLineEnd())
+        {
+            scanner.skipLine();
+            continue;
+        }
+        int vertex;
+        if (!scanner.readInt(vertex) || !scanner.atLineEnd())
+        {
+            throw std::runtime_error(dimacsError(filename, file, line, "malformed vertex line"));
+        }
+        vertices.push_back(vertex - 1);
+        scanner.skipLine();
+    }
+    return vertices;
+}
+
+/**
+ * @brief Reads a DIMACS coordinate (.co) file.
+ *
+ * The file has a problem line "p aux sp co <n>" followed by one line
+ * "v <id> <x> <y>" per vertex, where x is the longitude and y the latitude in
+ * millionths of a degree.
+ *
+ * @param filename The .co file.
+ * @return The coordinates, indexed by 0-based vertex.
+ * @throws std::runtime_error If the file is missing or malformed, or if a vertex has no or several lines.
+ */
+inline std::vector<Coordinate> readCoordinatesFromFile(const std::string &filename)
+{
+    MappedFile file(filename);
+    std::vector<Coordinate> coordinates;
+    std::vector<char> seen;
+    int n = -1;
+
+    DimacsScanner scanner(file.data(), file.data() + file.size());
+    while (!scanner.atEnd())
+    {
+        const char *line = scanner.position();
+        char kind = scanner.peek();
+        if (kind == 'p')
+        {
+            scanner.skipChar();
+            if (n >= 0 || !scanner.skipWord() || !scanner.skipWord() || !scanner.skipWord() || !scanner.readInt(n) || !scanner.atLineEnd() || n < 0)
+            {
+                throw std::runtime_error(dimacsError(filename, file, line, "malformed problem line"));
+            }
+            coordinates.resize(static_cast<size_t>(n));
+            seen.assign(static_cast<size_t>(n), 0);
+        }
+        else if (kind == 'v')
+        {
+            scanner.skipChar();
+            int id, x, y;
+            if (n < 0 || !scanner.readInt(id) || !scanner.readInt(x) || !scanner.readInt(y) || !scanner.atLineEnd())
+            {
+                throw std::runtime_error(dimacsError(filename, file, line, "malformed vertex line"));
+            }
+            if (id < 1 || id > n || seen[id - 1])
+            {
+                throw std::runtime_error(dimacsError(filename, file, line, "vertex out of range or repeated"));
+            }
+            seen[id - 1] = 1;
+            coordinates[id - 1] = {x, y};
+        }
+        else if (kind != 'c' && kind != '\n' && kind != '\r')
+        {
+            throw std::runtime_error(dimacsError(filename, file, line, "unexpected line"));
+        }
+        scanner.skipLine();
+    }
+    if (n < 0)
+    {
+        throw std::runtime_error(filename + ": missing problem line");
+    }
+    if (std::count(seen.begin(), seen.end(), 1) != n)
+    {
+        throw std::runtime_error(filename + ": not every vertex has coordinates");
+    }
+    return coordinates;
+}
+
+// Open a file for writing, or throw
+inline std::ofstream openForWriting(const std::string &filename)
+{
+    std::ofstream out(filename);
+    if (!out)
+    {
+        throw std::runtime_error("Could not open " + filename + " for writing");
+    }
+    return out;
+}
+
+// Throw if any write to the file failed
+inline void finishWriting(std::ofstream &out, const std::string &filename)
+{
+    out.close();
+    if (!out)
+    {
+        throw std::runtime_error("Could not write " + filename);
+    }
+}
+
+/**
+ * @brief Writes a graph as a DIMACS .gr file that readGraphFromFile reads back.
+ *
+ * @param graph The graph.
+ * @param filename The .gr file.
+ * @throws std::runtime_error If the file cannot be written.
+ */
+inline void writeGraphToFile(const Graph &graph, const std::string &filename)
+{
+    std::ofstream out = openForWriting(filename);
+    out << "p sp " << graph.vertexCount() << ' ' << graph.arcCount() << '\n';
+    for (int u = 0; u < graph.vertexCount(); u++)
+    {
+        for (int e = graph.beginArc(u), last = graph.endArc(u); e < last; e++)
+        {
+            out << "a " << u + 1 << ' ' << graph.target(e) + 1 << ' ' << graph.weight(e) << '\n';
+        }
+    }
+    finishWriting(out, filename);
+}
+
+/**
+ * @brief Writes vertex positions as a DIMACS .co file that readCoordinatesFromFile reads back.
+ *
+ * @param coordinates The coordinates, indexed by 0-based vertex.
+ * @param filename The .co file.
+ * @throws std::runtime_error If the file cannot be written.
+ */
+inline void writeCoordinatesToFile(const std::vector<Coordinate> &coordinates, const std::string &filename)
+{
+    std::ofstream out = openForWriting(filename);
+    out << "p aux sp co " << coordinates.size() << '\n';
+    for (size_t v = 0; v < coordinates.size(); v++)
+    {
+        out << "v " << v + 1 << ' ' << coordinates[v].longitude << ' ' << coordinates[v].latitude << '\n';
+    }
+    finishWriting(out, filename);
+}
+
+/**
+ * @brief Writes queries as a file that readQueriesFromFile reads back.
+ *
+ * @param queries The queries, with 0-based vertex numbers.
+ * @param filename The query file.
+ * @throws std::runtime_error If the file cannot be written.
+ */
+inline void writeQueriesToFile(const std::vector<std::pair<int, int>> &queries, const std::string &filename)
+{
+    std::ofstream out = openForWriting(filename);
+    for (const auto &[start, end] : queries)
+    {
+        out << start + 1 << ' ' << end + 1 << '\n';
+    }
+    finishWriting(out, filename);
+}
@@ -0,0 +1,236 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "contractionhierarchy.hpp"
+#include "parallel.hpp"
+#include "pathfinder.hpp"
+
+/**
+ * @file distancetable.hpp
+ * @brief Many-to-many queries: the distances from every source to every target.
+ *
+ * Both functions return the table as one row-major array: entry
+ * i * targets.size() + j is the distance from sources[i] to targets[j], or INF
+ * if there is no path. Sources and targets may repeat.
+ */
+
+/**
+ * @brief Computes a distance table with one Dijkstra search per source.
+ *
+ * Each search stops as soon as every target is settled, instead of exploring
+ * the whole graph. The searches run in parallel.
+ *
+ * @tparam PriorityQueue The type of priority queue; any heap works.
+ *
+ * @param sources The row vertices.
+ * @param targets The column vertices.
+ * @param graph The graph.
+ * @param threads The number of threads.
+ *
+ * @return The table, row-major.
+ */
+template <typename PriorityQueue>
+std::vector<int> distance_table(const std::vector<int> &sources, const std::vector<int> &targets, const Graph &graph,
+                                int threads = defaultThreadCount())
+{
+    // Count every target vertex once, however often it is listed
+    std::vector<char> isTarget(static_cast<size_t>(graph.vertexCount()), 0);
+    int distinctTargets = 0;
+    for (int t : targets)
+    {
+        distinctTargets += isTarget[t] ? 0 : 1;
+        isTarget[t] = 1;
+    }
+
+    size_t columns = targets.size();
+    std::vector<int> table(sources.size() * columns, INF);
+    std::vector<std::unique_ptr<QueryWorkspace<PriorityQueue>>> workspaces(static_cast<size_t>(std::max(1, threads)));
+    parallelForStealing(threads, static_cast<long long>(sources.size()), [&](int thread, long long i)
+                        {
+        auto &workspace = workspaces[static_cast<size_t>(thread)];
+        if (!workspace)
+        {
+            workspace = std::make_unique<QueryWorkspace<PriorityQueue>>(graph.vertexCount());
+        }
+        workspace->reset(graph.vertexCount());
+        workspace->setDistance(sources[static_cast<size_t>(i)], 0);
+        PriorityQueue &pq = workspace->queue();
+        pq.push({0, sources[static_cast<size_t>(i)]});
+
+        // Distances only improve strictly, so the first valid pop of a vertex is its only one
+        int remaining = distinctTargets;
+        while (remaining > 0 && !pq.empty())
+        {
+            auto [dist, u] = pq.pop();
+            if (dist > workspace->distance(u))
+                continue;
+            if (isTarget[u])
+                remaining--;
+
+            for (int e = graph.beginArc(u), last = graph.endArc(u); e < last; e++)
+            {
+                int v = graph.target(e);
+                int candidate = dist + graph.weight(e);
+
+                if (candidate < workspace->distance(v))
+                {
+                    workspace->setDistance(v, candidate);
+                    pq.push({candidate, v});
+                }
+            }
+        }
+
+        // Every target is settled or unreachable, so the tentative distances are final
+        int *row = table.data() + static_cast<size_t>(i) * columns;
+        for (size_t j = 0; j < columns; j++)
+        {
+            row[j] = workspace->distance(targets[j]);
+        } });
+
+    return table;
+}
+
+/**
+ * @brief Runs a complete upward search in a contraction hierarchy with stall-on-demand.
+ *
+ * @param source The vertex the search starts from.
+ * @param g The graph the search follows: the upward graph, or the downward graph for a backward search.
+ * @param opposite The other of the two graphs, which lists the arcs between u and higher-ranked vertices in the other direction.
+ * @param workspace The workspace to run on; reset first.
+ * @param visit Called with every vertex that is settled without being stalled, and its distance.
+ */
+template <typename PriorityQueue, typename Visit>
+void ch_upward_search(int source, const Graph &g, const Graph &opposite, QueryWorkspace<PriorityQueue> &workspace, Visit visit)
+{
+    workspace.reset(g.vertexCount());
+    workspace.setDistance(source, 0);
+    PriorityQueue &pq = workspace.queue();
+    pq.push({0, source});
+
+    while (!pq.empty())
+    {
+        auto [dist, u] = pq.pop();
+        if (dist > workspace.distance(u))
+            continue;
+
+        // A stalled vertex is reached more cheaply through a higher-ranked one, so its distance may be too long
+        bool stalled = false;
+        for (int e = opposite.beginArc(u), last = opposite.endArc(u); e < last && !stalled; e++)
+        {
+            int w = workspace.distance(opposite.target(e));
+            stalled = w != INF && w + opposite.weight(e) < dist;
+        }
+        if (stalled)
+            continue;
+
+        visit(u, dist);
+        for (int e = g.beginArc(u), last = g.endArc(u); e < last; e++)
+        {
+            int v = g.target(e);
+            int candidate = dist + g.weight(e);
+
+            if (candidate < workspace.distance(v))
+            {
+                workspace.setDistance(v, candidate);
+                pq.push({candidate, v});
+            }
+        }
+    }
+}
+
+/**
+ * @brief Computes a distance table on a contraction hierarchy with buckets (Knopp et al.).
+ *
+ * One backward upward search from every target leaves an entry (j, d(v, targets[j]))
+ * in the bucket of every vertex v it settles. One forward upward search from
+ * every source then scans the buckets of the vertices it settles: every
+ * shortest path has a highest vertex, which both searches reach with the exact
+ * distance. That is |sources| + |targets| small searches instead of
+ * |sources| x |targets| point-to-point queries. Both phases run in parallel.
+ *
+ * @tparam PriorityQueue The type of priority queue; any heap works.
+ *
+ * @param sources The row vertices.
+ * @param targets The column vertices.
+ * @param hierarchy The contraction hierarchy.
+ * @param threads The number of threads.
+ *
+ * @return The table, row-major.
+ */
+template <typename PriorityQueue>
+std::vector<int> ch_distance_table(const std::vector<int> &sources, const std::vector<int> &targets,
+                                   const ContractionHierarchy &hierarchy, int threads = defaultThreadCount())
+{
+    struct BucketEntry
+    {
+        int vertex; // The vertex whose bucket holds the entry
+        int column; // The index of the target
+        int dist;   // The distance from the vertex to the target
+    };
+
+    int n = hierarchy.vertexCount();
+    threads = std::max(1, threads);
+    std::vector<std::unique_ptr<QueryWorkspace<PriorityQueue>>> workspaces(static_cast<size_t>(threads));
+    auto workspaceOf = [&](int thread) -> QueryWorkspace<PriorityQueue> &
+    {
+        auto &workspace = workspaces[static_cast<size_t>(thread)];
+        if (!workspace)
+        {
+            workspace = std::make_unique<QueryWorkspace<PriorityQueue>>(n);
+        }
+        return *workspace;
+    };
+
+    // Backward searches, each thread collecting the entries it produces
+    std::vector<std::vector<BucketEntry>> produced(static_cast<size_t>(threads));
+    parallelForStealing(threads, static_cast<long long>(targets.size()), [&](int thread, long long j)
+                        {
+        std::vector<BucketEntry> &entries = produced[static_cast<size_t>(thread)];
+        ch_upward_search(targets[static_cast<size_t>(j)], hierarchy.downward(), hierarchy.upward(), workspaceOf(thread),
+                         [&](int v, int dist)
+                         { entries.push_back({v, static_cast<int>(j), dist}); }); });
+
+    // Sort the entries into one bucket per vertex
+    std::vector<size_t> bucketStart(static_cast<size_t>(n) + 1, 0);
+    for (const auto &entries : produced)
+    {
+        for (const BucketEntry &entry : entries)
+        {
+            bucketStart[static_cast<size_t>(entry.vertex) + 1]++;
+        }
+    }
+    for (size_t v = 0; v < static_cast<size_t>(n); v++)
+    {
+        bucketStart[v + 1] += bucketStart[v];
+    }
+    std::vector<std::pair<int, int>> buckets(bucketStart.back()); // (column, distance)
+    std::vector<size_t> cursor(bucketStart.begin(), bucketStart.end() - 1);
+    for (auto &entries : produced)
+    {
+        for (const BucketEntry &entry : entries)
+        {
+            buckets[cursor[entry.vertex]++] = {entry.column, entry.dist};
+        }
+        std::vector<BucketEntry>().swap(entries);
+    }
+
+    // Forward searches, each filling its own row
+    size_t columns = targets.size();
+    std::vector<int> table(sources.size() * columns, INF);
+    parallelForStealing(threads, static_cast<long long>(sources.size()), [&](int thread, long long i)
+                        {
+        int *row = table.data() + static_cast<size_t>(i) * columns;
+        ch_upward_search(sources[static_cast<size_t>(i)], hierarchy.upward(), hierarchy.downward(), workspaceOf(thread),
+                         [&](int u, int dist)
+                         {
+            for (size_t b = bucketStart[u], last = bucketStart[static_cast<size_t>(u) + 1]; b < last; b++)
+            {
+                auto [column, toTarget] = buckets[b];
+                row[column] = std::min(row[column], dist + toTarget);
+            } }); });
+
+    return table;
+}
@@ -12,11 +12,44 @@
 
 #pragma once
 
-#include <unordered_map>
-#include <cmath>
+#include <algorithm>
+#include <array>
 #include <limits>
 
 #include "heap.hpp"
+#include "nodepool.hpp"
+#include "stats.hpp"
+
+/**
+ * @struct FiboHeapNode
+ * @brief A node in the Fibonacci Heap.
+ *
+ * This structure represents a node in the Fibonacci Heap. Pointers to nodes
+ * serve as the handles returned by FiboHeap::insert.
+ *
+ * @tparam T The type of the value stored in the node.
+ */
+template <typename T>
+struct FiboHeapNode
+{
+    T value;              ///< The value stored in the node.
+    FiboHeapNode *parent; ///< Pointer to the parent node.
+    FiboHeapNode *child;  ///< Pointer to the child node.
+    FiboHeapNode *left;   ///< Pointer to the left sibling node.
+    FiboHeapNode *right;  ///< Pointer to the right sibling node.
+    int degree;           ///< The degree of the node.
+    bool mark;            ///< Mark indicating whether the node has lost a child since it became a child of its current parent.
+
+    /**
+     * @brief Constructor for Node.
+     *
+     * @param val The value to be stored in the node.
+     */
+    FiboHeapNode(const T &val) : value(val), parent(nullptr), child(nullptr), left(this), right(this), degree(0), mark(false) {};
+
+    FiboHeapNode(const FiboHeapNode &) = delete;
+    FiboHeapNode &operator=(const FiboHeapNode &) = delete;
+};
 
 /**
  * @class FiboHeap
@@ -25,37 +58,23 @@
  * This class implements a Fibonacci Heap, which supports efficient heap operations.
  *
  * @tparam T The type of elements stored in the heap.
+ * @tparam Pool The allocator for the nodes, NodePool or NewDeletePool (see nodepool.hpp).
+ * @tparam Stats The operation counting policy; see stats.hpp.
  */
-template <typename T>
-class FiboHeap : public Heap<T>
+template <typename T, template <typename> class Pool = DefaultNodePool, typename Stats = NoStats>
+class FiboHeap : public AddressableHeap<T, FiboHeapNode<T> *>
 {
 private:
-    /**
-     * @struct Node
-     * @brief A node in the Fibonacci Heap.
-     *
-     * This structure represents a node in the Fibonacci Heap.
-     */
-    struct Node
-    {
-        T value;      ///< The value stored in the node.
-        Node *parent; ///< Pointer to the parent node.
-        Node *child;  ///< Pointer to the child node.
-        Node *left;   ///< Pointer to the left sibling node.
-        Node *right;  ///< Pointer to the right sibling node.
-        int degree;   ///< The degree of the node.
-        bool mark;    ///< Mark indicating whether the node has lost a child since it became a child of its current parent.
-
-        /**
-         * @brief Constructor for Node.
-         *
-         * @param val The value to be stored in the node.
-         */
-        Node(const T &val) : value(val), parent(nullptr), child(nullptr), left(this), right(this), degree(0), mark(false) {};
-    };
-
-    Node *minNode; ///< Pointer to the node with the minimum value.
-    int nodeCount; ///< The number of nodes in the heap.
+    using Node = FiboHeapNode<T>;
+
+    // Degrees stay below log_phi(n) + 1, which is less than 47 for any int-sized heap
+    static constexpr int MAX_DEGREE = 64;
+
+    Node *minNode;                              ///< Pointer to the node with the minimum value.
+    int nodeCount;                              ///< The number of nodes in the heap.
+    std::array<Node *, MAX_DEGREE> degreeTable; ///< Scratch table of roots by degree; all nullptr between pops.
+    Pool<Node> pool;                            ///< Storage for the nodes.
+    [[no_unique_address]] Stats counters;       ///< The operation counts.
 
     /**
      * @brief Links two nodes in the heap.
@@ -71,9 +90,26 @@ private:
      * @brief Consolidates the heap.
      *
      * This function consolidates the heap by merging trees of the same degree.
+     * It links trees through the fixed degree table and picks the new minimum
+     * in the same walk over the root list, so a pop never allocates.
      */
     void consolidate();
 
+    /**
+     * @brief Cuts node x from its parent y and moves it to the root list.
+     *
+     * @param x The node to be cut.
+     * @param y The parent of x.
+     */
+    void cut(Node *x, Node *y);
+
+    /**
+     * @brief Walks up from y, cutting every marked ancestor and marking the first unmarked one.
+     *
+     * @param y The node that just lost a child.
+     */
+    void cascadingCut(Node *y);
+
 public:
     /**
      * @brief Default constructor for FiboHeap.
@@ -85,66 +121,9 @@ public:
      *
      * @param other The other Fibonacci Heap to copy from.
      */
-    FiboHeap(const FiboHeap &other) : minNode(nullptr), nodeCount(0)
+    FiboHeap(const FiboHeap &other) : minNode(nullptr), nodeCount(0), degreeTable(), pool(), counters(other.counters)
     {
-        if (other.minNode != nullptr)
-        {
-            std::unordered_map<Node *, Node *> nodeMap;
-            std::vector<Node *> nodesToCopy;
-
-            Node *current = other.minNode;
-            do
-            {
-                nodesToCopy.push_back(current);
-                current = current->right;
-            } while (current != other.minNode);
-
-            for (Node *node : nodesToCopy)
-            {
-                Node *newNode = new Node(node->value);
-                nodeMap[node] = newNode;
-                if (minNode == nullptr)
-                {
-                    minNode = newNode;
-                }
-                else
-                {
-                    newNode->left = minNode;
-                    newNode->right = minNode->right;
-                    minNode->right->left = newNode;
-                    minNode->right = newNode;
-                    if (newNode->value < minNode->value)
-                    {
-                        minNode = newNode;
-                    }
-                }
-            }
-
-            for (Node *node : nodesToCopy)
-            {
-                Node *newNode = nodeMap[node];
-                if (node->child != nullptr)
-                {
-                    newNode->child = nodeMap[node->child];
-                }
-                if (node->parent != nullptr)
-                {
-                    newNode->parent = nodeMap[node->parent];
-                }
-                if (node->left != nullptr)
-                {
-                    newNode->left = nodeMap[node->left];
-                }
-                if (node->right != nullptr)
-                {
-                    newNode->right = nodeMap[node->right];
-                }
-                newNode->degree = node->degree;
-                newNode->mark = node->mark;
-            }
-
-            nodeCount = other.nodeCount;
-        }
+        copyFrom(other);
     }
 
     /**
@@ -158,70 +137,11 @@ public:
         if (this != &other)
         {
             // Clear the current heap
-            while (!empty())
-            {
-                pop();
-            }
+            clear();
 
             // Copy the other heap
-            if (other.minNode != nullptr)
-            {
-                std::unordered_map<Node *, Node *> nodeMap;
-                std::vector<Node *> nodesToCopy;
-
-                Node *current = other.minNode;
-                do
-                {
-                    nodesToCopy.push_back(current);
-                    current = current->right;
-                } while (current != other.minNode);
-
-                for (Node *node : nodesToCopy)
-                {
-                    Node *newNode = new Node(node->value);
-                    nodeMap[node] = newNode;
-                    if (minNode == nullptr)
-                    {
-                        minNode = newNode;
-                    }
-                    else
-                    {
-                        newNode->left = minNode;
-                        newNode->right = minNode->right;
-                        minNode->right->left = newNode;
-                        minNode->right = newNode;
-                        if (newNode->value < minNode->value)
-                        {
-                            minNode = newNode;
-                        }
-                    }
-                }
-
-                for (Node *node : nodesToCopy)
-                {
-                    Node *newNode = nodeMap[node];
-                    if (node->child != nullptr)
-                    {
-                        newNode->child = nodeMap[node->child];
-                    }
-                    if (node->parent != nullptr)
-                    {
-                        newNode->parent = nodeMap[node->parent];
-                    }
-                    if (node->left != nullptr)
-                    {
-                        newNode->left = nodeMap[node->left];
-                    }
-                    if (node->right != nullptr)
-                    {
-                        newNode->right = nodeMap[node->right];
-                    }
-                    newNode->degree = node->degree;
-                    newNode->mark = node->mark;
-                }
-
-                nodeCount = other.nodeCount;
-            }
+            counters = other.counters;
+            copyFrom(other);
         }
         return *this;
     }
@@ -230,8 +150,18 @@ public:
      * @brief Inserts a value into the heap.
      *
      * @param value The value to be inserted.
+     * @return A handle to the new node, valid until it is popped.
      */
-    void push(const T &value) override;
+    Node *insert(const T &value) override;
+
+    /**
+     * @brief Lowers the value of a queued node in O(1) amortized time.
+     *
+     * @param node The handle returned by insert().
+     * @param value The new value, which must not be greater than the current one.
+     * @throws std::invalid_argument If the new value is greater than the current one.
+     */
+    void decrease_key(Node *node, const T &value) override;
 
     /**
      * @brief Extracts the minimum value from the heap.
@@ -251,46 +181,122 @@ public:
         return minNode == nullptr;
     }
 
+    /**
+     * @brief Removes all elements; with a bulk-release pool this is O(1) and keeps the node memory.
+     */
+    void clear() override
+    {
+        if constexpr (Pool<Node>::bulkRelease)
+        {
+            pool.releaseAll();
+        }
+        else
+        {
+            destroyAll();
+        }
+        minNode = nullptr;
+        nodeCount = 0;
+        counters.clear();
+    }
+
+    Stats &stats()
+    {
+        return counters;
+    }
+
     /**
      * @brief Destructor for FiboHeap.
+     *
+     * A bulk-release pool frees its slabs as a whole; otherwise every node is deleted.
      */
     ~FiboHeap()
     {
-        if (minNode != nullptr)
+        if constexpr (!Pool<Node>::bulkRelease)
         {
-            std::vector<Node *> nodesToDelete;
-            Node *current = minNode;
-            do
-            {
-                nodesToDelete.push_back(current);
-                current = current->right;
-            } while (current != minNode);
+            destroyAll();
+        }
+    }
 
-            for (Node *node : nodesToDelete)
+private:
+    /**
+     * @brief Returns every node to the pool.
+     *
+     * The root list is opened and walked once; the child list of each visited
+     * node is spliced in behind it, so all levels are reached without extra memory.
+     */
+    void destroyAll()
+    {
+        if (minNode == nullptr)
+        {
+            return;
+        }
+        minNode->left->right = nullptr;
+        Node *list = minNode;
+        while (list != nullptr)
+        {
+            Node *node = list;
+            list = node->right;
+            if (node->child != nullptr)
             {
-                std::vector<Node *> childNodes;
-                if (node->child != nullptr)
-                {
-                    Node *child = node->child;
-                    do
-                    {
-                        childNodes.push_back(child);
-                        child = child->right;
-                    } while (child != node->child);
-                }
-
-                for (Node *child : childNodes)
-                {
-                    delete child;
-                }
-
-                delete node;
+                node->child->left->right = list;
+                list = node->child;
             }
+            pool.destroy(node);
+        }
+    }
+
+    /**
+     * @brief Copies the heap of another Fibonacci Heap into this empty one.
+     */
+    void copyFrom(const FiboHeap &other)
+    {
+        if (other.minNode != nullptr)
+        {
+            minNode = copyRing(other.minNode, nullptr);
         }
+        nodeCount = other.nodeCount;
+    }
+
+    /**
+     * @brief Copies a ring of siblings together with all their descendants.
+     *
+     * @param first The node of the ring to start from; its copy is returned.
+     * @param parent The copy of the parent of the ring, or nullptr for the root list.
+     * @return The copy of first.
+     */
+    Node *copyRing(const Node *first, Node *parent)
+    {
+        Node *head = nullptr;
+        const Node *node = first;
+        do
+        {
+            Node *copy = pool.create(node->value);
+            copy->parent = parent;
+            copy->degree = node->degree;
+            copy->mark = node->mark;
+            if (node->child != nullptr)
+            {
+                copy->child = copyRing(node->child, copy);
+            }
+            if (head == nullptr)
+            {
+                head = copy;
+            }
+            else
+            {
+                // Append the copy at the end of the ring, keeping the sibling order
+                copy->left = head->left;
+                copy->right = head;
+                head->left->right = copy;
+                head->left = copy;
+            }
+            node = node->right;
+        } while (node != first);
+        return head;
     }
 };
 
-template <typename T>
+template <typename T, template <typename> class Pool, typename Stats>
 /**
  * @brief Links two nodes in the heap.
  *
@@ -299,8 +305,10 @@ template <typename T>
  * @param y The node to be linked.
  * @param x The node to which y will be linked.
  */
-void FiboHeap<T>::link(Node *y, Node *x)
+void FiboHeap<T, Pool, Stats>::link(Node *y, Node *x)
 {
+    counters.link();
+
     // Remove y from the root list
     y->left->right = y->right;
     y->right->left = y->left;
@@ -330,84 +338,72 @@ void FiboHeap<T>::link(Node *y, Node *x)
     y->mark = false;
 }
 
-template <typename T>
-void FiboHeap<T>::consolidate()
+template <typename T, template <typename> class Pool, typename Stats>
+void FiboHeap<T, Pool, Stats>::consolidate()
 {
-    // Calculate the maximum degree of any node in the heap
-    int maxDegree = static_cast<int>(std::log2(nodeCount)) + 1;
-    // Create an array to store roots of trees with different degrees
-    std::vector<Node *> A(maxDegree, nullptr);
-
-    // Create a list of root nodes
-    std::vector<Node *> rootList;
-    Node *x = minNode;
-    if (x != nullptr)
+    counters.consolidate();
+
+    // Walk the root list once and link trees of equal degree in place. A link only removes
+    // the current root or one that was already passed, so the walk stays valid.
+    Node *w = minNode;
+    Node *last = minNode->left;
+    Node *best = nullptr;
+    int maxDegree = 0;
+    while (true)
     {
-        // Traverse the root list and add nodes to rootList
-        do
-        {
-            rootList.push_back(x);
-            x = x->right;
-        } while (x != minNode);
-    }
+        Node *next = w->right;
+        bool done = w == last;
+
+        // Children spliced in by pop still point at the deleted node
+        Node *x = w;
+        x->parent = nullptr;
 
-    // Process each node in the root list
-    for (Node *w : rootList)
-    {
-        x = w;
-        int d = x->degree;
         // Merge trees of the same degree
-        while (A[d] != nullptr)
+        int d = x->degree;
+        while (degreeTable[d] != nullptr)
         {
-            Node *y = A[d];
+            Node *y = degreeTable[d];
             if (x->value > y->value)
             {
                 std::swap(x, y);
             }
             link(y, x);
-            A[d] = nullptr;
+            degreeTable[d] = nullptr;
             d++;
         }
-        A[d] = x;
-    }
+        degreeTable[d] = x;
+        maxDegree = std::max(maxDegree, d);
 
-    // Reconstruct the root list from the array A
-    minNode = nullptr;
-    for (Node *y : A)
-    {
-        if (y != nullptr)
+        // x is no larger than any tree it absorbed, so if it is no larger than the best root
+        // so far it is the new minimum, even when the previous best was just linked below it
+        if (best == nullptr || !(best->value < x->value))
         {
-            if (minNode == nullptr)
-            {
-                minNode = y;
-                minNode->left = minNode;
-                minNode->right = minNode;
-            }
-            else
-            {
-                y->left = minNode;
-                y->right = minNode->right;
-                minNode->right->left = y;
-                minNode->right = y;
-                if (y->value < minNode->value)
-                {
-                    minNode = y;
-                }
-            }
+            best = x;
+        }
+
+        if (done)
+        {
+            break;
         }
+        w = next;
     }
+
+    std::fill(degreeTable.begin(), degreeTable.begin() + maxDegree + 1, nullptr);
+    minNode = best;
 }
 
-template <typename T>
-inline FiboHeap<T>::FiboHeap() : minNode(nullptr), nodeCount(0)
+template <typename T, template <typename> class Pool, typename Stats>
+inline FiboHeap<T, Pool, Stats>::FiboHeap() : minNode(nullptr), nodeCount(0), degreeTable(), pool(), counters()
 {
 }
 
-template <typename T>
-void FiboHeap<T>::push(const T &value)
+template <typename T, template <typename> class Pool, typename Stats>
+FiboHeapNode<T> *FiboHeap<T, Pool, Stats>::insert(const T &value)
 {
+    counters.push();
+
     // Create a new node with the given value
-    Node *newNode = new Node(value);
+    Node *newNode = pool.create(value);
 
     // If the heap is empty, set the new node as the minimum node
     if (minNode == nullptr)
@@ -431,41 +427,101 @@ void FiboHeap<T>::push(const T &value)
 
     // Increment the node count
     nodeCount++;
+
+    return newNode;
 }
 
-template <typename T>
-T FiboHeap<T>::pop()
+template <typename T, template <typename> class Pool, typename Stats>
+void FiboHeap<T, Pool, Stats>::decrease_key(Node *x, const T &value)
 {
-    if (minNode == nullptr)
+    if (value > x->value)
     {
-        throw std::runtime_error("Heap is empty");
+        throw std::invalid_argument("New key is greater than the current key");
     }
+    counters.decreaseKey();
+    x->value = value;
 
-    Node *z = minNode;
+    // If the heap order with the parent is violated, move x to the root list
+    Node *y = x->parent;
+    if (y != nullptr && x->value < y->value)
+    {
+        cut(x, y);
+        cascadingCut(y);
+    }
 
-    // If the minimum node has children, add them to the root list
-    if (z->child != nullptr)
+    if (x->value < minNode->value)
     {
-        Node *x = z->child;
-        do
+        minNode = x;
+    }
+}
+
+template <typename T, template <typename> class Pool, typename Stats>
+void FiboHeap<T, Pool, Stats>::cut(Node *x, Node *y)
+{
+    // Remove x from the child list of y
+    if (x->right == x)
+    {
+        y->child = nullptr;
+    }
+    else
+    {
+        x->left->right = x->right;
+        x->right->left = x->left;
+        if (y->child == x)
         {
-            Node *next = x->right;
+            y->child = x->right;
+        }
+    }
+    y->degree--;
+
+    // Add x to the root list
+    x->left = minNode;
+    x->right = minNode->right;
+    minNode->right->left = x;
+    minNode->right = x;
+    x->parent = nullptr;
+    x->mark = false;
+}
 
-            // Remove x from the child list
-            x->left->right = x->right;
-            x->right->left = x->left;
+template <typename T, template <typename> class Pool, typename Stats>
+void FiboHeap<T, Pool, Stats>::cascadingCut(Node *y)
+{
+    Node *z = y->parent;
+    while (z != nullptr)
+    {
+        // The first child lost by a non-root node only marks it
+        if (!y->mark)
+        {
+            y->mark = true;
+            return;
+        }
+        cut(y, z);
+        y = z;
+        z = y->parent;
+    }
+}
 
-            // Add x to the root list
-            x->left = minNode;
-            x->right = minNode->right;
-            minNode->right->left = x;
-            minNode->right = x;
+template <typename T, template <typename> class Pool, typename Stats>
+T FiboHeap<T, Pool, Stats>::pop()
+{
+    if (minNode == nullptr)
+    {
+        throw std::runtime_error("Heap is empty");
+    }
+    counters.pop();
 
-            // Set x's parent to nullptr
-            x->parent = nullptr;
+    Node *z = minNode;
 
-            x = next;
-        } while (x != z->child);
+    // Splice the child list of z into the root list in O(1); consolidate clears the parent pointers
+    if (z->child != nullptr)
+    {
+        Node *first = z->child;
+        Node *last = first->left;
+        Node *after = z->right;
+        z->right = first;
+        first->left = z;
+        last->right = after;
+        after->left = last;
     }
 
     // Remove z from the root list
@@ -485,7 +541,7 @@ T FiboHeap<T>::pop()
     }
 
     T minValue = z->value;
-    delete z;
+    pool.destroy(z);
     nodeCount--;
 
     return minValue;
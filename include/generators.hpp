@@ -0,0 +1,436 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "graph.hpp"
+
+/**
+ * @file generators.hpp
+ * @brief Synthetic graph families, for measuring how the searches scale with the size of the graph.
+ *
+ * Every generator builds an undirected graph, stored as two opposite arcs of
+ * equal weight per edge, and produces the same graph for the same options.
+ * The geometric families place their vertices in a one-degree square of the
+ * map and return the coordinates, so A* runs on them as well.
+ */
+
+/**
+ * @enum GraphFamily
+ * @brief The kinds of graphs generateGraph builds.
+ */
+enum class GraphFamily
+{
+    Grid,      ///< A 2D grid with random weights; every vertex has up to 4 neighbours.
+    Geometric, ///< A random geometric graph: random points joined when closer than a radius.
+    Delaunay,  ///< A road-like planar graph: a triangulation of jittered grid points, thinned out.
+    PowerLaw   ///< A preferential attachment (Barabasi-Albert) graph with a power-law degree distribution.
+};
+
+/**
+ * @brief Parses "grid", "geometric", "delaunay" or "power-law".
+ *
+ * @throws std::invalid_argument If the name is unknown.
+ */
+inline GraphFamily parseGraphFamily(const std::string &name)
+{
+    if (name == "grid")
+    {
+        return GraphFamily::Grid;
+    }
+    if (name == "geometric")
+    {
+        return GraphFamily::Geometric;
+    }
+    if (name == "delaunay")
+    {
+        return GraphFamily::Delaunay;
+    }
+    if (name == "power-law")
+    {
+        return GraphFamily::PowerLaw;
+    }
+    throw std::invalid_argument("Unknown graph family " + name);
+}
+
+/**
+ * @struct GeneratorOptions
+ * @brief The family, size and weights of a generated graph.
+ */
+struct GeneratorOptions
+{
+    GraphFamily family = GraphFamily::Grid; ///< The kind of graph.
+    int vertices = 1000;                    ///< The number of vertices.
+    double degree = 0.0;                    ///< The mean number of arcs leaving a vertex; 0 picks the family's default. Grids ignore it.
+    int minWeight = 1;                      ///< The smallest arc weight.
+    int maxWeight = 1000;                   ///< The largest arc weight.
+    unsigned seed = 1;                      ///< Seed of the random choices.
+};
+
+/**
+ * @struct GeneratedGraph
+ * @brief A generated graph, with the positions of its vertices for the geometric families.
+ */
+struct GeneratedGraph
+{
+    Graph graph{};                        ///< The graph.
+    std::vector<Coordinate> coordinates{}; ///< One position per vertex, or empty for power-law graphs.
+};
+
+// The map square that the geometric families are placed in, in millionths of a degree
+inline constexpr int GENERATED_LONGITUDE = -74'000'000;
+inline constexpr int GENERATED_LATITUDE = 40'000'000;
+inline constexpr int GENERATED_SPAN = 1'000'000;
+
+// A generated vertex position in the unit square
+struct UnitPoint
+{
+    double x;
+    double y;
+};
+
+// Join every edge (u, v) by two arcs with the edge's weight
+inline Graph graphFromEdges(int n, const std::vector<std::pair<int, int>> &edges, const std::vector<int> &weights)
+{
+    std::vector<Arc> arcs;
+    arcs.reserve(2 * edges.size());
+    for (size_t i = 0; i < edges.size(); i++)
+    {
+        arcs.push_back({edges[i].first, edges[i].second, weights[i]});
+        arcs.push_back({edges[i].second, edges[i].first, weights[i]});
+    }
+    return Graph(n, arcs);
+}
+
+// Draw one weight per edge uniformly from the range of the options
+inline std::vector<int> randomWeights(size_t count, const GeneratorOptions &options, std::mt19937 &random)
+{
+    std::uniform_int_distribution<int> weight(options.minWeight, options.maxWeight);
+    std::vector<int> weights(count);
+    for (int &w : weights)
+    {
+        w = weight(random);
+    }
+    return weights;
+}
+
+// Map the edge lengths linearly onto the weight range, so weights grow with the distance on the map
+inline std::vector<int> lengthWeights(const std::vector<std::pair<int, int>> &edges, const std::vector<UnitPoint> &points,
+                                      const GeneratorOptions &options)
+{
+    std::vector<double> lengths(edges.size());
+    double longest = 0.0;
+    for (size_t i = 0; i < edges.size(); i++)
+    {
+        const UnitPoint &a = points[edges[i].first];
+        const UnitPoint &b = points[edges[i].second];
+        lengths[i] = std::hypot(a.x - b.x, a.y - b.y);
+        longest = std::max(longest, lengths[i]);
+    }
+    std::vector<int> weights(edges.size());
+    for (size_t i = 0; i < edges.size(); i++)
+    {
+        double fraction = longest > 0.0 ? lengths[i] / longest : 0.0;
+        weights[i] = options.minWeight + static_cast<int>(std::lround(fraction * (options.maxWeight - options.minWeight)));
+    }
+    return weights;
+}
+
+// Place unit-square points on the map square
+inline std::vector<Coordinate> mapCoordinates(const std::vector<UnitPoint> &points)
+{
+    std::vector<Coordinate> coordinates;
+    coordinates.reserve(points.size());
+    for (const UnitPoint &p : points)
+    {
+        coordinates.push_back({GENERATED_LONGITUDE + static_cast<int>(p.x * GENERATED_SPAN),
+                               GENERATED_LATITUDE + static_cast<int>(p.y * GENERATED_SPAN)});
+    }
+    return coordinates;
+}
+
+/**
+ * @brief Generates a grid of ceil(sqrt(n)) columns, filled row by row; the last row may be partial.
+ */
+inline GeneratedGraph generateGrid(const GeneratorOptions &options, std::mt19937 &random)
+{
+    int n = options.vertices;
+    int columns = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(n))));
+    int rows = (n + columns - 1) / columns;
+
+    std::vector<std::pair<int, int>> edges;
+    std::vector<UnitPoint> points(static_cast<size_t>(n));
+    for (int v = 0; v < n; v++)
+    {
+        int row = v / columns, column = v % columns;
+        points[v] = {(column + 0.5) / columns, (row + 0.5) / rows};
+        if (column + 1 < columns && v + 1 < n)
+        {
+            edges.emplace_back(v, v + 1);
+        }
+        if (v + columns < n)
+        {
+            edges.emplace_back(v, v + columns);
+        }
+    }
+    return {graphFromEdges(n, edges, randomWeights(edges.size(), options, random)), mapCoordinates(points)};
+}
+
+/**
+ * @brief Generates a random geometric graph with the radius that gives the requested mean degree (default 8).
+ *
+ * Points are bucketed into square cells as wide as the radius, so only the
+ * neighbouring cells of a point are searched. Below a mean degree of about
+ * ln(n) the graph usually falls apart into several components.
+ */
+inline GeneratedGraph generateGeometric(const GeneratorOptions &options, std::mt19937 &random)
+{
+    int n = options.vertices;
+    double degree = options.degree > 0.0 ? options.degree : 8.0;
+    double radius = std::min(1.0, std::sqrt(degree / (std::numbers::pi * n)));
+
+    std::uniform_real_distribution<double> coordinate(0.0, 1.0);
+    std::vector<UnitPoint> points(static_cast<size_t>(n));
+    for (UnitPoint &p : points)
+    {
+        p = {coordinate(random), coordinate(random)};
+    }
+
+    // Counting sort of the points by cell
+    int cells = std::max(1, static_cast<int>(1.0 / radius));
+    auto cellOf = [&](double t)
+    { return std::min(cells - 1, static_cast<int>(t * cells)); };
+    std::vector<int> cellStart(static_cast<size_t>(cells) * cells + 1, 0);
+    for (const UnitPoint &p : points)
+    {
+        cellStart[cellOf(p.y) * cells + cellOf(p.x) + 1]++;
+    }
+    std::partial_sum(cellStart.begin(), cellStart.end(), cellStart.begin());
+    std::vector<int> byCell(static_cast<size_t>(n));
+    std::vector<int> cursor(cellStart.begin(), cellStart.end() - 1);
+    for (int v = 0; v < n; v++)
+    {
+        byCell[cursor[cellOf(points[v].y) * cells + cellOf(points[v].x)]++] = v;
+    }
+
+    std::vector<std::pair<int, int>> edges;
+    for (int u = 0; u < n; u++)
+    {
+        int cx = cellOf(points[u].x), cy = cellOf(points[u].y);
+        for (int y = std::max(0, cy - 1); y <= std::min(cells - 1, cy + 1); y++)
+        {
+            for (int x = std::max(0, cx - 1); x <= std::min(cells - 1, cx + 1); x++)
+            {
+                for (int i = cellStart[y * cells + x], last = cellStart[y * cells + x + 1]; i < last; i++)
+                {
+                    int v = byCell[i];
+                    if (v > u && std::hypot(points[u].x - points[v].x, points[u].y - points[v].y) <= radius)
+                    {
+                        edges.emplace_back(u, v);
+                    }
+                }
+            }
+        }
+    }
+    return {graphFromEdges(n, edges, lengthWeights(edges, points, options)), mapCoordinates(points)};
+}
+
+// The angle at p between the directions to a and b
+inline double angleAt(const UnitPoint &p, const UnitPoint &a, const UnitPoint &b)
+{
+    double ax = a.x - p.x, ay = a.y - p.y, bx = b.x - p.x, by = b.y - p.y;
+    return std::abs(std::atan2(ax * by - ay * bx, ax * bx + ay * by));
+}
+
+/**
+ * @brief Generates a road-like planar graph with the requested mean degree (default 2.6, about that of the DIMACS road networks).
+ *
+ * The vertices are grid points, each moved by up to a quarter of the spacing.
+ * Every grid cell is split into two triangles along the diagonal that the
+ * Delaunay criterion prefers (the opposite angles sum to at most pi), which
+ * gives a triangulation with a mean degree of almost 6. It is then thinned
+ * down: the Euclidean minimum spanning forest is kept, so the graph stays
+ * connected, and the remaining edges are added in random order until the
+ * requested degree is reached.
+ */
+inline GeneratedGraph generateDelaunay(const GeneratorOptions &options, std::mt19937 &random)
+{
+    int n = options.vertices;
+    double degree = options.degree > 0.0 ? options.degree : 2.6;
+    int columns = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(n))));
+    int rows = (n + columns - 1) / columns;
+
+    std::uniform_real_distribution<double> jitter(-0.25, 0.25);
+    std::vector<UnitPoint> points(static_cast<size_t>(n));
+    for (int v = 0; v < n; v++)
+    {
+        points[v] = {(v % columns + 0.5 + jitter(random)) / columns, (v / columns + 0.5 + jitter(random)) / rows};
+    }
+
+    std::vector<std::pair<int, int>> triangulation;
+    for (int v = 0; v < n; v++)
+    {
+        bool right = v % columns + 1 < columns && v + 1 < n;
+        if (right)
+        {
+            triangulation.emplace_back(v, v + 1);
+        }
+        if (v + columns < n)
+        {
+            triangulation.emplace_back(v, v + columns);
+        }
+        if (right && v + columns + 1 < n)
+        {
+            int a = v, b = v + 1, c = v + columns + 1, d = v + columns;
+            if (angleAt(points[b], points[a], points[c]) + angleAt(points[d], points[a], points[c]) <= std::numbers::pi)
+            {
+                triangulation.emplace_back(a, c);
+            }
+            else
+            {
+                triangulation.emplace_back(b, d);
+            }
+        }
+    }
+
+    // Kruskal's algorithm on the edges by length, with a union-find forest
+    auto length = [&](const std::pair<int, int> &edge)
+    { return std::hypot(points[edge.first].x - points[edge.second].x, points[edge.first].y - points[edge.second].y); };
+    std::sort(triangulation.begin(), triangulation.end(), [&](const auto &a, const auto &b)
+              { return length(a) < length(b); });
+    std::vector<int> parent(static_cast<size_t>(n));
+    std::iota(parent.begin(), parent.end(), 0);
+    auto root = [&](int v)
+    {
+        while (parent[v] != v)
+        {
+            parent[v] = parent[parent[v]];
+            v = parent[v];
+        }
+        return v;
+    };
+    std::vector<std::pair<int, int>> edges, spare;
+    for (const auto &edge : triangulation)
+    {
+        int a = root(edge.first), b = root(edge.second);
+        if (a != b)
+        {
+            parent[a] = b;
+            edges.push_back(edge);
+        }
+        else
+        {
+            spare.push_back(edge);
+        }
+    }
+
+    auto target = static_cast<size_t>(std::llround(degree * n / 2.0));
+    std::shuffle(spare.begin(), spare.end(), random);
+    for (size_t i = 0; i < spare.size() && edges.size() < target; i++)
+    {
+        edges.push_back(spare[i]);
+    }
+    return {graphFromEdges(n, edges, lengthWeights(edges, points, options)), mapCoordinates(points)};
+}
+
+/**
+ * @brief Generates a Barabasi-Albert graph with the requested mean degree (default 6).
+ *
+ * Every new vertex is joined to k = degree / 2 distinct earlier vertices,
+ * each chosen with a probability proportional to its degree, which gives a
+ * degree distribution with a power-law tail of exponent 3. The first k + 1
+ * vertices form a clique.
+ */
+inline GeneratedGraph generatePowerLaw(const GeneratorOptions &options, std::mt19937 &random)
+{
+    int n = options.vertices;
+    double degree = options.degree > 0.0 ? options.degree : 6.0;
+    int k = std::max(1, static_cast<int>(std::lround(degree / 2.0)));
+
+    // Every vertex appears once per incident edge, so a uniform pick is proportional to the degree
+    std::vector<int> endpoints;
+    std::vector<std::pair<int, int>> edges;
+    for (int u = 0; u < std::min(n, k + 1); u++)
+    {
+        for (int v = u + 1; v < std::min(n, k + 1); v++)
+        {
+            edges.emplace_back(u, v);
+            endpoints.push_back(u);
+            endpoints.push_back(v);
+        }
+    }
+
+    std::vector<int> chosen;
+    for (int v = k + 1; v < n; v++)
+    {
+        chosen.clear();
+        std::uniform_int_distribution<size_t> pick(0, endpoints.size() - 1);
+        while (static_cast<int>(chosen.size()) < k)
+        {
+            int u = endpoints[pick(random)];
+            if (std::find(chosen.begin(), chosen.end(), u) == chosen.end())
+            {
+                chosen.push_back(u);
+            }
+        }
+        for (int u : chosen)
+        {
+            edges.emplace_back(u, v);
+            endpoints.push_back(u);
+            endpoints.push_back(v);
+        }
+    }
+    return {graphFromEdges(n, edges, randomWeights(edges.size(), options, random)), {}};
+}
+
+/**
+ * @brief Generates a graph of the requested family.
+ *
+ * @param options The family, size, weights and seed.
+ * @return The graph, with coordinates for every family except power-law.
+ * @throws std::invalid_argument If there are no vertices, the degree is negative or the weight range is empty or negative.
+ */
+inline GeneratedGraph generateGraph(const GeneratorOptions &options)
+{
+    if (options.vertices < 1 || options.degree < 0.0 || options.minWeight < 0 || options.minWeight > options.maxWeight)
+    {
+        throw std::invalid_argument("A generated graph needs vertices, a non-negative degree and a non-negative weight range");
+    }
+
+    std::mt19937 random(options.seed);
+    switch (options.family)
+    {
+    case GraphFamily::Grid:
+        return generateGrid(options, random);
+    case GraphFamily::Geometric:
+        return generateGeometric(options, random);
+    case GraphFamily::Delaunay:
+        return generateDelaunay(options, random);
+    case GraphFamily::PowerLaw:
+        return generatePowerLaw(options, random);
+    }
+    throw std::invalid_argument("Unknown graph family");
+}
+
+/**
+ * @brief Draws uniformly random queries, with 0-based vertex numbers.
+ */
+inline std::vector<std::pair<int, int>> randomQueries(int vertexCount, int count, unsigned seed)
+{
+    std::mt19937 random(seed);
+    std::uniform_int_distribution<int> vertex(0, vertexCount - 1);
+    std::vector<std::pair<int, int>> queries(static_cast<size_t>(std::max(0, count)));
+    for (auto &[start, end] : queries)
+    {
+        start = vertex(random);
+        end = vertex(random);
+    }
+    return queries;
+}
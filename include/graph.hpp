@@ -0,0 +1,308 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+#include <limits>
+#include <span>
+#include <memory>
+#include <stdexcept>
+
+/**
+ * @file graph.hpp
+ * @brief Compressed sparse row (CSR) representation of a directed, weighted graph.
+ *
+ * The arcs leaving vertex u occupy the half-open range [offsets[u], offsets[u + 1])
+ * of the targets and weights arrays, so scanning the neighbours of a vertex is a
+ * linear walk over two contiguous arrays instead of a pointer chase into a
+ * separately allocated vector per vertex.
+ */
+
+// Structure representing an arc as it is read from the input file
+struct Arc
+{
+    int from;   // The source vertex of the arc
+    int to;     // The destination vertex of the arc
+    int weight; // The weight of the arc
+};
+
+// Structure representing the position of a vertex as it is read from a DIMACS .co file
+struct Coordinate
+{
+    int longitude; // Longitude in millionths of a degree
+    int latitude;  // Latitude in millionths of a degree
+};
+
+/**
+ * @class Graph
+ * @brief A directed graph stored as offsets plus contiguous target and weight arrays.
+ *
+ * Arcs are addressed by their index in the CSR arrays, which lets the relaxation
+ * loop of Dijkstra's algorithm iterate over plain integers.
+ *
+ * The arrays are read-only views into a storage block that is either owned by the
+ * graph (when it is built from an arc list) or a memory-mapped cache file. Copies
+ * of a Graph share that storage, so handing a graph to several threads is cheap.
+ */
+class Graph
+{
+public:
+    /**
+     * @brief Constructs an empty graph without vertices.
+     */
+    Graph() : Graph(0, {}) {}
+
+    /**
+     * @brief Builds the CSR arrays from an unordered list of arcs.
+     *
+     * The arcs are bucketed by source vertex with a counting sort, so arcs that
+     * share a source keep their relative input order.
+     *
+     * @param n The number of vertices, numbered from 0 to n - 1.
+     * @param arcs The arcs of the graph.
+     * @throws std::out_of_range If an arc refers to a vertex outside [0, n).
+     */
+    Graph(int n, const std::vector<Arc> &arcs);
+
+    /**
+     * @brief Adopts CSR arrays that live in externally managed memory.
+     *
+     * No data is copied; the graph keeps the storage alive for as long as it
+     * (or any copy of it) exists.
+     *
+     * @param storage The object that owns the memory the spans point into.
+     * @param offsets The n + 1 arc offsets.
+     * @param targets The destination vertex of every arc.
+     * @param weights The weight of every arc.
+     */
+    Graph(std::shared_ptr<const void> storage, std::span<const int> offsets,
+          std::span<const int> targets, std::span<const int> weights)
+        : storage(std::move(storage)), offsets(offsets), targets(targets), weights(weights), calibers(), reverseGraph()
+    {
+    }
+
+    /**
+     * @brief Takes ownership of CSR arrays that were built in memory.
+     *
+     * @param offsets The n + 1 arc offsets.
+     * @param targets The destination vertex of every arc.
+     * @param weights The weight of every arc.
+     * @return A graph viewing the moved-in arrays.
+     */
+    static Graph fromArrays(std::vector<int> offsets, std::vector<int> targets, std::vector<int> weights)
+    {
+        auto owned = std::make_shared<OwnedArrays>(OwnedArrays{std::move(offsets), std::move(targets), std::move(weights)});
+        std::span<const int> o = owned->offsets, t = owned->targets, w = owned->weights;
+        return Graph(std::move(owned), o, t, w);
+    }
+
+    /**
+     * @brief Returns the number of vertices.
+     */
+    int vertexCount() const
+    {
+        return static_cast<int>(offsets.size()) - 1;
+    }
+
+    /**
+     * @brief Returns the number of arcs.
+     */
+    int arcCount() const
+    {
+        return static_cast<int>(targets.size());
+    }
+
+    /**
+     * @brief Returns the index of the first arc leaving vertex u.
+     */
+    int beginArc(int u) const
+    {
+        return offsets[u];
+    }
+
+    /**
+     * @brief Returns one past the index of the last arc leaving vertex u.
+     */
+    int endArc(int u) const
+    {
+        return offsets[u + 1];
+    }
+
+    /**
+     * @brief Asks the cache for the arcs leaving vertex u, ahead of scanning them.
+     */
+    void prefetchArcs(int u) const
+    {
+        int first = offsets[u];
+        __builtin_prefetch(targets.data() + first);
+        __builtin_prefetch(weights.data() + first);
+    }
+
+    /**
+     * @brief Returns the destination vertex of arc e.
+     */
+    int target(int e) const
+    {
+        return targets[e];
+    }
+
+    /**
+     * @brief Returns the weight of arc e.
+     */
+    int weight(int e) const
+    {
+        return weights[e];
+    }
+
+    /**
+     * @brief Computes the caliber of every vertex: the minimum weight of its incoming arcs.
+     *
+     * A vertex without incoming arcs has caliber INT_MAX. The result is shared by
+     * all copies made afterwards.
+     */
+    void computeCalibers();
+
+    /**
+     * @brief Returns whether computeCalibers() has been called on this graph.
+     */
+    bool hasCalibers() const
+    {
+        return calibers != nullptr;
+    }
+
+    /**
+     * @brief Returns the minimum weight of the arcs entering vertex v.
+     */
+    int caliber(int v) const
+    {
+        return (*calibers)[v];
+    }
+
+    /**
+     * @brief Builds the reverse graph, in which every arc u -> v becomes v -> u with the same weight.
+     *
+     * The arcs entering a vertex are then a contiguous range of the reverse
+     * graph, as backward searches need. The result is shared by all copies made
+     * afterwards.
+     */
+    void computeReverse();
+
+    /**
+     * @brief Returns whether computeReverse() has been called on this graph.
+     */
+    bool hasReverse() const
+    {
+        return reverseGraph != nullptr;
+    }
+
+    /**
+     * @brief Returns the reverse graph built by computeReverse().
+     */
+    const Graph &reverse() const
+    {
+        return *reverseGraph;
+    }
+
+    /**
+     * @brief Raw access to the CSR arrays, used when serializing the graph.
+     */
+    std::span<const int> offsetArray() const { return offsets; }
+    std::span<const int> targetArray() const { return targets; }
+    std::span<const int> weightArray() const { return weights; }
+
+private:
+    /**
+     * @struct OwnedArrays
+     * @brief Backing storage for a graph that was built in memory.
+     */
+    struct OwnedArrays
+    {
+        std::vector<int> offsets;
+        std::vector<int> targets;
+        std::vector<int> weights;
+    };
+
+    std::shared_ptr<const void> storage; ///< Keeps the memory behind the spans alive.
+    std::span<const int> offsets;        ///< offsets[u] is the index of the first arc leaving u; offsets[n] == arcCount().
+    std::span<const int> targets;        ///< Destination vertex of every arc, grouped by source vertex.
+    std::span<const int> weights;        ///< Weight of every arc, parallel to targets.
+
+    std::shared_ptr<const std::vector<int>> calibers; ///< Minimum incoming arc weight per vertex, once computed.
+    std::shared_ptr<const Graph> reverseGraph;        ///< The graph with every arc reversed, once computed.
+};
+
+inline void Graph::computeCalibers()
+{
+    auto minimum = std::make_shared<std::vector<int>>(offsets.size() - 1, std::numeric_limits<int>::max());
+    for (size_t e = 0; e < targets.size(); e++)
+    {
+        int &caliber = (*minimum)[targets[e]];
+        caliber = std::min(caliber, weights[e]);
+    }
+    calibers = std::move(minimum);
+}
+
+inline void Graph::computeReverse()
+{
+    int n = vertexCount();
+    std::vector<int> reverseOffsets(static_cast<size_t>(n) + 1, 0);
+    std::vector<int> reverseTargets(targets.size());
+    std::vector<int> reverseWeights(targets.size());
+
+    // Count the in-degree of every vertex and turn the degrees into starting offsets
+    for (int v : targets)
+    {
+        reverseOffsets[v + 1]++;
+    }
+    for (int v = 0; v < n; v++)
+    {
+        reverseOffsets[v + 1] += reverseOffsets[v];
+    }
+
+    // Scatter the arcs by target; visiting sources in order keeps each reverse range sorted by source
+    std::vector<int> cursor(reverseOffsets.begin(), reverseOffsets.end() - 1);
+    for (int u = 0; u < n; u++)
+    {
+        for (int e = offsets[u]; e < offsets[u + 1]; e++)
+        {
+            int slot = cursor[targets[e]]++;
+            reverseTargets[slot] = u;
+            reverseWeights[slot] = weights[e];
+        }
+    }
+
+    reverseGraph = std::make_shared<const Graph>(fromArrays(std::move(reverseOffsets), std::move(reverseTargets), std::move(reverseWeights)));
+}
+
+inline Graph::Graph(int n, const std::vector<Arc> &arcs) : storage(), offsets(), targets(), weights(), calibers(), reverseGraph()
+{
+    std::vector<int> arcOffsets(static_cast<size_t>(n) + 1, 0);
+    std::vector<int> arcTargets(arcs.size());
+    std::vector<int> arcWeights(arcs.size());
+
+    // Count the out-degree of every vertex
+    for (const Arc &arc : arcs)
+    {
+        if (arc.from < 0 || arc.from >= n || arc.to < 0 || arc.to >= n)
+        {
+            throw std::out_of_range("Arc endpoint out of range");
+        }
+        arcOffsets[arc.from + 1]++;
+    }
+
+    // Turn the degrees into starting offsets
+    for (int u = 0; u < n; u++)
+    {
+        arcOffsets[u + 1] += arcOffsets[u];
+    }
+
+    // Scatter the arcs into their buckets, using a running cursor per vertex
+    std::vector<int> cursor(arcOffsets.begin(), arcOffsets.end() - 1);
+    for (const Arc &arc : arcs)
+    {
+        int e = cursor[arc.from]++;
+        arcTargets[e] = arc.to;
+        arcWeights[e] = arc.weight;
+    }
+
+    *this = fromArrays(std::move(arcOffsets), std::move(arcTargets), std::move(arcWeights));
+}
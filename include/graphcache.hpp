@@ -0,0 +1,303 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <span>
+#include <stdexcept>
+
+#include "graph.hpp"
+#include "mappedfile.hpp"
+#include "parallel.hpp"
+
+/**
+ * @file graphcache.hpp
+ * @brief Binary, memory-mappable image of a Graph.
+ *
+ * Parsing the DIMACS text of a large road network takes far longer than the
+ * queries run on it. A graph cache stores the CSR arrays exactly as Graph keeps
+ * them in memory, so loading it is a single mmap: the spans of the returned
+ * graph point straight into the mapping, and pages are only read when a query
+ * touches them.
+ *
+ * File layout (all integers in the byte order of the machine that wrote it):
+ *
+ *     GraphCacheHeader              64 bytes
+ *     offsets[vertexCount + 1]      int32, starts on a 64-byte boundary
+ *     targets[arcCount]             int32, starts on a 64-byte boundary
+ *     weights[arcCount]             int32, starts on a 64-byte boundary
+ */
+
+// Magic bytes at the start of every graph cache file
+inline constexpr char GRAPH_CACHE_MAGIC[8] = {'P', 'F', 'G', 'R', 'A', 'P', 'H', '\0'};
+
+// Format version; bump it whenever the layout changes
+inline constexpr uint32_t GRAPH_CACHE_VERSION = 1;
+
+// Written as-is so a reader can detect a file produced with the other byte order
+inline constexpr uint32_t GRAPH_CACHE_BYTE_ORDER = 0x01020304;
+
+// Alignment of every array section inside the file
+inline constexpr uint64_t GRAPH_CACHE_ALIGNMENT = 64;
+
+/**
+ * @struct GraphCacheHeader
+ * @brief The fixed-size header at the start of a graph cache file.
+ */
+struct GraphCacheHeader
+{
+    char magic[8];            ///< GRAPH_CACHE_MAGIC.
+    uint32_t version;         ///< GRAPH_CACHE_VERSION.
+    uint32_t byteOrder;       ///< GRAPH_CACHE_BYTE_ORDER.
+    uint64_t vertexCount;     ///< Number of vertices.
+    uint64_t arcCount;        ///< Number of arcs.
+    uint64_t offsetsPosition; ///< File offset of the offsets array.
+    uint64_t targetsPosition; ///< File offset of the targets array.
+    uint64_t weightsPosition; ///< File offset of the weights array.
+    uint64_t checksum;        ///< graphCacheChecksum() of the three arrays.
+};
+
+static_assert(sizeof(GraphCacheHeader) == 64, "GraphCacheHeader must stay 64 bytes");
+
+/**
+ * @brief Folds an array into a 64-bit FNV-1a checksum, one 32-bit value at a time.
+ *
+ * @param values The values to hash.
+ * @param hash The running hash; pass the result of the previous array to chain them.
+ * @return The updated hash.
+ */
+inline uint64_t graphCacheChecksum(std::span<const int> values, uint64_t hash = 0xcbf29ce484222325ULL)
+{
+    for (int value : values)
+    {
+        hash ^= static_cast<uint32_t>(value);
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief Computes the checksum stored in the header for the given graph arrays.
+ */
+inline uint64_t graphCacheChecksum(std::span<const int> offsets, std::span<const int> targets, std::span<const int> weights)
+{
+    return graphCacheChecksum(weights, graphCacheChecksum(targets, graphCacheChecksum(offsets)));
+}
+
+/**
+ * @brief Lays out int32 arrays one after another, each starting on the next aligned boundary.
+ *
+ * Files with more arrays than fit positions into a 64-byte header (hierarchies,
+ * hub labels) store only the array lengths and derive the positions with this.
+ *
+ * @param start The first free byte, usually the size of the header.
+ * @param counts The number of values of every array, in file order.
+ * @return The file offset of every array.
+ */
+template <size_t N>
+std::array<uint64_t, N> alignedSectionPositions(uint64_t start, const std::array<uint64_t, N> &counts)
+{
+    std::array<uint64_t, N> positions{};
+    uint64_t position = start;
+    for (size_t i = 0; i < N; i++)
+    {
+        position = (position + GRAPH_CACHE_ALIGNMENT - 1) / GRAPH_CACHE_ALIGNMENT * GRAPH_CACHE_ALIGNMENT;
+        positions[i] = position;
+        position += counts[i] * sizeof(int);
+    }
+    return positions;
+}
+
+/**
+ * @brief Writes int32 arrays at the given positions, zero-padding the gaps before them.
+ *
+ * @param file The output stream, positioned before the first array.
+ * @param positions The file offset of every array, from alignedSectionPositions().
+ * @param sections The arrays.
+ */
+template <size_t N>
+void writeAlignedSections(std::ofstream &file, const std::array<uint64_t, N> &positions, const std::array<std::span<const int>, N> &sections)
+{
+    static const char padding[GRAPH_CACHE_ALIGNMENT] = {};
+    for (size_t i = 0; i < N; i++)
+    {
+        auto current = static_cast<uint64_t>(file.tellp());
+        file.write(padding, static_cast<std::streamsize>(positions[i] - current));
+        file.write(reinterpret_cast<const char *>(sections[i].data()), static_cast<std::streamsize>(sections[i].size_bytes()));
+    }
+}
+
+/**
+ * @brief Resolves int32 arrays inside a mapped file, checking that every one lies inside it.
+ *
+ * @param file The mapped file.
+ * @param positions The file offset of every array, from alignedSectionPositions().
+ * @param counts The number of values of every array.
+ * @param filename The name of the file, for error messages.
+ * @return Views of the arrays.
+ * @throws std::runtime_error If an array extends past the end of the file.
+ */
+template <size_t N>
+std::array<std::span<const int>, N> mapAlignedSections(const MappedFile &file, const std::array<uint64_t, N> &positions,
+                                                       const std::array<uint64_t, N> &counts, const std::string &filename)
+{
+    std::array<std::span<const int>, N> sections;
+    for (size_t i = 0; i < N; i++)
+    {
+        if (positions[i] % GRAPH_CACHE_ALIGNMENT != 0 || positions[i] > file.size() ||
+            counts[i] > (file.size() - positions[i]) / sizeof(int))
+        {
+            throw std::runtime_error(filename + ": section out of bounds");
+        }
+        sections[i] = std::span<const int>(reinterpret_cast<const int *>(file.data() + positions[i]), counts[i]);
+    }
+    return sections;
+}
+
+/**
+ * @brief Writes a graph to disk in the graph cache format.
+ *
+ * @param graph The graph to write.
+ * @param filename The output file, which is overwritten.
+ * @throws std::runtime_error If the file cannot be written.
+ */
+inline void writeGraphCache(const Graph &graph, const std::string &filename)
+{
+    std::span<const int> offsets = graph.offsetArray();
+    std::span<const int> targets = graph.targetArray();
+    std::span<const int> weights = graph.weightArray();
+    std::array<uint64_t, 3> positions = alignedSectionPositions<3>(sizeof(GraphCacheHeader), {offsets.size(), targets.size(), weights.size()});
+
+    GraphCacheHeader header{};
+    std::memcpy(header.magic, GRAPH_CACHE_MAGIC, sizeof(header.magic));
+    header.version = GRAPH_CACHE_VERSION;
+    header.byteOrder = GRAPH_CACHE_BYTE_ORDER;
+    header.vertexCount = static_cast<uint64_t>(graph.vertexCount());
+    header.arcCount = static_cast<uint64_t>(graph.arcCount());
+    header.offsetsPosition = positions[0];
+    header.targetsPosition = positions[1];
+    header.weightsPosition = positions[2];
+    header.checksum = graphCacheChecksum(offsets, targets, weights);
+
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Error opening " + filename + " for writing");
+    }
+
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    writeAlignedSections<3>(file, positions, {offsets, targets, weights});
+
+    if (!file)
+    {
+        throw std::runtime_error("Error writing " + filename);
+    }
+}
+
+/**
+ * @brief Checks that every arc target of a mapped file is a vertex of its graph.
+ *
+ * A damaged target would otherwise send a search outside its arrays. The scan
+ * runs in parallel and costs far less than a single long-distance query.
+ *
+ * @param targets The arc targets.
+ * @param vertexCount The number of vertices.
+ * @param threads The number of threads.
+ * @return true if every target lies in [0, vertexCount).
+ */
+inline bool arcTargetsInRange(std::span<const int> targets, int vertexCount, int threads = defaultThreadCount())
+{
+    std::atomic<bool> inRange = true;
+    parallelForBlocks(threads, static_cast<long long>(targets.size()), [&](long long begin, long long end)
+                      {
+        auto outside = [vertexCount](int target)
+        { return target < 0 || target >= vertexCount; };
+        if (std::any_of(targets.begin() + begin, targets.begin() + end, outside))
+        {
+            inRange = false;
+        } });
+    return inRange;
+}
+
+/**
+ * @brief Checks whether a file starts with the graph cache magic bytes.
+ *
+ * @param filename The file to inspect.
+ * @return true if the file looks like a graph cache, false otherwise.
+ */
+inline bool isGraphCache(const std::string &filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+    char magic[sizeof(GRAPH_CACHE_MAGIC)] = {};
+    file.read(magic, sizeof(magic));
+    return file && std::memcmp(magic, GRAPH_CACHE_MAGIC, sizeof(magic)) == 0;
+}
+
+/**
+ * @brief Maps a graph cache file and returns a graph that views it without copying.
+ *
+ * The header, the array bounds, the arc offsets and the arc targets are always
+ * validated, so a damaged file cannot make a search read outside the mapping.
+ * Verifying the checksum also catches damaged weights, but it reads every page
+ * of the file, so it is optional and meant for a one-off integrity check rather
+ * than for every start-up.
+ *
+ * @param filename The graph cache file.
+ * @param verifyChecksum Whether to recompute and compare the payload checksum.
+ * @return The mapped graph.
+ * @throws std::runtime_error If the file is not a valid graph cache.
+ */
+inline Graph loadGraphCache(const std::string &filename, bool verifyChecksum = false)
+{
+    auto file = std::make_shared<MappedFile>(filename);
+
+    GraphCacheHeader header{};
+    if (file->size() < sizeof(header))
+    {
+        throw std::runtime_error(filename + ": file too small for a graph cache header");
+    }
+    std::memcpy(&header, file->data(), sizeof(header));
+
+    if (std::memcmp(header.magic, GRAPH_CACHE_MAGIC, sizeof(header.magic)) != 0)
+    {
+        throw std::runtime_error(filename + ": not a graph cache file");
+    }
+    if (header.byteOrder != GRAPH_CACHE_BYTE_ORDER)
+    {
+        throw std::runtime_error(filename + ": graph cache was written with a different byte order");
+    }
+    if (header.version != GRAPH_CACHE_VERSION)
+    {
+        throw std::runtime_error(filename + ": unsupported graph cache version " + std::to_string(header.version));
+    }
+    if (header.vertexCount >= static_cast<uint64_t>(std::numeric_limits<int>::max()) ||
+        header.arcCount > static_cast<uint64_t>(std::numeric_limits<int>::max()))
+    {
+        throw std::runtime_error(filename + ": graph too large");
+    }
+
+    auto [offsets, targets, weights] = mapAlignedSections<3>(*file, {header.offsetsPosition, header.targetsPosition, header.weightsPosition},
+                                                             {header.vertexCount + 1, header.arcCount, header.arcCount}, filename);
+
+    if (offsets.front() != 0 || static_cast<uint64_t>(offsets.back()) != header.arcCount ||
+        !std::is_sorted(offsets.begin(), offsets.end()))
+    {
+        throw std::runtime_error(filename + ": inconsistent arc offsets");
+    }
+    if (!arcTargetsInRange(targets, static_cast<int>(header.vertexCount)))
+    {
+        throw std::runtime_error(filename + ": arc target outside the graph");
+    }
+    if (verifyChecksum && graphCacheChecksum(offsets, targets, weights) != header.checksum)
+    {
+        throw std::runtime_error(filename + ": checksum mismatch");
+    }
+
+    return Graph(std::move(file), offsets, targets, weights);
+}
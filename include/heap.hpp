@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <stdexcept>
+#include <type_traits>
 
 /**
  * @file heap.hpp
@@ -42,8 +43,84 @@ public:
      */
     virtual bool empty() const = 0;
 
+    /**
+     * @brief Removes all elements at once.
+     *
+     * Implementations keep their storage (arrays, node slabs), so a heap that
+     * is cleared and reused for the next query does not allocate again.
+     */
+    virtual void clear() = 0;
+
     /**
      * @brief Virtual destructor for the Heap class.
      */
     virtual ~Heap() = default;
-};
\ No newline at end of file
+};
+
+/**
+ * @struct HeapKey
+ * @brief Maps an element to the integer it is ordered by.
+ *
+ * Heaps that work on raw integer keys rather than on comparisons (SIMD child
+ * selection, bucket and radix queues) use this trait. It is enabled for integral
+ * element types; record types ordered by a single integer field specialize it
+ * (see NearestRecord in pathfinder.hpp).
+ *
+ * @tparam T The type of elements stored in the heap.
+ */
+template <typename T>
+struct HeapKey
+{
+    static constexpr bool enabled = std::is_integral_v<T>;
+
+    static T get(const T &value)
+    {
+        return value;
+    }
+};
+
+/**
+ * @class AddressableHeap
+ * @brief A heap whose elements can be reached through handles after insertion.
+ *
+ * Inserting returns a handle that stays valid until the element is popped. The
+ * handle allows the key of a queued element to be lowered in place, which is the
+ * operation Dijkstra's algorithm needs when it finds a shorter path to a vertex
+ * that is still in the queue.
+ *
+ * @tparam T The type of elements stored in the heap.
+ * @tparam Handle The type of the handle returned by insert().
+ */
+template <typename T, typename Handle>
+class AddressableHeap : public Heap<T>
+{
+public:
+    using handle_type = Handle;
+
+    /**
+     * @brief Inserts a new element into the heap.
+     *
+     * @param value The element to be inserted.
+     * @return A handle to the inserted element.
+     */
+    virtual Handle insert(const T &value) = 0;
+
+    /**
+     * @brief Replaces the value of a queued element by a smaller or equal one.
+     *
+     * @param handle The handle returned when the element was inserted.
+     * @param value The new value, which must not be greater than the current one.
+     * @throws std::invalid_argument If the new value is greater than the current one.
+     */
+    virtual void decrease_key(Handle handle, const T &value) = 0;
+
+    /**
+     * @brief Inserts a new element into the heap, discarding its handle.
+     *
+     * @param value The element to be inserted.
+     */
+    void push(const T &value) override
+    {
+        insert(value);
+    }
+};
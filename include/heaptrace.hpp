@@ -0,0 +1,521 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "binaryheap.hpp"
+#include "graphcache.hpp"
+#include "pathfinder.hpp"
+
+/**
+ * @file heaptrace.hpp
+ * @brief Recorded sequences of heap operations, for timing the heaps apart from the graph.
+ *
+ * A search run through a RecordingHeap leaves behind the exact sequence of its
+ * pushes (with key and vertex), pops and clears. Replaying that sequence on
+ * another heap repeats the heap's share of the work without the graph's memory
+ * traffic, so the heaps can be compared on their own. Synthetic traces with
+ * known key patterns complement the recorded ones.
+ *
+ * Traces are stored as a stream of LEB128 varints, which keeps a recording of
+ * thousands of road network queries small:
+ *
+ *     pop       1
+ *     clear     2
+ *     push      zigzag(key - previous pushed key) << 2, then the vertex
+ *
+ * The previous key starts at 0 after every clear. Popped elements are not
+ * stored: whichever heap replays the trace, the popped keys follow from the
+ * pushes, and replayHeapTrace() folds them into a checksum.
+ *
+ * File layout (header integers in the byte order of the machine that wrote it,
+ * marked with GRAPH_CACHE_BYTE_ORDER like the graph cache):
+ *
+ *     HeapTraceHeader               48 bytes
+ *     encoded operations            HeapTraceHeader::bytes bytes
+ */
+
+// Magic bytes at the start of every heap trace file
+inline constexpr char HEAP_TRACE_MAGIC[8] = {'P', 'F', 'T', 'R', 'A', 'C', 'E', '\0'};
+
+// Format version; bump it whenever the encoding changes
+inline constexpr uint32_t HEAP_TRACE_VERSION = 1;
+
+/**
+ * @struct HeapTraceHeader
+ * @brief The fixed-size header at the start of a heap trace file.
+ */
+struct HeapTraceHeader
+{
+    char magic[8];       ///< HEAP_TRACE_MAGIC.
+    uint32_t version;    ///< HEAP_TRACE_VERSION.
+    uint32_t byteOrder;  ///< GRAPH_CACHE_BYTE_ORDER.
+    uint64_t operations; ///< Number of operations.
+    uint64_t pushes;     ///< Number of pushes among them.
+    uint64_t clears;     ///< Number of clears among them; a recorded search clears once per query.
+    uint64_t bytes;      ///< Size of the encoded operations.
+};
+
+static_assert(sizeof(HeapTraceHeader) == 48, "HeapTraceHeader must stay 48 bytes");
+
+/**
+ * @enum HeapOperationKind
+ * @brief The operations a trace records.
+ */
+enum class HeapOperationKind : uint8_t
+{
+    Push,
+    Pop,
+    Clear
+};
+
+/**
+ * @struct HeapOperation
+ * @brief One decoded operation; key and vertex are only meaningful for pushes.
+ */
+struct HeapOperation
+{
+    HeapOperationKind kind = HeapOperationKind::Pop;
+    int key = 0;
+    int vertex = 0;
+};
+
+/**
+ * @class HeapTrace
+ * @brief An encoded sequence of heap operations.
+ */
+class HeapTrace
+{
+public:
+    HeapTrace() : encoded(), previousKey(0), totalOperations(0), totalPushes(0), totalClears(0) {}
+
+    /**
+     * @brief Wraps operations encoded by another trace, as read back from a file.
+     *
+     * @throws std::runtime_error If the bytes do not decode to the given counts.
+     */
+    HeapTrace(std::vector<uint8_t> bytes, uint64_t operations, uint64_t pushes, uint64_t clears)
+        : encoded(std::move(bytes)), previousKey(0), totalOperations(operations), totalPushes(pushes), totalClears(clears)
+    {
+        std::vector<HeapOperation> decoded = this->operations();
+        uint64_t decodedPushes = 0;
+        uint64_t decodedClears = 0;
+        for (const HeapOperation &operation : decoded)
+        {
+            decodedPushes += operation.kind == HeapOperationKind::Push;
+            decodedClears += operation.kind == HeapOperationKind::Clear;
+            // Pushes appended to a loaded trace continue its key deltas
+            if (operation.kind != HeapOperationKind::Pop)
+            {
+                previousKey = operation.key;
+            }
+        }
+        if (decoded.size() != operations || decodedPushes != pushes || decodedClears != clears)
+        {
+            throw std::runtime_error("Heap trace does not match its operation counts");
+        }
+    }
+
+    void push(int key, int vertex)
+    {
+        appendVarint(zigzag(static_cast<int64_t>(key) - previousKey) << 2);
+        appendVarint(static_cast<uint32_t>(vertex));
+        previousKey = key;
+        totalOperations++;
+        totalPushes++;
+    }
+
+    void pop()
+    {
+        encoded.push_back(1);
+        totalOperations++;
+    }
+
+    void clear()
+    {
+        encoded.push_back(2);
+        previousKey = 0;
+        totalOperations++;
+        totalClears++;
+    }
+
+    // The number of recorded operations
+    uint64_t operationCount() const
+    {
+        return totalOperations;
+    }
+
+    // The number of pushes among them
+    uint64_t pushCount() const
+    {
+        return totalPushes;
+    }
+
+    // The number of clears among them
+    uint64_t clearCount() const
+    {
+        return totalClears;
+    }
+
+    // The encoded operations, as stored in a trace file
+    const std::vector<uint8_t> &bytes() const
+    {
+        return encoded;
+    }
+
+    /**
+     * @brief Decodes the trace, so a replay does not pay for the decoding.
+     *
+     * @throws std::runtime_error If the encoding is truncated or malformed.
+     */
+    std::vector<HeapOperation> operations() const
+    {
+        std::vector<HeapOperation> decoded;
+        decoded.reserve(totalOperations);
+        size_t position = 0;
+        int64_t key = 0;
+        while (position < encoded.size())
+        {
+            uint64_t word = readVarint(position);
+            if (word == 1)
+            {
+                decoded.push_back({HeapOperationKind::Pop, 0, 0});
+            }
+            else if (word == 2)
+            {
+                decoded.push_back({HeapOperationKind::Clear, 0, 0});
+                key = 0;
+            }
+            else if ((word & 3) == 0)
+            {
+                uint64_t delta = word >> 2;
+                key += static_cast<int64_t>(delta >> 1) ^ -static_cast<int64_t>(delta & 1);
+                uint64_t vertex = readVarint(position);
+                if (key < 0 || key > INF || vertex > static_cast<uint64_t>(INF))
+                {
+                    throw std::runtime_error("Heap trace push out of range");
+                }
+                decoded.push_back({HeapOperationKind::Push, static_cast<int>(key), static_cast<int>(vertex)});
+            }
+            else
+            {
+                throw std::runtime_error("Unknown heap trace operation");
+            }
+        }
+        return decoded;
+    }
+
+private:
+    std::vector<uint8_t> encoded; ///< The varint stream.
+    int64_t previousKey;          ///< Key of the last push since the last clear, 0 if none.
+    uint64_t totalOperations;     ///< Number of operations.
+    uint64_t totalPushes;         ///< Number of pushes.
+    uint64_t totalClears;         ///< Number of clears.
+
+    // Map signed deltas to unsigned ones, small magnitudes to small numbers
+    static uint64_t zigzag(int64_t value)
+    {
+        return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    }
+
+    void appendVarint(uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            encoded.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        encoded.push_back(static_cast<uint8_t>(value));
+    }
+
+    uint64_t readVarint(size_t &position) const
+    {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            if (position == encoded.size())
+            {
+                throw std::runtime_error("Heap trace ends inside an operation");
+            }
+            uint8_t byte = encoded[position++];
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0)
+            {
+                return value;
+            }
+        }
+        throw std::runtime_error("Heap trace varint too long");
+    }
+};
+
+/**
+ * @brief Writes a trace to disk in the heap trace format.
+ *
+ * @param trace The trace to write.
+ * @param filename The output file, which is overwritten.
+ * @throws std::runtime_error If the file cannot be written.
+ */
+inline void writeHeapTrace(const HeapTrace &trace, const std::string &filename)
+{
+    HeapTraceHeader header{};
+    std::memcpy(header.magic, HEAP_TRACE_MAGIC, sizeof(header.magic));
+    header.version = HEAP_TRACE_VERSION;
+    header.byteOrder = GRAPH_CACHE_BYTE_ORDER;
+    header.operations = trace.operationCount();
+    header.pushes = trace.pushCount();
+    header.clears = trace.clearCount();
+    header.bytes = trace.bytes().size();
+
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Error opening " + filename + " for writing");
+    }
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(trace.bytes().data()), static_cast<std::streamsize>(trace.bytes().size()));
+    if (!file)
+    {
+        throw std::runtime_error("Error writing " + filename);
+    }
+}
+
+/**
+ * @brief Reads a trace written by writeHeapTrace().
+ *
+ * @param filename The trace file.
+ * @return The trace, checked to decode to the counts of its header.
+ * @throws std::runtime_error If the file is not a valid heap trace.
+ */
+inline HeapTrace loadHeapTrace(const std::string &filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Error opening " + filename);
+    }
+
+    HeapTraceHeader header{};
+    if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)))
+    {
+        throw std::runtime_error(filename + ": file too small for a heap trace header");
+    }
+    if (std::memcmp(header.magic, HEAP_TRACE_MAGIC, sizeof(header.magic)) != 0)
+    {
+        throw std::runtime_error(filename + ": not a heap trace file");
+    }
+    if (header.byteOrder != GRAPH_CACHE_BYTE_ORDER)
+    {
+        throw std::runtime_error(filename + ": heap trace was written with a different byte order");
+    }
+    if (header.version != HEAP_TRACE_VERSION)
+    {
+        throw std::runtime_error(filename + ": unsupported heap trace version " + std::to_string(header.version));
+    }
+
+    // Check the size before allocating, so a damaged header cannot ask for an arbitrary amount of memory
+    file.seekg(0, std::ios::end);
+    auto remaining = static_cast<uint64_t>(file.tellg()) - sizeof(header);
+    if (header.bytes != remaining)
+    {
+        throw std::runtime_error(filename + ": heap trace size does not match its header");
+    }
+    file.seekg(sizeof(header));
+    std::vector<uint8_t> bytes(header.bytes);
+    if (!file.read(reinterpret_cast<char *>(bytes.data()), static_cast<std::streamsize>(bytes.size())))
+    {
+        throw std::runtime_error("Error reading " + filename);
+    }
+    try
+    {
+        return HeapTrace(std::move(bytes), header.operations, header.pushes, header.clears);
+    }
+    catch (const std::runtime_error &e)
+    {
+        throw std::runtime_error(filename + ": " + e.what());
+    }
+}
+
+/**
+ * @class RecordingHeap
+ * @brief A heap that passes every operation on to another heap and records it.
+ *
+ * Run dijkstra<RecordingHeap<>> to record the heap operations of its queries;
+ * the workspace clears the heap before every query, so each query starts with
+ * a clear in the trace.
+ *
+ * @tparam PriorityQueue The heap that does the work.
+ */
+template <typename PriorityQueue = BinaryHeap<NearestRecord>>
+class RecordingHeap : public Heap<NearestRecord>
+{
+public:
+    RecordingHeap() : pq(), recorded() {}
+
+    void push(const NearestRecord &value) override
+    {
+        recorded.push(value.dist, value.vertex);
+        pq.push(value);
+    }
+
+    NearestRecord pop() override
+    {
+        recorded.pop();
+        return pq.pop();
+    }
+
+    bool empty() const override
+    {
+        return pq.empty();
+    }
+
+    void clear() override
+    {
+        recorded.clear();
+        pq.clear();
+    }
+
+    // The operations so far
+    const HeapTrace &trace() const
+    {
+        return recorded;
+    }
+
+private:
+    PriorityQueue pq;   ///< The heap that does the work.
+    HeapTrace recorded; ///< Every operation on it.
+};
+
+/**
+ * @enum HeapPattern
+ * @brief The key patterns of synthetic traces.
+ */
+enum class HeapPattern
+{
+    Monotone,  ///< Every push is at least the last popped key, as in Dijkstra's algorithm.
+    Random,    ///< Uniformly random keys; not valid for the monotone heaps (radix, buckets).
+    Duplicates ///< Monotone, with most keys equal to the last popped one.
+};
+
+/**
+ * @brief Parses "monotone", "random" or "duplicates".
+ *
+ * @throws std::invalid_argument If the name is unknown.
+ */
+inline HeapPattern parseHeapPattern(const std::string &name)
+{
+    if (name == "monotone")
+    {
+        return HeapPattern::Monotone;
+    }
+    if (name == "random")
+    {
+        return HeapPattern::Random;
+    }
+    if (name == "duplicates")
+    {
+        return HeapPattern::Duplicates;
+    }
+    throw std::invalid_argument("Unknown heap pattern " + name);
+}
+
+/**
+ * @brief Builds a synthetic trace of one long query.
+ *
+ * Pushes outnumber pops in the first half and pops outnumber pushes in the
+ * second, so the heap grows and shrinks again the way a search frontier does;
+ * whatever is left at the end is popped.
+ *
+ * @param pattern The keys to push.
+ * @param steps The number of pushes and pops before the heap is emptied.
+ * @param seed Seed of the random choices.
+ * @return The trace, starting with a clear.
+ */
+inline HeapTrace syntheticHeapTrace(HeapPattern pattern, size_t steps, unsigned seed)
+{
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<double> coin(0.0, 1.0);
+    std::uniform_int_distribution<int> weight(0, 1000);
+    std::uniform_int_distribution<int> anyKey(0, 1 << 30);
+    std::priority_queue<int, std::vector<int>, std::greater<int>> keys;
+    HeapTrace trace;
+    int lastPopped = 0;
+    int vertex = 0;
+
+    trace.clear();
+    auto pop = [&]
+    {
+        lastPopped = keys.top();
+        keys.pop();
+        trace.pop();
+    };
+    for (size_t step = 0; step < steps; step++)
+    {
+        double pushChance = step < steps / 2 ? 0.6 : 0.4;
+        if (!keys.empty() && coin(random) >= pushChance)
+        {
+            pop();
+            continue;
+        }
+        int key = lastPopped;
+        switch (pattern)
+        {
+        case HeapPattern::Monotone:
+            key += weight(random);
+            break;
+        case HeapPattern::Random:
+            key = anyKey(random);
+            break;
+        case HeapPattern::Duplicates:
+            key += coin(random) < 0.05 ? 1 : 0;
+            break;
+        }
+        keys.push(key);
+        trace.push(key, vertex++);
+    }
+    while (!keys.empty())
+    {
+        pop();
+    }
+    return trace;
+}
+
+/**
+ * @brief Runs decoded operations on a heap of NearestRecord.
+ *
+ * The trace must only pop when the heap holds elements, which recorded and
+ * synthetic traces do. The popped keys are the same for every correct heap,
+ * whatever order it gives equal keys, so the checksum doubles as a check.
+ *
+ * @param operations The operations, from HeapTrace::operations().
+ * @param pq The heap.
+ * @return A hash of the sequence of popped keys.
+ */
+template <typename PriorityQueue>
+uint64_t replayHeapTrace(const std::vector<HeapOperation> &operations, PriorityQueue &pq)
+{
+    uint64_t checksum = 0;
+    for (const HeapOperation &operation : operations)
+    {
+        switch (operation.kind)
+        {
+        case HeapOperationKind::Push:
+            pq.push({operation.key, operation.vertex});
+            break;
+        case HeapOperationKind::Pop:
+            checksum = checksum * 31 + static_cast<uint64_t>(pq.pop().dist);
+            break;
+        case HeapOperationKind::Clear:
+            pq.clear();
+            break;
+        }
+    }
+    return checksum;
+}
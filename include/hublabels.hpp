@@ -0,0 +1,589 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "alignedallocator.hpp"
+#include "contractionhierarchy.hpp"
+#include "graphcache.hpp"
+#include "mappedfile.hpp"
+#include "parallel.hpp"
+
+/**
+ * @file hublabels.hpp
+ * @brief Hub labeling derived from a contraction hierarchy (Abraham, Delling, Goldberg and Werneck).
+ *
+ * Every vertex v stores a forward label, hubs h with the distance d(v, h), and a
+ * backward label, hubs h with d(h, v). The labels are chosen such that for every
+ * pair s, t some hub on a shortest s-t path is in both the forward label of s and
+ * the backward label of t, so
+ *
+ *     d(s, t) = min over common hubs h of d(s, h) + d(h, t),
+ *
+ * and a query is a merge of two sorted arrays without any graph search. The hubs
+ * of a vertex are the vertices of its upward search space in the hierarchy,
+ * minus those to which the upward search does not find the true distance.
+ *
+ * Hubs are identified by their rank and sorted by it. Hubs and distances are
+ * kept in separate arrays; every label starts on a 64-byte cache line and is
+ * padded to whole lines with sentinel hubs that never match, so the merge can
+ * compare blocks of 8 hubs at a time with AVX2.
+ *
+ * Label file layout (all integers in the byte order of the writer; every array
+ * starts on a 64-byte boundary, in this order):
+ *
+ *     HubLabelHeader                           64 bytes
+ *     forward offsets, hubs, distances         offsets in cache lines of HUB_LABEL_LINE entries
+ *     backward offsets, hubs, distances
+ */
+
+// Number of entries per 64-byte line; every label starts on a line and fills whole lines
+inline constexpr int HUB_LABEL_LINE = 16;
+
+// Hubs that pad forward and backward labels; they differ, so padding never matches padding
+inline constexpr int HUB_LABEL_FORWARD_PADDING = std::numeric_limits<int>::max();
+inline constexpr int HUB_LABEL_BACKWARD_PADDING = std::numeric_limits<int>::max() - 1;
+
+/**
+ * @class HubLabels
+ * @brief The forward and backward labels of every vertex of a graph.
+ *
+ * Like Graph, the arrays are views into storage that is either owned or a
+ * memory-mapped label file, and copies share it. Queries keep no state, so
+ * one HubLabels serves any number of threads.
+ */
+class HubLabels
+{
+public:
+    using Array = std::span<const int>;
+
+    /**
+     * @brief Constructs empty labels for a graph without vertices.
+     */
+    HubLabels() : storage(), forwardOffsets(), forwardHubs(), forwardDistances(), backwardOffsets(), backwardHubs(), backwardDistances() {}
+
+    /**
+     * @brief Adopts label arrays that live in externally managed memory.
+     *
+     * The label of vertex v occupies lines [offsets[v], offsets[v + 1]) of the hub
+     * and distance arrays; the arrays must start on a 64-byte boundary.
+     */
+    HubLabels(std::shared_ptr<const void> storage, Array forwardOffsets, Array forwardHubs, Array forwardDistances,
+              Array backwardOffsets, Array backwardHubs, Array backwardDistances)
+        : storage(std::move(storage)), forwardOffsets(forwardOffsets), forwardHubs(forwardHubs), forwardDistances(forwardDistances),
+          backwardOffsets(backwardOffsets), backwardHubs(backwardHubs), backwardDistances(backwardDistances)
+    {
+    }
+
+    int vertexCount() const
+    {
+        return static_cast<int>(forwardOffsets.size()) - 1;
+    }
+
+    /**
+     * @brief Returns the length of the shortest path from start to destination, or INF if there is none.
+     */
+    int distance(int start, int destination) const
+    {
+        auto a = static_cast<size_t>(forwardOffsets[start]) * HUB_LABEL_LINE;
+        auto aEnd = static_cast<size_t>(forwardOffsets[start + 1]) * HUB_LABEL_LINE;
+        auto b = static_cast<size_t>(backwardOffsets[destination]) * HUB_LABEL_LINE;
+        auto bEnd = static_cast<size_t>(backwardOffsets[destination + 1]) * HUB_LABEL_LINE;
+        return merge(forwardHubs.data() + a, forwardDistances.data() + a, aEnd - a,
+                     backwardHubs.data() + b, backwardDistances.data() + b, bEnd - b);
+    }
+
+    /**
+     * @brief Returns the total number of label entries, padding included, in both directions.
+     */
+    size_t entryCount() const
+    {
+        return forwardHubs.size() + backwardHubs.size();
+    }
+
+    /**
+     * @brief Raw access to the arrays, used when serializing the labels.
+     */
+    std::array<Array, 6> arrays() const
+    {
+        return {forwardOffsets, forwardHubs, forwardDistances, backwardOffsets, backwardHubs, backwardDistances};
+    }
+
+    /**
+     * @brief Returns the smallest sum of distances over the hubs two sorted, padded labels share.
+     *
+     * @param hubsA, distancesA, countA The first label; count is a multiple of 8.
+     * @param hubsB, distancesB, countB The second label.
+     * @return The minimum, or INF if the labels share no hub.
+     */
+    static int merge(const int *hubsA, const int *distancesA, size_t countA,
+                     const int *hubsB, const int *distancesB, size_t countB);
+
+private:
+    std::shared_ptr<const void> storage; ///< Keeps the memory behind the spans alive.
+    Array forwardOffsets;                ///< First line of the forward label of every vertex; n + 1 entries.
+    Array forwardHubs;                   ///< Ranks of the forward hubs, ascending per label.
+    Array forwardDistances;              ///< d(v, hub), parallel to forwardHubs.
+    Array backwardOffsets;               ///< First line of the backward label of every vertex; n + 1 entries.
+    Array backwardHubs;                  ///< Ranks of the backward hubs, ascending per label.
+    Array backwardDistances;             ///< d(hub, v), parallel to backwardHubs.
+};
+
+inline int HubLabels::merge(const int *hubsA, const int *distancesA, size_t countA,
+                            const int *hubsB, const int *distancesB, size_t countB)
+{
+    size_t i = 0;
+    size_t j = 0;
+#if defined(__AVX2__)
+    // Compare a block of 8 hubs with all 8 rotations of the other block; the block
+    // whose last hub is smaller cannot match anything further on and moves ahead
+    const __m256i infinity = _mm256_set1_epi32(INF);
+    const __m256i rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+    __m256i best = infinity;
+    while (i < countA && j < countB)
+    {
+        __m256i a = _mm256_load_si256(reinterpret_cast<const __m256i *>(hubsA + i));
+        __m256i da = _mm256_load_si256(reinterpret_cast<const __m256i *>(distancesA + i));
+        __m256i b = _mm256_load_si256(reinterpret_cast<const __m256i *>(hubsB + j));
+        __m256i db = _mm256_load_si256(reinterpret_cast<const __m256i *>(distancesB + j));
+        for (int r = 0; r < 8; r++)
+        {
+            __m256i match = _mm256_cmpeq_epi32(a, b);
+            __m256i sum = _mm256_add_epi32(da, db);
+            best = _mm256_min_epi32(best, _mm256_blendv_epi8(infinity, sum, match));
+            b = _mm256_permutevar8x32_epi32(b, rotate);
+            db = _mm256_permutevar8x32_epi32(db, rotate);
+        }
+        int lastA = hubsA[i + 7];
+        int lastB = hubsB[j + 7];
+        i += lastA <= lastB ? 8 : 0;
+        j += lastB <= lastA ? 8 : 0;
+    }
+    best = _mm256_min_epi32(best, _mm256_permute2x128_si256(best, best, 1));
+    best = _mm256_min_epi32(best, _mm256_shuffle_epi32(best, 0x4E));
+    best = _mm256_min_epi32(best, _mm256_shuffle_epi32(best, 0xB1));
+    return _mm256_cvtsi256_si32(best);
+#else
+    int best = INF;
+    while (i < countA && j < countB)
+    {
+        if (hubsA[i] < hubsB[j])
+        {
+            i++;
+        }
+        else if (hubsB[j] < hubsA[i])
+        {
+            j++;
+        }
+        else
+        {
+            best = std::min(best, distancesA[i] + distancesB[j]);
+            i++;
+            j++;
+        }
+    }
+    return best;
+#endif
+}
+
+/**
+ * @class HubLabelBuilder
+ * @brief Computes the labels of a contraction hierarchy, top level first.
+ *
+ * The forward label of v merges the forward labels of its upward neighbours,
+ * shifted by the arc weights, and adds v itself. An entry (h, d) is then
+ * dropped if some other hub h' already proves d(v, h') + d(h', h) < d, using
+ * the backward label of h. Labels only depend on labels of vertices higher in
+ * the hierarchy, so the vertices are grouped into levels, where each level
+ * only looks at the levels above it, and every level is labelled in parallel.
+ */
+class HubLabelBuilder
+{
+public:
+    /**
+     * @param hierarchy The contraction hierarchy.
+     * @param threads The number of threads.
+     */
+    HubLabelBuilder(const ContractionHierarchy &hierarchy, int threads)
+        : hierarchy(hierarchy), n(hierarchy.vertexCount()), threads(std::max(1, threads)), vertexOfRank(static_cast<size_t>(n)),
+          forward(static_cast<size_t>(n)), backward(static_cast<size_t>(n)), scratch(static_cast<size_t>(this->threads))
+    {
+        for (int v = 0; v < n; v++)
+        {
+            vertexOfRank[hierarchy.rank(v)] = v;
+        }
+    }
+
+    /**
+     * @brief Computes every label and packs them into aligned arrays.
+     */
+    HubLabels build();
+
+private:
+    /**
+     * @struct Entry
+     * @brief One hub of a label under construction.
+     */
+    struct Entry
+    {
+        int hub;      ///< The rank of the hub.
+        int distance; ///< The distance between the vertex and the hub.
+    };
+
+    /**
+     * @struct Scratch
+     * @brief Per-thread buffers of the label computation.
+     */
+    struct Scratch
+    {
+        std::vector<Entry> candidates; ///< Merged labels of the upward neighbours.
+        std::vector<int> distanceByHub; ///< Candidate distance per hub rank, INF elsewhere.
+
+        Scratch() : candidates(), distanceByHub() {}
+    };
+
+    const ContractionHierarchy &hierarchy;
+    int n;
+    int threads;
+    std::vector<int> vertexOfRank;
+    std::vector<std::vector<Entry>> forward;  ///< Forward label per vertex, by ascending hub.
+    std::vector<std::vector<Entry>> backward; ///< Backward label per vertex, by ascending hub.
+    std::vector<Scratch> scratch;
+
+    // Compute the label of v from the labels of its neighbours in the upward search graph g;
+    // opposite holds the labels of the other direction, used to prune
+    void computeLabel(int v, const Graph &g, std::vector<std::vector<Entry>> &labels,
+                      const std::vector<std::vector<Entry>> &opposite, Scratch &buffers) const;
+
+    // Copy the labels into line-aligned, padded arrays
+    static void pack(const std::vector<std::vector<Entry>> &labels, int padding, std::vector<int> &offsets,
+                     std::vector<int, AlignedAllocator<int, 64>> &hubs, std::vector<int, AlignedAllocator<int, 64>> &distances);
+};
+
+inline void HubLabelBuilder::computeLabel(int v, const Graph &g, std::vector<std::vector<Entry>> &labels,
+                                          const std::vector<std::vector<Entry>> &opposite, Scratch &buffers) const
+{
+    std::vector<Entry> &candidates = buffers.candidates;
+    std::vector<int> &distanceByHub = buffers.distanceByHub;
+    if (distanceByHub.empty())
+    {
+        distanceByHub.assign(static_cast<size_t>(n), INF);
+    }
+
+    // The shortest candidate distance per hub; v reaches itself at 0
+    candidates.clear();
+    candidates.push_back({hierarchy.rank(v), 0});
+    distanceByHub[hierarchy.rank(v)] = 0;
+    for (int e = g.beginArc(v), last = g.endArc(v); e < last; e++)
+    {
+        for (const Entry &entry : labels[g.target(e)])
+        {
+            int distance = entry.distance + g.weight(e);
+            int &known = distanceByHub[entry.hub];
+            if (known == INF)
+            {
+                candidates.push_back({entry.hub, distance});
+            }
+            known = std::min(known, distance);
+        }
+    }
+
+    // Keep a hub only if no other hub leads to it on a strictly shorter path
+    std::vector<Entry> label;
+    for (const Entry &candidate : candidates)
+    {
+        int distance = distanceByHub[candidate.hub];
+        bool dominated = false;
+        for (const Entry &via : opposite[vertexOfRank[candidate.hub]])
+        {
+            int first = distanceByHub[via.hub];
+            if (first != INF && first + via.distance < distance)
+            {
+                dominated = true;
+                break;
+            }
+        }
+        if (!dominated)
+        {
+            label.push_back({candidate.hub, distance});
+        }
+    }
+    for (const Entry &candidate : candidates)
+    {
+        distanceByHub[candidate.hub] = INF;
+    }
+
+    std::sort(label.begin(), label.end(), [](const Entry &a, const Entry &b)
+              { return a.hub < b.hub; });
+    labels[v] = std::move(label);
+}
+
+inline void HubLabelBuilder::pack(const std::vector<std::vector<Entry>> &labels, int padding, std::vector<int> &offsets,
+                                  std::vector<int, AlignedAllocator<int, 64>> &hubs, std::vector<int, AlignedAllocator<int, 64>> &distances)
+{
+    offsets.assign(labels.size() + 1, 0);
+    size_t lines = 0;
+    for (size_t v = 0; v < labels.size(); v++)
+    {
+        lines += (labels[v].size() + HUB_LABEL_LINE - 1) / HUB_LABEL_LINE;
+        if (lines > static_cast<size_t>(std::numeric_limits<int>::max()))
+        {
+            throw std::length_error("Hub labels too large");
+        }
+        offsets[v + 1] = static_cast<int>(lines);
+    }
+
+    hubs.assign(lines * HUB_LABEL_LINE, padding);
+    distances.assign(lines * HUB_LABEL_LINE, 0);
+    for (size_t v = 0; v < labels.size(); v++)
+    {
+        auto position = static_cast<size_t>(offsets[v]) * HUB_LABEL_LINE;
+        for (const Entry &entry : labels[v])
+        {
+            hubs[position] = entry.hub;
+            distances[position] = entry.distance;
+            position++;
+        }
+    }
+}
+
+inline HubLabels HubLabelBuilder::build()
+{
+    // Level 0 holds vertices without upward arcs; every other vertex sits one level below its highest neighbour
+    const Graph &up = hierarchy.upward();
+    const Graph &down = hierarchy.downward();
+    std::vector<int> level(static_cast<size_t>(n), 0);
+    int levels = n > 0 ? 1 : 0;
+    for (int rank = n - 1; rank >= 0; rank--)
+    {
+        int v = vertexOfRank[rank];
+        for (const Graph *g : {&up, &down})
+        {
+            for (int e = g->beginArc(v), last = g->endArc(v); e < last; e++)
+            {
+                level[v] = std::max(level[v], level[g->target(e)] + 1);
+            }
+        }
+        levels = std::max(levels, level[v] + 1);
+    }
+
+    // Bucket the vertices by level
+    std::vector<int> levelStart(static_cast<size_t>(levels) + 1, 0);
+    for (int v = 0; v < n; v++)
+    {
+        levelStart[level[v] + 1]++;
+    }
+    for (int l = 0; l < levels; l++)
+    {
+        levelStart[l + 1] += levelStart[l];
+    }
+    std::vector<int> byLevel(static_cast<size_t>(n));
+    std::vector<int> cursor(levelStart.begin(), levelStart.end() - 1);
+    for (int v = 0; v < n; v++)
+    {
+        byLevel[cursor[level[v]]++] = v;
+    }
+
+    for (int l = 0; l < levels; l++)
+    {
+        parallelForStealing(threads, levelStart[l + 1] - levelStart[l], [&](int thread, long long i)
+                            {
+            int v = byLevel[static_cast<size_t>(levelStart[l] + i)];
+            Scratch &buffers = scratch[static_cast<size_t>(thread)];
+            computeLabel(v, up, forward, backward, buffers);
+            computeLabel(v, down, backward, forward, buffers); });
+    }
+
+    struct OwnedArrays
+    {
+        std::vector<int> forwardOffsets;
+        std::vector<int, AlignedAllocator<int, 64>> forwardHubs;
+        std::vector<int, AlignedAllocator<int, 64>> forwardDistances;
+        std::vector<int> backwardOffsets;
+        std::vector<int, AlignedAllocator<int, 64>> backwardHubs;
+        std::vector<int, AlignedAllocator<int, 64>> backwardDistances;
+
+        OwnedArrays() : forwardOffsets(), forwardHubs(), forwardDistances(), backwardOffsets(), backwardHubs(), backwardDistances() {}
+    };
+    auto owned = std::make_shared<OwnedArrays>();
+    pack(forward, HUB_LABEL_FORWARD_PADDING, owned->forwardOffsets, owned->forwardHubs, owned->forwardDistances);
+    pack(backward, HUB_LABEL_BACKWARD_PADDING, owned->backwardOffsets, owned->backwardHubs, owned->backwardDistances);
+
+    HubLabels::Array fo = owned->forwardOffsets, fh = owned->forwardHubs, fd = owned->forwardDistances;
+    HubLabels::Array bo = owned->backwardOffsets, bh = owned->backwardHubs, bd = owned->backwardDistances;
+    return HubLabels(std::move(owned), fo, fh, fd, bo, bh, bd);
+}
+
+/**
+ * @brief Computes the hub labels of a graph from its contraction hierarchy.
+ *
+ * @param hierarchy The contraction hierarchy.
+ * @param threads The number of threads.
+ * @return The labels.
+ */
+inline HubLabels buildHubLabels(const ContractionHierarchy &hierarchy, int threads = defaultThreadCount())
+{
+    return HubLabelBuilder(hierarchy, threads).build();
+}
+
+/**
+ * @brief Hub label query; see HubLabels::distance().
+ *
+ * @param start The starting vertex.
+ * @param destination The destination vertex.
+ * @param labels The hub labels of the graph.
+ *
+ * @return The shortest path length from the start vertex to the destination vertex, or INF if there is no path.
+ */
+inline int hub_label_query(int start, int destination, const HubLabels &labels)
+{
+    return labels.distance(start, destination);
+}
+
+// Magic bytes at the start of every hub label file
+inline constexpr char HUB_LABEL_MAGIC[8] = {'P', 'F', 'H', 'U', 'B', 'L', 'B', '\0'};
+
+// Format version; bump it whenever the layout changes
+inline constexpr uint32_t HUB_LABEL_VERSION = 1;
+
+/**
+ * @struct HubLabelHeader
+ * @brief The fixed-size header at the start of a hub label file.
+ */
+struct HubLabelHeader
+{
+    char magic[8];          ///< HUB_LABEL_MAGIC.
+    uint32_t version;       ///< HUB_LABEL_VERSION.
+    uint32_t byteOrder;     ///< GRAPH_CACHE_BYTE_ORDER.
+    uint64_t vertexCount;   ///< Number of vertices.
+    uint64_t forwardLines;  ///< Number of lines of the forward labels.
+    uint64_t backwardLines; ///< Number of lines of the backward labels.
+    uint64_t checksum;      ///< graphCacheChecksum() of the six arrays, in file order.
+    uint64_t reserved[2];   ///< Zero.
+};
+
+static_assert(sizeof(HubLabelHeader) == 64, "HubLabelHeader must stay 64 bytes");
+
+// The lengths of the six arrays of a label file, in file order
+inline std::array<uint64_t, 6> hubLabelSectionSizes(const HubLabelHeader &header)
+{
+    return {header.vertexCount + 1, header.forwardLines * HUB_LABEL_LINE, header.forwardLines * HUB_LABEL_LINE,
+            header.vertexCount + 1, header.backwardLines * HUB_LABEL_LINE, header.backwardLines * HUB_LABEL_LINE};
+}
+
+/**
+ * @brief Writes hub labels to disk.
+ *
+ * @param labels The labels to write.
+ * @param filename The output file, which is overwritten.
+ * @throws std::runtime_error If the file cannot be written.
+ */
+inline void writeHubLabels(const HubLabels &labels, const std::string &filename)
+{
+    std::array<std::span<const int>, 6> sections = labels.arrays();
+
+    HubLabelHeader header{};
+    std::memcpy(header.magic, HUB_LABEL_MAGIC, sizeof(header.magic));
+    header.version = HUB_LABEL_VERSION;
+    header.byteOrder = GRAPH_CACHE_BYTE_ORDER;
+    header.vertexCount = static_cast<uint64_t>(labels.vertexCount());
+    header.forwardLines = sections[1].size() / HUB_LABEL_LINE;
+    header.backwardLines = sections[4].size() / HUB_LABEL_LINE;
+    header.checksum = 0xcbf29ce484222325ULL;
+    for (std::span<const int> section : sections)
+    {
+        header.checksum = graphCacheChecksum(section, header.checksum);
+    }
+
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Error opening " + filename + " for writing");
+    }
+
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    writeAlignedSections(file, alignedSectionPositions(sizeof(header), hubLabelSectionSizes(header)), sections);
+
+    if (!file)
+    {
+        throw std::runtime_error("Error writing " + filename);
+    }
+}
+
+/**
+ * @brief Maps a hub label file and returns labels that view it without copying.
+ *
+ * @param filename The label file.
+ * @param verifyChecksum Whether to recompute and compare the payload checksum.
+ * @return The mapped labels.
+ * @throws std::runtime_error If the file is not a valid label file.
+ */
+inline HubLabels loadHubLabels(const std::string &filename, bool verifyChecksum = false)
+{
+    auto file = std::make_shared<MappedFile>(filename);
+
+    HubLabelHeader header{};
+    if (file->size() < sizeof(header))
+    {
+        throw std::runtime_error(filename + ": file too small for a hub label header");
+    }
+    std::memcpy(&header, file->data(), sizeof(header));
+
+    if (std::memcmp(header.magic, HUB_LABEL_MAGIC, sizeof(header.magic)) != 0)
+    {
+        throw std::runtime_error(filename + ": not a hub label file");
+    }
+    if (header.byteOrder != GRAPH_CACHE_BYTE_ORDER)
+    {
+        throw std::runtime_error(filename + ": hub labels were written with a different byte order");
+    }
+    if (header.version != HUB_LABEL_VERSION)
+    {
+        throw std::runtime_error(filename + ": unsupported hub label version " + std::to_string(header.version));
+    }
+    if (header.vertexCount >= static_cast<uint64_t>(std::numeric_limits<int>::max()) ||
+        header.forwardLines > static_cast<uint64_t>(std::numeric_limits<int>::max()) ||
+        header.backwardLines > static_cast<uint64_t>(std::numeric_limits<int>::max()))
+    {
+        throw std::runtime_error(filename + ": hub labels too large");
+    }
+
+    std::array<uint64_t, 6> sizes = hubLabelSectionSizes(header);
+    std::array<std::span<const int>, 6> sections = mapAlignedSections(*file, alignedSectionPositions(sizeof(header), sizes), sizes, filename);
+    for (size_t offsets : {size_t{0}, size_t{3}})
+    {
+        const std::span<const int> &lines = sections[offsets];
+        if (lines.front() != 0 || static_cast<uint64_t>(lines.back()) * HUB_LABEL_LINE != sizes[offsets + 1] ||
+            !std::is_sorted(lines.begin(), lines.end()))
+        {
+            throw std::runtime_error(filename + ": inconsistent label offsets");
+        }
+    }
+    if (verifyChecksum)
+    {
+        uint64_t checksum = 0xcbf29ce484222325ULL;
+        for (std::span<const int> section : sections)
+        {
+            checksum = graphCacheChecksum(section, checksum);
+        }
+        if (checksum != header.checksum)
+        {
+            throw std::runtime_error(filename + ": checksum mismatch");
+        }
+    }
+
+    return HubLabels(std::move(file), sections[0], sections[1], sections[2], sections[3], sections[4], sections[5]);
+}
@@ -0,0 +1,178 @@
+#pragma once
+
+#include "heap.hpp"
+#include "stats.hpp"
+
+/**
+ * @file indexedbinaryheap.hpp
+ * @brief A binary heap that supports decrease-key through integer handles.
+ */
+
+/**
+ * @class IndexedBinaryHeap
+ * @brief A binary heap whose elements can be updated in place.
+ *
+ * Every inserted element gets a slot number that serves as its handle. The heap
+ * array stores (value, slot) pairs and a position table maps every slot to its
+ * current index in the heap array, so decrease_key can find an element and sift
+ * it up in O(log n). Slots of popped elements are recycled.
+ *
+ * @tparam T The type of elements stored in the heap.
+ * @tparam Stats The operation counting policy; see stats.hpp.
+ */
+template <typename T, typename Stats = NoStats>
+class IndexedBinaryHeap : public AddressableHeap<T, int>
+{
+public:
+    IndexedBinaryHeap() : data(), position(), freeSlots(), counters() {}
+    int insert(const T &value) override;
+    void decrease_key(int slot, const T &value) override;
+    T pop() override;
+    bool empty() const override;
+    void clear() override;
+
+    Stats &stats()
+    {
+        return counters;
+    }
+
+private:
+    /**
+     * @struct Entry
+     * @brief An element of the heap array together with its slot number.
+     */
+    struct Entry
+    {
+        T value;  ///< The stored value.
+        int slot; ///< The handle of the element.
+    };
+
+    std::vector<Entry> data;    ///< The heap-ordered elements.
+    std::vector<int> position;  ///< position[slot] is the index of the element in data.
+    std::vector<int> freeSlots; ///< Slots of popped elements, ready for reuse.
+    [[no_unique_address]] Stats counters;
+
+    void heapifyUp(int index);
+    void heapifyDown(int index);
+
+    // Store an entry at index and record its new position
+    void place(int index, const Entry &entry)
+    {
+        data[index] = entry;
+        position[entry.slot] = index;
+    }
+};
+
+template <typename T, typename Stats>
+int IndexedBinaryHeap<T, Stats>::insert(const T &value)
+{
+    counters.push();
+    int slot;
+    if (freeSlots.empty())
+    {
+        slot = static_cast<int>(position.size());
+        position.push_back(0);
+    }
+    else
+    {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    data.push_back({value, slot});
+    position[slot] = static_cast<int>(data.size() - 1);
+    heapifyUp(static_cast<int>(data.size() - 1));
+    return slot;
+}
+
+template <typename T, typename Stats>
+void IndexedBinaryHeap<T, Stats>::decrease_key(int slot, const T &value)
+{
+    int index = position[slot];
+    if (value > data[index].value)
+    {
+        throw std::invalid_argument("New key is greater than the current key");
+    }
+    counters.decreaseKey();
+    data[index].value = value;
+    heapifyUp(index);
+}
+
+template <typename T, typename Stats>
+T IndexedBinaryHeap<T, Stats>::pop()
+{
+    if (empty())
+    {
+        throw std::runtime_error("Heap is empty");
+    }
+    counters.pop();
+    T minValue = data.front().value;
+    freeSlots.push_back(data.front().slot);
+    place(0, data.back());
+    data.pop_back();
+    if (!empty())
+    {
+        heapifyDown(0);
+    }
+    return minValue;
+}
+
+template <typename T, typename Stats>
+bool IndexedBinaryHeap<T, Stats>::empty() const
+{
+    return data.empty();
+}
+
+template <typename T, typename Stats>
+void IndexedBinaryHeap<T, Stats>::clear()
+{
+    counters.clear();
+    data.clear();
+    position.clear();
+    freeSlots.clear();
+}
+
+template <typename T, typename Stats>
+void IndexedBinaryHeap<T, Stats>::heapifyUp(int index)
+{
+    // Hold the moving entry aside and shift parents down into the hole
+    Entry entry = data[index];
+    while (index > 0)
+    {
+        int parentIndex = (index - 1) / 2;
+        if (!(entry.value < data[parentIndex].value))
+        {
+            break;
+        }
+        place(index, data[parentIndex]);
+        index = parentIndex;
+    }
+    place(index, entry);
+}
+
+template <typename T, typename Stats>
+void IndexedBinaryHeap<T, Stats>::heapifyDown(int index)
+{
+    auto size = static_cast<int>(data.size());
+    Entry entry = data[index];
+    while (true)
+    {
+        int smallest = 2 * index + 1; // Start with the left child
+        if (smallest >= size)
+        {
+            break;
+        }
+        // Pick the right child if it is smaller
+        if (smallest + 1 < size && data[smallest + 1].value < data[smallest].value)
+        {
+            smallest++;
+        }
+        // Stop once the moving entry is not larger than the smaller child
+        if (!(data[smallest].value < entry.value))
+        {
+            break;
+        }
+        place(index, data[smallest]);
+        index = smallest;
+    }
+    place(index, entry);
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @file mappedfile.hpp
+ * @brief RAII wrapper around a read-only, shared memory mapping of a whole file.
+ *
+ * The mapping is created with MAP_SHARED, so every process that maps the same
+ * file is served from the same page-cache pages.
+ */
+
+/**
+ * @class MappedFile
+ * @brief Maps a file read-only into the address space for the lifetime of the object.
+ */
+class MappedFile
+{
+public:
+    /**
+     * @brief Maps the given file.
+     *
+     * @param path The file to map.
+     * @throws std::runtime_error If the file cannot be opened or mapped.
+     */
+    explicit MappedFile(const std::string &path) : address(nullptr), length(0)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Error opening file " + path);
+        }
+
+        struct stat info{};
+        if (::fstat(fd, &info) != 0)
+        {
+            ::close(fd);
+            throw std::runtime_error("Error reading size of " + path);
+        }
+        length = static_cast<size_t>(info.st_size);
+
+        // mmap rejects empty mappings; an empty file simply has no data
+        if (length > 0)
+        {
+            address = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        }
+        ::close(fd);
+
+        if (address == MAP_FAILED)
+        {
+            address = nullptr;
+            throw std::runtime_error("Error mapping file " + path);
+        }
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    /**
+     * @brief Unmaps the file.
+     */
+    ~MappedFile()
+    {
+        if (address != nullptr)
+        {
+            ::munmap(address, length);
+        }
+    }
+
+    /**
+     * @brief Returns the first byte of the mapping, or nullptr for an empty file.
+     */
+    const char *data() const
+    {
+        return static_cast<const char *>(address);
+    }
+
+    /**
+     * @brief Returns the size of the file in bytes.
+     */
+    size_t size() const
+    {
+        return length;
+    }
+
+    /**
+     * @brief Hints the kernel about the expected access pattern of the whole mapping.
+     *
+     * @param advice One of the MADV_* constants, e.g. MADV_SEQUENTIAL.
+     */
+    void advise(int advice) const
+    {
+        if (address != nullptr)
+        {
+            ::madvise(address, length, advice);
+        }
+    }
+
+private:
+    void *address; ///< Start of the mapping.
+    size_t length; ///< Length of the mapping in bytes.
+};
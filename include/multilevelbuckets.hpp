@@ -0,0 +1,209 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <limits>
+
+#include "heap.hpp"
+#include "stats.hpp"
+
+/**
+ * @file multilevelbuckets.hpp
+ * @brief The multi-level bucket priority queue of Cherkassky, Goldberg and Radzik.
+ *
+ * This is the queue behind the "smart queue" reference solver of the 9th DIMACS
+ * challenge. Combined with the caliber heuristic (the Caliber strategy of
+ * dijkstra<>), it lets many vertices be settled without entering the queue.
+ */
+
+/**
+ * @class MultiLevelBuckets
+ * @brief A monotone integer priority queue with LEVELS levels of 2^BITS buckets each.
+ *
+ * Keys are read as LEVELS digits of BITS bits. Relative to the last popped key mu,
+ * an element with key k is stored on the level of the highest digit in which k
+ * differs from mu (level 0 if they agree on all higher digits), in the bucket
+ * given by k's digit on that level. All keys in a level-0 bucket are therefore
+ * equal, and popping takes from the lowest non-empty one. When level 0 is empty,
+ * the lowest non-empty bucket of the lowest non-empty level is expanded: its
+ * minimum becomes the new mu and its elements move to lower levels. An element
+ * descends at most LEVELS times. A bitmap per level makes finding the lowest
+ * non-empty bucket a handful of word scans.
+ *
+ * Keys must not drop below the last popped key; pushing such a key throws.
+ *
+ * @tparam T The type of elements stored in the heap; HeapKey<T> must be enabled.
+ * @tparam BITS The number of key bits per level.
+ * @tparam Stats The operation counting policy; see stats.hpp.
+ */
+template <typename T, int BITS = 8, typename Stats = NoStats>
+class MultiLevelBuckets : public Heap<T>
+{
+    static_assert(HeapKey<T>::enabled, "MultiLevelBuckets needs an integer HeapKey");
+    static_assert(BITS >= 6 && BITS <= 16, "BITS must be between 6 and 16");
+
+public:
+    MultiLevelBuckets() : levels(), last(0), count(0), counters() {}
+    void push(const T &value) override;
+    T pop() override;
+    bool empty() const override;
+    void clear() override;
+
+    Stats &stats()
+    {
+        return counters;
+    }
+
+private:
+    using Key = uint32_t;
+
+    static constexpr int BUCKETS = 1 << BITS;                                       ///< Buckets per level.
+    static constexpr int LEVELS = (std::numeric_limits<Key>::digits + BITS - 1) / BITS; ///< Levels needed to cover a key.
+    static constexpr int WORDS = BUCKETS / 64;                                      ///< Bitmap words per level.
+
+    /**
+     * @struct Level
+     * @brief The buckets of one level plus a bitmap of the non-empty ones.
+     */
+    struct Level
+    {
+        std::array<std::vector<T>, BUCKETS> buckets; ///< Elements, indexed by their digit on this level.
+        std::array<uint64_t, WORDS> occupied;        ///< Bit b is set iff buckets[b] is non-empty.
+        int size;                                    ///< Number of elements on this level.
+
+        Level() : buckets(), occupied(), size(0) {}
+
+        // Index of the lowest non-empty bucket; the level must not be empty
+        int lowest() const
+        {
+            int word = 0;
+            while (occupied[word] == 0)
+            {
+                word++;
+            }
+            return word * 64 + std::countr_zero(occupied[word]);
+        }
+    };
+
+    std::array<Level, LEVELS> levels; ///< The levels, lowest digit first.
+    Key last;                         ///< The last popped key.
+    size_t count;                     ///< The number of elements in the queue.
+    [[no_unique_address]] Stats counters; ///< The operation counts.
+
+    static Key keyOf(const T &value)
+    {
+        return static_cast<Key>(HeapKey<T>::get(value));
+    }
+
+    // Store a value on the level and bucket determined by its key relative to last
+    void place(const T &value)
+    {
+        Key key = keyOf(value);
+        Key difference = key ^ last;
+        int level = difference == 0 ? 0 : (std::bit_width(difference) - 1) / BITS;
+        int bucket = static_cast<int>((key >> (level * BITS)) & (BUCKETS - 1));
+
+        Level &target = levels[level];
+        target.buckets[bucket].push_back(value);
+        target.occupied[bucket / 64] |= uint64_t{1} << (bucket % 64);
+        target.size++;
+    }
+};
+
+template <typename T, int BITS, typename Stats>
+void MultiLevelBuckets<T, BITS, Stats>::push(const T &value)
+{
+    if (keyOf(value) < last)
+    {
+        throw std::invalid_argument("MultiLevelBuckets keys must not decrease below the last popped key");
+    }
+    counters.push();
+    place(value);
+    count++;
+}
+
+template <typename T, int BITS, typename Stats>
+T MultiLevelBuckets<T, BITS, Stats>::pop()
+{
+    if (empty())
+    {
+        throw std::runtime_error("Heap is empty");
+    }
+    counters.pop();
+
+    if (levels[0].size == 0)
+    {
+        // Expand the lowest non-empty bucket of the lowest non-empty level
+        int level = 1;
+        while (levels[level].size == 0)
+        {
+            level++;
+        }
+        Level &source = levels[level];
+        int bucket = source.lowest();
+
+        std::vector<T> elements;
+        elements.swap(source.buckets[bucket]);
+        source.occupied[bucket / 64] &= ~(uint64_t{1} << (bucket % 64));
+        source.size -= static_cast<int>(elements.size());
+
+        Key minimum = keyOf(elements.front());
+        for (const T &value : elements)
+        {
+            minimum = std::min(minimum, keyOf(value));
+        }
+        last = minimum;
+
+        // All elements agree with the new minimum above this level, so they land lower
+        for (const T &value : elements)
+        {
+            place(value);
+        }
+
+        // Hand the emptied vector back so its capacity is reused
+        elements.clear();
+        source.buckets[bucket].swap(elements);
+    }
+
+    Level &bottom = levels[0];
+    int bucket = bottom.lowest();
+    std::vector<T> &elements = bottom.buckets[bucket];
+    T minValue = elements.back();
+    elements.pop_back();
+    if (elements.empty())
+    {
+        bottom.occupied[bucket / 64] &= ~(uint64_t{1} << (bucket % 64));
+    }
+    bottom.size--;
+    count--;
+
+    // Every key on level 0 shares the higher digits with last, so this is the popped key
+    last = keyOf(minValue);
+    return minValue;
+}
+
+template <typename T, int BITS, typename Stats>
+bool MultiLevelBuckets<T, BITS, Stats>::empty() const
+{
+    return count == 0;
+}
+
+template <typename T, int BITS, typename Stats>
+void MultiLevelBuckets<T, BITS, Stats>::clear()
+{
+    // Only the buckets marked in the bitmaps hold elements
+    for (Level &level : levels)
+    {
+        while (level.size > 0)
+        {
+            int bucket = level.lowest();
+            level.size -= static_cast<int>(level.buckets[bucket].size());
+            level.buckets[bucket].clear();
+            level.occupied[bucket / 64] &= ~(uint64_t{1} << (bucket % 64));
+        }
+    }
+    counters.clear();
+    last = 0;
+    count = 0;
+}
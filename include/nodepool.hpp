@@ -0,0 +1,175 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @file nodepool.hpp
+ * @brief Slab allocator for the nodes of pointer-based heaps.
+ *
+ * Node-based heaps allocate one node per push and free it on pop. Going through
+ * malloc for every one of them is a large part of their running time, and it
+ * scatters nodes over the address space. A NodePool carves nodes out of large
+ * slabs and keeps freed nodes on an intrusive free list, so allocation is a
+ * pointer bump or a list pop and consecutive nodes share cache lines.
+ *
+ * Node-based heaps take the pool as a template template parameter:
+ *
+ * - NodePool releases every node at once with releaseAll() and keeps its slabs,
+ *   so a heap that is cleared after a query reuses the same memory for the next.
+ * - NewDeletePool calls new and delete per node; it is the baseline to compare
+ *   against and the fallback for nodes that are not trivially destructible.
+ *
+ * Pools advertise bulk release through the static member bulkRelease.
+ */
+
+/**
+ * @class NodePool
+ * @brief Allocates nodes of one type from geometrically growing slabs.
+ *
+ * The pool never runs node destructors on its own, so the node type must be
+ * trivially destructible; this holds for the heap nodes used with NearestRecord.
+ *
+ * @tparam Node The node type.
+ */
+template <typename Node>
+class NodePool
+{
+    static_assert(std::is_trivially_destructible_v<Node>, "NodePool requires trivially destructible nodes");
+
+public:
+    static constexpr bool bulkRelease = true;
+
+    NodePool() : slabs(), slabIndex(-1), freeList(nullptr), cursor(nullptr), slabEnd(nullptr) {}
+
+    NodePool(const NodePool &) = delete;
+    NodePool &operator=(const NodePool &) = delete;
+
+    /**
+     * @brief Constructs a node in pool memory.
+     *
+     * @param args The arguments forwarded to the node constructor.
+     * @return The new node.
+     */
+    template <typename... Args>
+    Node *create(Args &&...args)
+    {
+        Slot *slot;
+        if (freeList != nullptr)
+        {
+            slot = freeList;
+            freeList = freeList->next;
+        }
+        else
+        {
+            if (cursor == slabEnd)
+            {
+                grow();
+            }
+            slot = cursor++;
+        }
+        return ::new (static_cast<void *>(slot->storage)) Node(std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Returns a node to the pool for reuse.
+     *
+     * @param node A node obtained from create() of this pool.
+     */
+    void destroy(Node *node)
+    {
+        Slot *slot = reinterpret_cast<Slot *>(node);
+        slot->next = freeList;
+        freeList = slot;
+    }
+
+    /**
+     * @brief Releases every node of the pool at once.
+     *
+     * The slabs are kept and handed out again from the start, so a pool that is
+     * released after every query stops allocating once it has grown to the
+     * largest query. All nodes obtained so far become invalid.
+     */
+    void releaseAll()
+    {
+        freeList = nullptr;
+        slabIndex = -1;
+        cursor = nullptr;
+        slabEnd = nullptr;
+    }
+
+private:
+    /**
+     * @union Slot
+     * @brief Storage for one node, or a free-list link while the slot is unused.
+     */
+    union Slot
+    {
+        Slot *next;                                     ///< The next free slot.
+        alignas(Node) unsigned char storage[sizeof(Node)]; ///< The node itself.
+    };
+
+    // Size of the first slab; each further slab doubles up to the maximum
+    static constexpr size_t FIRST_SLAB = 64;
+    static constexpr size_t MAX_SLAB = 1 << 16;
+
+    std::vector<std::unique_ptr<Slot[]>> slabs; ///< Every slab allocated so far.
+    int slabIndex;                              ///< Index of the slab the cursor points into, -1 before the first.
+    Slot *freeList;                             ///< Head of the list of freed slots.
+    Slot *cursor;                               ///< Next never-used slot in the current slab.
+    Slot *slabEnd;                              ///< One past the last slot of the current slab.
+
+    // Size of the slab with the given index
+    static size_t slabSize(int index)
+    {
+        return std::min(MAX_SLAB, FIRST_SLAB << std::min(index, 16));
+    }
+
+    // Move the cursor to the next slab, allocating it unless a released one can be reused
+    void grow()
+    {
+        slabIndex++;
+        size_t size = slabSize(slabIndex);
+        if (slabIndex == static_cast<int>(slabs.size()))
+        {
+            slabs.push_back(std::make_unique_for_overwrite<Slot[]>(size));
+        }
+        cursor = slabs[slabIndex].get();
+        slabEnd = cursor + size;
+    }
+};
+
+/**
+ * @class NewDeletePool
+ * @brief Allocates every node individually with new and frees it with delete.
+ *
+ * @tparam Node The node type.
+ */
+template <typename Node>
+class NewDeletePool
+{
+public:
+    static constexpr bool bulkRelease = false;
+
+    template <typename... Args>
+    Node *create(Args &&...args)
+    {
+        return new Node(std::forward<Args>(args)...);
+    }
+
+    void destroy(Node *node)
+    {
+        delete node;
+    }
+};
+
+/**
+ * @brief The pool node-based heaps use by default: NodePool where possible, NewDeletePool otherwise.
+ */
+template <typename Node>
+using DefaultNodePool = std::conditional_t<std::is_trivially_destructible_v<Node>, NodePool<Node>, NewDeletePool<Node>>;
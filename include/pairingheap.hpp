@@ -0,0 +1,325 @@
+#pragma once
+
+#include "heap.hpp"
+#include "nodepool.hpp"
+#include "stats.hpp"
+
+/**
+ * @file pairingheap.hpp
+ * @brief Implementation of a pairing heap with two-pass or multipass consolidation.
+ *
+ * A pairing heap is a single heap-ordered multiway tree. Insertion and
+ * decrease-key are a single comparison and link with the root, and all the
+ * restructuring happens when the root is deleted and its children have to be
+ * paired up again. It is known as the fastest decrease-key heap in practice.
+ *
+ * @tparam T The type of elements stored in the heap.
+ */
+
+// Pairing strategy: meld children in pairs left to right, then fold the pairs right to left
+struct TwoPass
+{
+};
+
+// Pairing strategy: repeatedly meld the first two trees and append the result until one remains
+struct MultiPass
+{
+};
+
+/**
+ * @struct PairingHeapNode
+ * @brief A node in the Pairing Heap.
+ *
+ * Children are kept in a doubly linked sibling list; the prev pointer of the
+ * first child points to the parent. Pointers to nodes serve as the handles
+ * returned by PairingHeap::insert.
+ *
+ * @tparam T The type of the value stored in the node.
+ */
+template <typename T>
+struct PairingHeapNode
+{
+    T value;               ///< The value stored in the node.
+    PairingHeapNode *child; ///< Pointer to the first child.
+    PairingHeapNode *next;  ///< Pointer to the next sibling.
+    PairingHeapNode *prev;  ///< Pointer to the previous sibling, or to the parent for a first child.
+
+    /**
+     * @brief Constructs a node without children or siblings.
+     *
+     * @param val The value to be stored in the node.
+     */
+    PairingHeapNode(const T &val) : value(val), child(nullptr), next(nullptr), prev(nullptr) {}
+
+    PairingHeapNode(const PairingHeapNode &) = delete;
+    PairingHeapNode &operator=(const PairingHeapNode &) = delete;
+};
+
+/**
+ * @class PairingHeap
+ * @brief A pairing heap whose nodes come from a pool.
+ *
+ * @tparam T The type of elements stored in the heap.
+ * @tparam Pass TwoPass or MultiPass, the strategy used to pair up the children of a deleted root.
+ * @tparam Pool The allocator for the nodes, NodePool or NewDeletePool (see nodepool.hpp).
+ * @tparam Stats The operation counting policy; see stats.hpp.
+ */
+template <typename T, typename Pass = TwoPass, template <typename> class Pool = DefaultNodePool, typename Stats = NoStats>
+class PairingHeap : public AddressableHeap<T, PairingHeapNode<T> *>
+{
+    static_assert(std::is_same_v<Pass, TwoPass> || std::is_same_v<Pass, MultiPass>, "Pass must be TwoPass or MultiPass");
+
+public:
+    using Node = PairingHeapNode<T>;
+
+    PairingHeap() : root(nullptr), pool(), counters() {}
+
+    PairingHeap(const PairingHeap &) = delete;
+    PairingHeap &operator=(const PairingHeap &) = delete;
+
+    ~PairingHeap()
+    {
+        if constexpr (!Pool<Node>::bulkRelease)
+        {
+            destroyAll();
+        }
+    }
+
+    /**
+     * @brief Inserts a value by linking a new single-node tree with the root.
+     *
+     * @param value The value to be inserted.
+     * @return A handle to the new node, valid until it is popped.
+     */
+    Node *insert(const T &value) override
+    {
+        counters.push();
+        Node *node = pool.create(value);
+        root = meld(root, node);
+        return node;
+    }
+
+    /**
+     * @brief Lowers the value of a queued node by cutting its subtree and linking it with the root.
+     *
+     * @param node The handle returned by insert().
+     * @param value The new value, which must not be greater than the current one.
+     * @throws std::invalid_argument If the new value is greater than the current one.
+     */
+    void decrease_key(Node *node, const T &value) override
+    {
+        if (value > node->value)
+        {
+            throw std::invalid_argument("New key is greater than the current key");
+        }
+        counters.decreaseKey();
+        node->value = value;
+        if (node == root)
+        {
+            return;
+        }
+
+        // Unlink the node from its sibling list; a first child is referenced by its parent
+        if (node->prev->child == node)
+        {
+            node->prev->child = node->next;
+        }
+        else
+        {
+            node->prev->next = node->next;
+        }
+        if (node->next != nullptr)
+        {
+            node->next->prev = node->prev;
+        }
+        node->next = nullptr;
+        node->prev = nullptr;
+
+        root = meld(root, node);
+    }
+
+    /**
+     * @brief Removes and returns the minimum element, pairing up the children of the root.
+     *
+     * @return The minimum element.
+     * @throws std::runtime_error If the heap is empty.
+     */
+    T pop() override
+    {
+        if (empty())
+        {
+            throw std::runtime_error("Heap is empty");
+        }
+        counters.pop();
+        Node *oldRoot = root;
+        T minValue = oldRoot->value;
+        if constexpr (std::is_same_v<Pass, TwoPass>)
+        {
+            root = combineTwoPass(oldRoot->child);
+        }
+        else
+        {
+            root = combineMultiPass(oldRoot->child);
+        }
+        pool.destroy(oldRoot);
+        return minValue;
+    }
+
+    /**
+     * @brief Checks if the heap is empty.
+     */
+    bool empty() const override
+    {
+        return root == nullptr;
+    }
+
+    /**
+     * @brief Removes all elements; with a bulk-release pool this is O(1) and keeps the node memory.
+     */
+    void clear() override
+    {
+        if constexpr (Pool<Node>::bulkRelease)
+        {
+            pool.releaseAll();
+        }
+        else
+        {
+            destroyAll();
+        }
+        root = nullptr;
+        counters.clear();
+    }
+
+    Stats &stats()
+    {
+        return counters;
+    }
+
+private:
+    Node *root;       ///< The root of the tree, holding the minimum.
+    Pool<Node> pool;  ///< Storage for the nodes.
+    [[no_unique_address]] Stats counters; ///< The operation counts.
+
+    // Return every node to the pool, flattening the tree by splicing child lists into the walk
+    void destroyAll()
+    {
+        Node *list = root;
+        while (list != nullptr)
+        {
+            Node *node = list;
+            list = node->next;
+            if (node->child != nullptr)
+            {
+                Node *last = node->child;
+                while (last->next != nullptr)
+                {
+                    last = last->next;
+                }
+                last->next = list;
+                list = node->child;
+            }
+            pool.destroy(node);
+        }
+    }
+
+    /**
+     * @brief Links two trees, making the root with the larger value the first child of the other.
+     *
+     * Both arguments must be roots (no siblings); the result has no siblings either.
+     */
+    static Node *meld(Node *a, Node *b)
+    {
+        if (a == nullptr)
+            return b;
+        if (b == nullptr)
+            return a;
+        if (b->value < a->value)
+            std::swap(a, b);
+        b->prev = a;
+        b->next = a->child;
+        if (a->child != nullptr)
+            a->child->prev = b;
+        a->child = b;
+        return a;
+    }
+
+    /**
+     * @brief Detaches the first tree from a sibling list.
+     *
+     * @param list The head of the list; advanced to the next tree.
+     * @return The detached tree.
+     */
+    static Node *takeFirst(Node *&list)
+    {
+        Node *first = list;
+        list = first->next;
+        first->next = nullptr;
+        first->prev = nullptr;
+        return first;
+    }
+
+    /**
+     * @brief Combines a sibling list into one tree with the standard two-pass pairing.
+     */
+    static Node *combineTwoPass(Node *list)
+    {
+        if (list == nullptr)
+        {
+            return nullptr;
+        }
+
+        // Pass 1: meld neighbours left to right, pushing each result onto a stack linked through next
+        Node *pairs = nullptr;
+        while (list != nullptr)
+        {
+            Node *a = takeFirst(list);
+            Node *b = list != nullptr ? takeFirst(list) : nullptr;
+            Node *tree = meld(a, b);
+            tree->next = pairs;
+            pairs = tree;
+        }
+
+        // Pass 2: fold the stack, which visits the pairs right to left
+        Node *result = takeFirst(pairs);
+        while (pairs != nullptr)
+        {
+            result = meld(result, takeFirst(pairs));
+        }
+        return result;
+    }
+
+    /**
+     * @brief Combines a sibling list into one tree with multipass pairing.
+     */
+    static Node *combineMultiPass(Node *list)
+    {
+        if (list == nullptr)
+        {
+            return nullptr;
+        }
+
+        // Treat the list as a FIFO queue: meld the first two trees and append the result
+        Node *tail = list;
+        while (tail->next != nullptr)
+        {
+            tail = tail->next;
+        }
+        while (list->next != nullptr)
+        {
+            Node *a = takeFirst(list);
+            Node *b = takeFirst(list);
+            Node *tree = meld(a, b);
+            if (list == nullptr)
+            {
+                list = tree;
+            }
+            else
+            {
+                tail->next = tree;
+            }
+            tail = tree;
+        }
+        list->prev = nullptr;
+        return list;
+    }
+};
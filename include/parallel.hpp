@@ -0,0 +1,168 @@
+#pragma once
+
+#include <algorithm>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @file parallel.hpp
+ * @brief Minimal helpers for fork-join parallelism with std::thread.
+ */
+
+/**
+ * @brief Returns the number of worker threads to use when the caller has no preference.
+ */
+inline int defaultThreadCount()
+{
+    return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+/**
+ * @brief Runs fn(threadIndex) on the given number of threads and waits for all of them.
+ *
+ * The calling thread runs index 0 itself. If any invocation throws, the first
+ * exception (by thread index) is rethrown after every thread has finished.
+ *
+ * @param threads The number of invocations; values below 1 are treated as 1.
+ * @param fn The function to run, called with indices 0 .. threads - 1.
+ */
+template <typename Function>
+void runOnThreads(int threads, Function &&fn)
+{
+    threads = std::max(1, threads);
+    std::vector<std::exception_ptr> errors(static_cast<size_t>(threads));
+    auto guarded = [&](int index)
+    {
+        try
+        {
+            fn(index);
+        }
+        catch (...)
+        {
+            errors[static_cast<size_t>(index)] = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(static_cast<size_t>(threads - 1));
+    for (int i = 1; i < threads; i++)
+    {
+        workers.emplace_back(guarded, i);
+    }
+    guarded(0);
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+
+    for (const std::exception_ptr &error : errors)
+    {
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+/**
+ * @brief Splits [0, count) into one contiguous block per thread and runs fn(begin, end) on each.
+ *
+ * @param threads The number of threads.
+ * @param count The size of the index range.
+ * @param fn The function to run on every non-empty block.
+ */
+template <typename Function>
+void parallelForBlocks(int threads, long long count, Function &&fn)
+{
+    threads = std::max(1, threads);
+    runOnThreads(threads, [&](int index)
+                 {
+        long long begin = count * index / threads;
+        long long end = count * (index + 1) / threads;
+        if (begin < end)
+        {
+            fn(begin, end);
+        } });
+}
+
+/**
+ * @brief Runs fn(threadIndex, i) for every i in [0, count), balancing uneven work by stealing.
+ *
+ * Every thread starts with one contiguous block of indices and takes them from
+ * the front. A thread that runs out steals the back half of the first other
+ * block that still has work, so a few expensive items do not leave the other
+ * threads idle. Items are never created during the run, so a thread stops once
+ * a full round over all blocks finds nothing to steal. Each block is guarded by
+ * its own mutex; that costs nothing measurable next to items such as whole
+ * shortest path queries.
+ *
+ * @param threads The number of threads.
+ * @param count The size of the index range.
+ * @param fn The function to run, called with the index of the running thread and the item index.
+ */
+template <typename Function>
+void parallelForStealing(int threads, long long count, Function &&fn)
+{
+    threads = std::max(1, threads);
+
+    // One range of pending items per thread, each on its own cache line
+    struct alignas(64) Range
+    {
+        std::mutex lock;
+        long long begin;
+        long long end;
+
+        Range() : lock(), begin(0), end(0) {}
+    };
+    std::vector<Range> ranges(static_cast<size_t>(threads));
+    for (int t = 0; t < threads; t++)
+    {
+        ranges[static_cast<size_t>(t)].begin = count * t / threads;
+        ranges[static_cast<size_t>(t)].end = count * (t + 1) / threads;
+    }
+
+    runOnThreads(threads, [&](int index)
+                 {
+        Range &own = ranges[static_cast<size_t>(index)];
+        while (true)
+        {
+            long long item = -1;
+            {
+                std::lock_guard<std::mutex> guard(own.lock);
+                if (own.begin < own.end)
+                {
+                    item = own.begin++;
+                }
+            }
+
+            // Steal the back half of another thread's range, keeping its first item to run now
+            for (int k = 1; item < 0 && k < threads; k++)
+            {
+                Range &victim = ranges[static_cast<size_t>((index + k) % threads)];
+                long long begin;
+                long long end;
+                {
+                    std::lock_guard<std::mutex> guard(victim.lock);
+                    if (victim.begin >= victim.end)
+                    {
+                        continue;
+                    }
+                    begin = victim.begin + (victim.end - victim.begin) / 2;
+                    end = victim.end;
+                    victim.end = begin;
+                }
+                std::lock_guard<std::mutex> guard(own.lock);
+                item = begin;
+                own.begin = begin + 1;
+                own.end = end;
+            }
+
+            if (item < 0)
+            {
+                return;
+            }
+            fn(index, item);
+        } });
+}
@@ -1,17 +1,15 @@
 #pragma once
 
+#include <algorithm>
 #include <vector>
 #include <limits>
+#include <type_traits>
+#include <stdexcept>
 
-// Constant representing infinity, used to initialize distances
-const int INF = std::numeric_limits<int>::max();
-
-// Structure representing an edge in the graph
-struct Edge
-{
-    int to;     // The destination vertex of the edge
-    int weight; // The weight of the edge
-};
+#include "graph.hpp"
+#include "heap.hpp"
+#include "queryworkspace.hpp"
+#include "stats.hpp"
 
 // Structure representing a record in the priority queue
 struct NearestRecord
@@ -32,53 +30,415 @@ struct NearestRecord
     }
 };
 
+// Records are ordered by their distance alone, so integer-keyed heaps can use it directly
+template <>
+struct HeapKey<NearestRecord>
+{
+    static constexpr bool enabled = true;
+
+    static int get(const NearestRecord &record)
+    {
+        return record.dist;
+    }
+};
+
+// How many arcs ahead the relaxation loop of dijkstra prefetches the distance of the arc's target;
+// build with -DPATHFINDER_PREFETCH_DISTANCE=0 to compile every prefetch out and get the plain loop
+#ifndef PATHFINDER_PREFETCH_DISTANCE
+#define PATHFINDER_PREFETCH_DISTANCE 4
+#endif
+
+inline constexpr int PREFETCH_DISTANCE = PATHFINDER_PREFETCH_DISTANCE;
+
+static_assert(PREFETCH_DISTANCE >= 0, "PATHFINDER_PREFETCH_DISTANCE must not be negative");
+
+// Prefetch the distances of the first targets of the arc range [e, last), before the relaxation loop starts
+template <typename PriorityQueue>
+inline void prefetchTargets(const Graph &graph, int e, int last, const QueryWorkspace<PriorityQueue> &workspace)
+{
+    if constexpr (PREFETCH_DISTANCE > 0)
+    {
+        for (int end = std::min(last, e + PREFETCH_DISTANCE); e < end; e++)
+            workspace.prefetchDistance(graph.target(e));
+    }
+}
+
+// Prefetch the distance of the target PREFETCH_DISTANCE arcs after e, from within the relaxation loop
+template <typename PriorityQueue>
+inline void prefetchTargetAhead(const Graph &graph, int e, int last, const QueryWorkspace<PriorityQueue> &workspace)
+{
+    if constexpr (PREFETCH_DISTANCE > 0)
+    {
+        if (e + PREFETCH_DISTANCE < last)
+            workspace.prefetchDistance(graph.target(e + PREFETCH_DISTANCE));
+    }
+}
+
+// Prefetch the arcs of the vertex at the top of the heap, which is likely the next one scanned;
+// only for heaps that can show their top without popping it
+template <typename PriorityQueue>
+inline void prefetchNextScan(const Graph &graph, const PriorityQueue &pq)
+{
+    if constexpr (PREFETCH_DISTANCE > 0 && requires { pq.top(); })
+    {
+        if (!pq.empty())
+            graph.prefetchArcs(pq.top().vertex);
+    }
+}
+
+// Strategy: push a duplicate record for every improved distance and skip stale records when popped
+struct LazyInsertion
+{
+};
+
+// Strategy: keep one record per vertex and lower its key in place; requires an AddressableHeap
+struct DecreaseKey
+{
+};
+
+// Strategy: lazy insertion plus the caliber heuristic of the DIMACS smart queue; requires
+// Graph::computeCalibers(). A vertex whose tentative distance is at most mu + caliber(v), where
+// mu is the last key popped from the queue, already has its final distance: every other path to
+// it would leave the scanned region through a vertex at distance >= mu and then still need an
+// incoming arc of weight >= caliber(v). Such vertices are settled from a plain stack without ever
+// entering the queue.
+struct Caliber
+{
+};
+
 /**
  * @file pathfinder.hpp
  * @brief Contains the implementation of Dijkstra's algorithm for finding the shortest path in a graph from a start vertex to a destination vertex.
  * 
  * @tparam PriorityQueue The type of priority queue to be used in the algorithm. It must support push and pop operations.
+ * @tparam Strategy LazyInsertion (any heap), DecreaseKey (heaps with insert and decrease_key) or Caliber (any heap,
+ *         graph with calibers). With DecreaseKey every vertex is queued at most once, so the heap stays smaller and no
+ *         stale records are popped; with Caliber many vertices bypass the queue entirely.
  * 
  * @param start The starting vertex for Dijkstra's algorithm.
  * @param destination The destination vertex for which the shortest path is to be found.
- * @param graph A reference to the adjacency list representation of the graph. Each element in the outer vector represents a vertex, and each inner vector contains edges (of type Edge) originating from that vertex.
+ * @param graph A reference to the CSR representation of the graph. The arcs leaving a vertex are stored contiguously, so relaxing them is a linear walk.
+ * @param workspace The distances, settled bits and heap to run on. It is reset first, which only touches the vertices
+ *        reached by the previous query, so one workspace can serve many queries without O(n) work per query.
  * 
  * @return The shortest path length from the start vertex to the destination vertex. If there is no path, returns INF.
  * 
  * The function uses a priority queue to efficiently find the shortest path from the start vertex to the destination vertex in the graph.
  */
+template <typename PriorityQueue, typename Strategy = LazyInsertion>
+int dijkstra(int start, int destination, const Graph &graph, QueryWorkspace<PriorityQueue> &workspace)
+{
+    static_assert(std::is_same_v<Strategy, LazyInsertion> || std::is_same_v<Strategy, DecreaseKey> ||
+                      std::is_same_v<Strategy, Caliber>,
+                  "Strategy must be LazyInsertion, DecreaseKey or Caliber");
+
+    workspace.reset(graph.vertexCount());
+    workspace.setDistance(start, 0);
+
+    PriorityQueue &pq = workspace.queue();
+    auto &stats = heapStats(pq);
+
+    if constexpr (std::is_same_v<Strategy, DecreaseKey>)
+    {
+        // Handles of the queued records; only read for vertices whose distance is finite
+        workspace.handle(start) = pq.insert({0, start});
+
+        while (!pq.empty())
+        {
+            // every vertex is popped exactly once, with its final distance
+            auto [dist, u] = pq.pop();
+            stats.settle();
+
+            if (u == destination)
+                return dist;
+
+            prefetchNextScan(graph, pq);
+            prefetchTargets(graph, graph.beginArc(u), graph.endArc(u), workspace);
+            for (int e = graph.beginArc(u), last = graph.endArc(u); e < last; e++)
+            {
+                prefetchTargetAhead(graph, e, last, workspace);
+                stats.relax();
+                int v = graph.target(e);
+                int candidate = dist + graph.weight(e);
+
+                // settled vertices never improve, so a finite distance means v is still queued
+                int current = workspace.distance(v);
+                if (candidate < current)
+                {
+                    if (current == INF)
+                        workspace.handle(v) = pq.insert({candidate, v});
+                    else
+                        pq.decrease_key(workspace.handle(v), {candidate, v});
+                    workspace.setDistance(v, candidate);
+                }
+            }
+        }
+
+        return INF; // If the destination is not reachable
+    }
+    else if constexpr (std::is_same_v<Strategy, Caliber>)
+    {
+        if (!graph.hasCalibers())
+        {
+            throw std::invalid_argument("The Caliber strategy needs Graph::computeCalibers()");
+        }
+
+        std::vector<int> ready{start}; // vertices whose tentative distance is already final
+        int mu = 0;                    // the last key popped from the queue
+
+        while (true)
+        {
+            int u;
+            if (!ready.empty())
+            {
+                u = ready.back();
+                ready.pop_back();
+            }
+            else
+            {
+                if (pq.empty())
+                    break;
+                auto [dist, x] = pq.pop();
+                if (workspace.isSettled(x) || dist > workspace.distance(x))
+                {
+                    stats.stalePop();
+                    continue;
+                }
+                mu = dist;
+                u = x;
+            }
+
+            workspace.settle(u);
+            stats.settle();
+            int du = workspace.distance(u);
+            if (u == destination)
+                return du;
+
+            prefetchNextScan(graph, pq);
+            prefetchTargets(graph, graph.beginArc(u), graph.endArc(u), workspace);
+            for (int e = graph.beginArc(u), last = graph.endArc(u); e < last; e++)
+            {
+                prefetchTargetAhead(graph, e, last, workspace);
+                stats.relax();
+                int v = graph.target(e);
+                int candidate = du + graph.weight(e);
+
+                if (candidate < workspace.distance(v))
+                {
+                    workspace.setDistance(v, candidate);
+                    // candidate >= mu, so the subtraction cannot overflow even for an INT_MAX caliber
+                    if (candidate - mu <= graph.caliber(v))
+                        ready.push_back(v);
+                    else
+                        pq.push({candidate, v});
+                }
+            }
+        }
+
+        return INF; // If the destination is not reachable
+    }
+    else
+    {
+        pq.push({0, start});
+
+        while (!pq.empty())
+        {
+            // get the vertex with the smallest distance
+            auto [dist, u] = pq.pop();
+
+            // a stale record of the destination pops only after its final one, so the order does not matter
+            if (dist > workspace.distance(u))
+            {
+                stats.stalePop();
+                continue;
+            }
+            stats.settle();
+
+            if (u == destination)
+                return dist;
+
+            prefetchNextScan(graph, pq);
+            prefetchTargets(graph, graph.beginArc(u), graph.endArc(u), workspace);
+            for (int e = graph.beginArc(u), last = graph.endArc(u); e < last; e++)
+            {
+                prefetchTargetAhead(graph, e, last, workspace);
+                stats.relax();
+                int v = graph.target(e);
+                int weight = graph.weight(e);
+
+                if (dist + weight < workspace.distance(v))
+                {
+                    workspace.setDistance(v, dist + weight);
+                    pq.push({dist + weight, v});
+                }
+            }
+        }
+
+        return INF; // If the destination is not reachable
+    }
+}
+
+/**
+ * @brief Runs Dijkstra's algorithm with a workspace of its own; see the overload above.
+ */
+template <typename PriorityQueue, typename Strategy = LazyInsertion>
+int dijkstra(int start, int destination, const Graph &graph)
+{
+    QueryWorkspace<PriorityQueue> workspace(graph.vertexCount());
+    return dijkstra<PriorityQueue, Strategy>(start, destination, graph, workspace);
+}
+
+/**
+ * @brief Computes the distance from the nearest of the given sources to every vertex.
+ *
+ * With a single source this is a one-to-all search; with several it is the search
+ * from a virtual vertex joined to all of them by arcs of weight 0.
+ *
+ * @tparam PriorityQueue The type of priority queue; any heap works.
+ *
+ * @param sources The vertices the search starts from.
+ * @param graph The graph to search.
+ * @param parents If not null, receives the predecessor of every vertex in the shortest path tree,
+ *        or -1 for the sources and unreached vertices.
+ *
+ * @return The distance of every vertex, INF where it is unreachable.
+ */
 template <typename PriorityQueue>
-int dijkstra(int start, int destination, const std::vector<std::vector<Edge>> &graph)
+std::vector<int> one_to_all_dijkstra(const std::vector<int> &sources, const Graph &graph, std::vector<int> *parents = nullptr)
 {
-    auto n = graph.size();
+    auto n = static_cast<size_t>(graph.vertexCount());
     std::vector<int> distances(n, INF);
-    distances[start] = 0;
+    if (parents != nullptr)
+    {
+        parents->assign(n, -1);
+    }
 
     PriorityQueue pq;
-    pq.push({0, start});
+    for (int source : sources)
+    {
+        distances[source] = 0;
+        pq.push({0, source});
+    }
 
     while (!pq.empty())
     {
-        // get the vertex with the smallest distance
         auto [dist, u] = pq.pop();
+        if (dist > distances[u])
+            continue;
 
-        if (u == destination)
-            return dist;
+        for (int e = graph.beginArc(u), last = graph.endArc(u); e < last; e++)
+        {
+            int v = graph.target(e);
+            int candidate = dist + graph.weight(e);
 
-        if (dist > distances[u])
+            if (candidate < distances[v])
+            {
+                distances[v] = candidate;
+                if (parents != nullptr)
+                    (*parents)[v] = u;
+                pq.push({candidate, v});
+            }
+        }
+    }
+
+    return distances;
+}
+
+/**
+ * @brief Bidirectional Dijkstra: searches forward from the start and backward from the destination.
+ *
+ * The two searches alternate, one settled vertex at a time, with lazy insertion, so any heap
+ * works. Every arc relaxation that reaches a vertex already seen by the other search closes a
+ * start-destination path, and the shortest of these is kept as mu. The searches stop as soon as
+ * the keys last popped on the two sides add up to at least mu: a shorter path would have to
+ * consist of a vertex outside both searched balls, which is impossible. On road networks the two
+ * balls together are about half the size of the ball of a one-sided search.
+ *
+ * @tparam PriorityQueue The type of priority queue used by both searches.
+ *
+ * @param start The starting vertex.
+ * @param destination The destination vertex.
+ * @param graph The graph; Graph::computeReverse() must have been called on it.
+ * @param workspace The state of both searches, reset first.
+ *
+ * @return The shortest path length from the start vertex to the destination vertex, or INF if there is no path.
+ * @throws std::invalid_argument If the graph has no reverse graph.
+ */
+template <typename PriorityQueue>
+int bidirectional_dijkstra(int start, int destination, const Graph &graph, BidirectionalWorkspace<PriorityQueue> &workspace)
+{
+    if (!graph.hasReverse())
+    {
+        throw std::invalid_argument("bidirectional_dijkstra needs Graph::computeReverse()");
+    }
+
+    QueryWorkspace<PriorityQueue> *sides[2] = {&workspace.forward, &workspace.backward};
+    const Graph *graphs[2] = {&graph, &graph.reverse()};
+    int sources[2] = {start, destination};
+    int radius[2] = {0, 0}; // the key last popped on each side, a lower bound on its queue
+    for (int side = 0; side < 2; side++)
+    {
+        sides[side]->reset(graph.vertexCount());
+        sides[side]->setDistance(sources[side], 0);
+        sides[side]->queue().push({0, sources[side]});
+    }
+
+    int best = INF; // mu: the shortest start-destination path seen so far
+    int side = 0;
+    while (true)
+    {
+        QueryWorkspace<PriorityQueue> &self = *sides[side];
+        const QueryWorkspace<PriorityQueue> &other = *sides[1 - side];
+        const Graph &g = *graphs[side];
+        PriorityQueue &pq = self.queue();
+        auto &stats = heapStats(pq);
+
+        // A side without queued vertices has reached everything it can, so mu is final
+        if (pq.empty())
+            break;
+
+        auto [dist, u] = pq.pop();
+        if (dist > self.distance(u))
+        {
+            stats.stalePop();
             continue;
+        }
+
+        radius[side] = dist;
+        if (radius[0] + radius[1] >= best)
+            break;
 
-        for (const Edge &edge : graph[u])
+        if (other.distance(u) != INF)
+            best = std::min(best, dist + other.distance(u));
+
+        stats.settle();
+        for (int e = g.beginArc(u), last = g.endArc(u); e < last; e++)
         {
-            int v = edge.to;
-            int weight = edge.weight;
+            stats.relax();
+            int v = g.target(e);
+            int candidate = dist + g.weight(e);
 
-            if (distances[u] + weight < distances[v])
+            if (candidate < self.distance(v))
             {
-                distances[v] = distances[u] + weight;
-                pq.push({distances[v], v});
+                self.setDistance(v, candidate);
+                pq.push({candidate, v});
             }
+            if (other.distance(v) != INF)
+                best = std::min(best, candidate + other.distance(v));
         }
+
+        side = 1 - side;
     }
 
-    return INF; // If the destination is not reachable
+    return best;
+}
+
+/**
+ * @brief Runs bidirectional Dijkstra with a workspace of its own; see the overload above.
+ */
+template <typename PriorityQueue>
+int bidirectional_dijkstra(int start, int destination, const Graph &graph)
+{
+    BidirectionalWorkspace<PriorityQueue> workspace(graph.vertexCount());
+    return bidirectional_dijkstra<PriorityQueue>(start, destination, graph, workspace);
 }
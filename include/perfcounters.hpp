@@ -0,0 +1,166 @@
+#pragma once
+
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/**
+ * @file perfcounters.hpp
+ * @brief Hardware performance counters of the calling thread, read through Linux perf_event_open.
+ *
+ * The counters are opened one by one, so a machine without some of them (a
+ * virtual machine without a PMU, a CPU without dTLB events, a kernel with
+ * perf_event_paranoid above 2) still reports the rest. Missing counters read
+ * as -1. Only user-space events are counted, which perf_event_paranoid 2
+ * allows to unprivileged processes.
+ */
+
+// The number of counters in a PerfSample
+inline constexpr size_t PERF_EVENTS = 6;
+
+// The counters in the order of PerfSample::values, under the names the reports use
+inline constexpr std::array<const char *, PERF_EVENTS> PERF_EVENT_NAMES = {
+    "cycles", "instructions", "l1d_misses", "llc_misses", "dtlb_misses", "branch_misses"};
+
+/**
+ * @struct PerfSample
+ * @brief Counter values, cumulative or over an interval; -1 for counters that could not be read.
+ */
+struct PerfSample
+{
+    std::array<int64_t, PERF_EVENTS> values{-1, -1, -1, -1, -1, -1};
+
+    // The counts from start to this sample; -1 where either lacks the counter
+    PerfSample since(const PerfSample &start) const
+    {
+        PerfSample interval;
+        for (size_t i = 0; i < PERF_EVENTS; i++)
+        {
+            if (values[i] >= 0 && start.values[i] >= 0)
+            {
+                interval.values[i] = values[i] - start.values[i];
+            }
+        }
+        return interval;
+    }
+};
+
+/**
+ * @class PerfCounters
+ * @brief The counters of PERF_EVENT_NAMES, counting the thread that opened them.
+ *
+ * A counter belongs to the thread that constructs the object: read() must be
+ * called on that thread, and the object must not outlive it. When the PMU has
+ * fewer registers than open counters, the kernel multiplexes them and read()
+ * scales every count by the fraction of the time it was actually counting.
+ */
+class PerfCounters
+{
+public:
+    PerfCounters() : descriptors(), failure()
+    {
+        descriptors.fill(-1);
+        const std::array<std::pair<uint32_t, uint64_t>, PERF_EVENTS> events = {{
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {PERF_TYPE_HW_CACHE, cacheMiss(PERF_COUNT_HW_CACHE_L1D)},
+            {PERF_TYPE_HW_CACHE, cacheMiss(PERF_COUNT_HW_CACHE_LL)},
+            {PERF_TYPE_HW_CACHE, cacheMiss(PERF_COUNT_HW_CACHE_DTLB)},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+        }};
+
+        for (size_t i = 0; i < PERF_EVENTS; i++)
+        {
+            perf_event_attr attributes{};
+            attributes.size = sizeof(attributes);
+            attributes.type = events[i].first;
+            attributes.config = events[i].second;
+            attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            attributes.exclude_kernel = 1;
+            attributes.exclude_hv = 1;
+
+            // pid 0 and cpu -1: the calling thread, on whichever CPU it runs
+            long descriptor = syscall(SYS_perf_event_open, &attributes, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+            if (descriptor >= 0)
+            {
+                descriptors[i] = static_cast<int>(descriptor);
+            }
+            else if (failure.empty())
+            {
+                failure = std::string(PERF_EVENT_NAMES[i]) + ": " + std::strerror(errno);
+            }
+        }
+    }
+
+    PerfCounters(const PerfCounters &) = delete;
+    PerfCounters &operator=(const PerfCounters &) = delete;
+
+    ~PerfCounters()
+    {
+        for (int descriptor : descriptors)
+        {
+            if (descriptor >= 0)
+            {
+                close(descriptor);
+            }
+        }
+    }
+
+    /**
+     * @brief Checks whether at least one counter could be opened.
+     */
+    bool available() const
+    {
+        for (int descriptor : descriptors)
+        {
+            if (descriptor >= 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Returns why the first missing counter could not be opened, or "" if all are open.
+     */
+    const std::string &error() const
+    {
+        return failure;
+    }
+
+    /**
+     * @brief Reads the cumulative counts of the calling thread.
+     */
+    PerfSample read() const
+    {
+        PerfSample sample;
+        for (size_t i = 0; i < PERF_EVENTS; i++)
+        {
+            uint64_t raw[3]; // value, time enabled, time running
+            if (descriptors[i] < 0 || ::read(descriptors[i], raw, sizeof(raw)) != static_cast<ssize_t>(sizeof(raw)) || raw[2] == 0)
+            {
+                continue;
+            }
+            double scale = static_cast<double>(raw[1]) / static_cast<double>(raw[2]);
+            sample.values[i] = static_cast<int64_t>(static_cast<double>(raw[0]) * scale);
+        }
+        return sample;
+    }
+
+private:
+    std::array<int, PERF_EVENTS> descriptors; ///< One file descriptor per counter, -1 if it could not be opened.
+    std::string failure;                      ///< Why the first missing counter could not be opened.
+
+    // The config of a PERF_TYPE_HW_CACHE event counting read misses in the given cache
+    static constexpr uint64_t cacheMiss(uint64_t cache)
+    {
+        return cache | (uint64_t{PERF_COUNT_HW_CACHE_OP_READ} << 8) | (uint64_t{PERF_COUNT_HW_CACHE_RESULT_MISS} << 16);
+    }
+};
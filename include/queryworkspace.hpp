@@ -0,0 +1,177 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+/**
+ * @file queryworkspace.hpp
+ * @brief Per-query state of the shortest path searches, kept between queries.
+ *
+ * A point-to-point query usually touches a small part of the graph, but
+ * allocating and filling a distance array of n entries costs O(n) every time.
+ * A QueryWorkspace is sized for the graph once and remembers which vertices a
+ * query has touched, so resetting it for the next query costs time in
+ * proportion to that query rather than to the graph.
+ */
+
+// Constant representing infinity, used to initialize distances
+const int INF = std::numeric_limits<int>::max();
+
+/**
+ * @brief The handle type a workspace stores per vertex: the heap's handle_type, or nothing for plain heaps.
+ */
+template <typename PriorityQueue>
+struct WorkspaceHandle
+{
+    using type = char;
+    static constexpr bool enabled = false;
+};
+
+template <typename PriorityQueue>
+    requires requires { typename PriorityQueue::handle_type; }
+struct WorkspaceHandle<PriorityQueue>
+{
+    using type = typename PriorityQueue::handle_type;
+    static constexpr bool enabled = true;
+};
+
+/**
+ * @class QueryWorkspace
+ * @brief Distances, a settled bitset, heap handles and the heap itself, reused across queries.
+ *
+ * Every vertex whose distance leaves INF is recorded in a touched list; reset()
+ * walks that list to restore the distances and settled bits, and clears the heap,
+ * which keeps its storage. Heap handles are only meaningful for vertices with a
+ * finite distance, so they never need resetting. A workspace serves one query
+ * at a time; concurrent queries need one workspace each.
+ *
+ * @tparam PriorityQueue The heap used by the searches.
+ */
+template <typename PriorityQueue>
+class QueryWorkspace
+{
+public:
+    using Handle = typename WorkspaceHandle<PriorityQueue>::type;
+
+    QueryWorkspace() : QueryWorkspace(0) {}
+
+    /**
+     * @brief Creates a workspace for graphs with the given number of vertices.
+     */
+    explicit QueryWorkspace(int vertexCount) : distances(), settledBits(), handles(), touched(), pq()
+    {
+        resize(vertexCount);
+    }
+
+    /**
+     * @brief Prepares the workspace for a new query on a graph with the given number of vertices.
+     *
+     * Only the vertices touched by the previous query are reset, unless the
+     * vertex count changed.
+     */
+    void reset(int vertexCount)
+    {
+        if (vertexCount != static_cast<int>(distances.size()))
+        {
+            touched.clear();
+            resize(vertexCount);
+        }
+        else
+        {
+            for (int v : touched)
+            {
+                distances[v] = INF;
+                settledBits[v / 64] = 0;
+            }
+            touched.clear();
+        }
+        pq.clear();
+    }
+
+    // Tentative distance of a vertex; INF if not reached yet
+    int distance(int v) const
+    {
+        return distances[v];
+    }
+
+    // Set the distance of a vertex, recording it the first time it is reached
+    void setDistance(int v, int distance)
+    {
+        if (distances[v] == INF)
+        {
+            touched.push_back(v);
+        }
+        distances[v] = distance;
+    }
+
+    // Ask the cache for the distance of a vertex that is about to be read
+    void prefetchDistance(int v) const
+    {
+        __builtin_prefetch(distances.data() + v);
+    }
+
+    // Whether the distance of a vertex is final
+    bool isSettled(int v) const
+    {
+        return (settledBits[v / 64] >> (v % 64)) & 1;
+    }
+
+    // Mark a reached vertex as settled
+    void settle(int v)
+    {
+        settledBits[v / 64] |= uint64_t{1} << (v % 64);
+    }
+
+    // The heap handle of a queued vertex
+    Handle &handle(int v)
+    {
+        return handles[v];
+    }
+
+    // The vertices reached since the last reset, in the order they were reached
+    const std::vector<int> &touchedVertices() const
+    {
+        return touched;
+    }
+
+    PriorityQueue &queue()
+    {
+        return pq;
+    }
+
+private:
+    std::vector<int> distances;        ///< Tentative distance per vertex, INF if not reached.
+    std::vector<uint64_t> settledBits; ///< One bit per vertex; only words of touched vertices are ever set.
+    std::vector<Handle> handles;       ///< Heap handle per vertex (only for addressable heaps).
+    std::vector<int> touched;          ///< Vertices whose distance is finite.
+    PriorityQueue pq;                  ///< The heap, which keeps its storage across queries.
+
+    void resize(int vertexCount)
+    {
+        auto n = static_cast<size_t>(vertexCount);
+        distances.assign(n, INF);
+        settledBits.assign((n + 63) / 64, 0);
+        if constexpr (WorkspaceHandle<PriorityQueue>::enabled)
+        {
+            handles.resize(n);
+        }
+    }
+};
+
+/**
+ * @struct BidirectionalWorkspace
+ * @brief One workspace for the forward and one for the backward half of a bidirectional search.
+ *
+ * @tparam PriorityQueue The heap used by both searches.
+ */
+template <typename PriorityQueue>
+struct BidirectionalWorkspace
+{
+    QueryWorkspace<PriorityQueue> forward;  ///< State of the search from the start on the graph.
+    QueryWorkspace<PriorityQueue> backward; ///< State of the search from the destination on the reverse graph.
+
+    BidirectionalWorkspace() : BidirectionalWorkspace(0) {}
+
+    explicit BidirectionalWorkspace(int vertexCount) : forward(vertexCount), backward(vertexCount) {}
+};
@@ -0,0 +1,277 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <limits>
+
+#include "heap.hpp"
+#include "stats.hpp"
+
+/**
+ * @file radixheap.hpp
+ * @brief Monotone integer priority queues: a radix heap and a Dial bucket queue.
+ *
+ * Dijkstra's algorithm with non-negative integer weights only ever inserts keys
+ * that are at least as large as the last key popped. Both queues here rely on
+ * that property and on the integer HeapKey of the elements, and replace
+ * comparisons between elements by bucket indexing. Pushing a key smaller than
+ * the last popped one is a precondition violation and throws.
+ */
+
+/**
+ * @class RadixHeap
+ * @brief A radix heap with one bucket per bit of the key.
+ *
+ * An element with key k lives in bucket 0 if k equals the last popped key,
+ * otherwise in bucket 1 + (index of the highest bit in which k differs from it).
+ * Popping takes from bucket 0; when it is empty, the first non-empty bucket is
+ * scanned for its minimum, which becomes the new reference key, and its elements
+ * are redistributed into strictly lower buckets. Every element moves down at most
+ * once per bit, which gives amortized O(log C) per operation for keys spanning a
+ * range of C.
+ *
+ * @tparam T The type of elements stored in the heap; HeapKey<T> must be enabled.
+ * @tparam Stats The operation counting policy; see stats.hpp.
+ */
+template <typename T, typename Stats = NoStats>
+class RadixHeap : public Heap<T>
+{
+    static_assert(HeapKey<T>::enabled, "RadixHeap needs an integer HeapKey");
+
+public:
+    RadixHeap() : buckets(), last(0), count(0), counters() {}
+    void push(const T &value) override;
+    T pop() override;
+    bool empty() const override;
+    void clear() override;
+
+    Stats &stats()
+    {
+        return counters;
+    }
+
+private:
+    using Key = uint32_t;
+
+    // One bucket for keys equal to the reference key, plus one per key bit
+    static constexpr int BUCKETS = std::numeric_limits<Key>::digits + 1;
+
+    std::array<std::vector<T>, BUCKETS> buckets; ///< The buckets; only bucket 0 is ordered (all keys equal).
+    Key last;                                    ///< The last popped key, which is also the reference key.
+    size_t count;                                ///< The number of elements in the heap.
+    [[no_unique_address]] Stats counters;        ///< The operation counts.
+
+    static Key keyOf(const T &value)
+    {
+        return static_cast<Key>(HeapKey<T>::get(value));
+    }
+
+    // The bucket for key relative to the current reference key
+    int bucketOf(Key key) const
+    {
+        return key == last ? 0 : std::bit_width(key ^ last);
+    }
+};
+
+template <typename T, typename Stats>
+void RadixHeap<T, Stats>::push(const T &value)
+{
+    Key key = keyOf(value);
+    if (key < last)
+    {
+        throw std::invalid_argument("RadixHeap keys must not decrease below the last popped key");
+    }
+    counters.push();
+    buckets[bucketOf(key)].push_back(value);
+    count++;
+}
+
+template <typename T, typename Stats>
+T RadixHeap<T, Stats>::pop()
+{
+    if (empty())
+    {
+        throw std::runtime_error("Heap is empty");
+    }
+    counters.pop();
+
+    if (buckets[0].empty())
+    {
+        // Find the first non-empty bucket and make its minimum the new reference key
+        int i = 1;
+        while (buckets[i].empty())
+        {
+            i++;
+        }
+        Key minimum = keyOf(buckets[i].front());
+        for (const T &value : buckets[i])
+        {
+            minimum = std::min(minimum, keyOf(value));
+        }
+        last = minimum;
+
+        // Every element of bucket i now lands in a lower bucket
+        for (const T &value : buckets[i])
+        {
+            buckets[bucketOf(keyOf(value))].push_back(value);
+        }
+        buckets[i].clear();
+    }
+
+    T minValue = buckets[0].back();
+    buckets[0].pop_back();
+    count--;
+    return minValue;
+}
+
+template <typename T, typename Stats>
+bool RadixHeap<T, Stats>::empty() const
+{
+    return count == 0;
+}
+
+template <typename T, typename Stats>
+void RadixHeap<T, Stats>::clear()
+{
+    for (std::vector<T> &bucket : buckets)
+    {
+        bucket.clear();
+    }
+    counters.clear();
+    last = 0;
+    count = 0;
+}
+
+/**
+ * @class BucketQueue
+ * @brief Dial's algorithm queue: a circular array of buckets indexed by key.
+ *
+ * While the keys in the queue span less than the number of buckets, key k lives in
+ * bucket k mod B, and popping scans forward from the last popped key. In Dijkstra's
+ * algorithm the live keys span at most the largest arc weight C, so with small
+ * integer weights every operation is O(1) plus the scan, O(C) amortized over a
+ * round of the circle. The ring doubles whenever a key would wrap onto live
+ * buckets, so no bound on the weights has to be known in advance.
+ *
+ * @tparam T The type of elements stored in the heap; HeapKey<T> must be enabled.
+ * @tparam Stats The operation counting policy; see stats.hpp.
+ */
+template <typename T, typename Stats = NoStats>
+class BucketQueue : public Heap<T>
+{
+    static_assert(HeapKey<T>::enabled, "BucketQueue needs an integer HeapKey");
+
+public:
+    BucketQueue() : buckets(INITIAL_BUCKETS), current(0), count(0), counters() {}
+    void push(const T &value) override;
+    T pop() override;
+    bool empty() const override;
+    void clear() override;
+
+    Stats &stats()
+    {
+        return counters;
+    }
+
+private:
+    using Key = uint64_t;
+
+    // Initial ring size; a power of two so that the modulo is a mask
+    static constexpr size_t INITIAL_BUCKETS = 1024;
+
+    std::vector<std::vector<T>> buckets; ///< The ring of buckets, indexed by key mod size.
+    Key current;                         ///< The last popped key; every queued key lies in [current, current + size).
+    size_t count;                        ///< The number of elements in the queue.
+    [[no_unique_address]] Stats counters; ///< The operation counts.
+
+    static Key keyOf(const T &value)
+    {
+        return static_cast<Key>(HeapKey<T>::get(value));
+    }
+
+    std::vector<T> &bucketFor(Key key)
+    {
+        return buckets[key & (buckets.size() - 1)];
+    }
+
+    void grow(Key key);
+};
+
+template <typename T, typename Stats>
+void BucketQueue<T, Stats>::push(const T &value)
+{
+    Key key = keyOf(value);
+    if (key < current)
+    {
+        throw std::invalid_argument("BucketQueue keys must not decrease below the last popped key");
+    }
+    if (key - current >= buckets.size())
+    {
+        grow(key);
+    }
+    counters.push();
+    bucketFor(key).push_back(value);
+    count++;
+}
+
+template <typename T, typename Stats>
+T BucketQueue<T, Stats>::pop()
+{
+    if (empty())
+    {
+        throw std::runtime_error("Heap is empty");
+    }
+    counters.pop();
+    while (bucketFor(current).empty())
+    {
+        current++;
+    }
+    std::vector<T> &bucket = bucketFor(current);
+    T minValue = bucket.back();
+    bucket.pop_back();
+    count--;
+    return minValue;
+}
+
+template <typename T, typename Stats>
+bool BucketQueue<T, Stats>::empty() const
+{
+    return count == 0;
+}
+
+template <typename T, typename Stats>
+void BucketQueue<T, Stats>::clear()
+{
+    // Live keys lie in [current, current + size), so only the non-empty buckets need a look
+    for (size_t i = 0; count > 0 && i < buckets.size(); i++)
+    {
+        std::vector<T> &bucket = bucketFor(current + i);
+        count -= bucket.size();
+        bucket.clear();
+    }
+    counters.clear();
+    current = 0;
+    count = 0;
+}
+
+template <typename T, typename Stats>
+void BucketQueue<T, Stats>::grow(Key key)
+{
+    // Double until the span [current, key] fits, then rehash the live elements
+    size_t size = buckets.size();
+    while (key - current >= size)
+    {
+        size *= 2;
+    }
+    std::vector<std::vector<T>> previous(size);
+    buckets.swap(previous);
+    for (const std::vector<T> &bucket : previous)
+    {
+        for (const T &value : bucket)
+        {
+            bucketFor(keyOf(value)).push_back(value);
+        }
+    }
+}
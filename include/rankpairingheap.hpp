@@ -0,0 +1,348 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <vector>
+
+#include "heap.hpp"
+#include "nodepool.hpp"
+#include "stats.hpp"
+
+/**
+ * @file rankpairingheap.hpp
+ * @brief Implementation of a type-2 rank-pairing heap (Haeupler, Sen and Tarjan).
+ *
+ * A rank-pairing heap matches the amortized bounds of the Fibonacci heap (O(1)
+ * insert and decrease-key, O(log n) pop) with the simple linking of a pairing
+ * heap. It is a list of half-ordered half trees: binary trees in which every
+ * node is no larger than the nodes of its left subtree, and whose root has no
+ * right child. Ranks control which trees are linked, and decrease-key only
+ * repairs ranks on the path above the cut instead of cascading cuts.
+ *
+ * @tparam T The type of elements stored in the heap.
+ */
+
+/**
+ * @struct RankPairingHeapNode
+ * @brief A node of a half tree in the Rank-Pairing Heap.
+ *
+ * The right pointer of a root links the list of roots, since roots have no right
+ * child. Pointers to nodes serve as the handles returned by RankPairingHeap::insert.
+ *
+ * @tparam T The type of the value stored in the node.
+ */
+template <typename T>
+struct RankPairingHeapNode
+{
+    T value;                     ///< The value stored in the node.
+    RankPairingHeapNode *left;   ///< Pointer to the left child.
+    RankPairingHeapNode *right;  ///< Pointer to the right child, or to the next root for a root.
+    RankPairingHeapNode *parent; ///< Pointer to the parent, or nullptr for a root.
+    int rank;                    ///< The rank of the node.
+
+    /**
+     * @brief Constructs a single-node half tree of rank 0.
+     *
+     * @param val The value to be stored in the node.
+     */
+    RankPairingHeapNode(const T &val) : value(val), left(nullptr), right(nullptr), parent(nullptr), rank(0) {}
+
+    RankPairingHeapNode(const RankPairingHeapNode &) = delete;
+    RankPairingHeapNode &operator=(const RankPairingHeapNode &) = delete;
+};
+
+/**
+ * @class RankPairingHeap
+ * @brief A type-2 rank-pairing heap whose nodes come from a pool.
+ *
+ * @tparam T The type of elements stored in the heap.
+ * @tparam Pool The allocator for the nodes, NodePool or NewDeletePool (see nodepool.hpp).
+ * @tparam Stats The operation counting policy; see stats.hpp.
+ */
+template <typename T, template <typename> class Pool = DefaultNodePool, typename Stats = NoStats>
+class RankPairingHeap : public AddressableHeap<T, RankPairingHeapNode<T> *>
+{
+public:
+    using Node = RankPairingHeapNode<T>;
+
+    RankPairingHeap() : roots(nullptr), minNode(nullptr), buckets(), pool(), counters() {}
+
+    RankPairingHeap(const RankPairingHeap &) = delete;
+    RankPairingHeap &operator=(const RankPairingHeap &) = delete;
+
+    ~RankPairingHeap()
+    {
+        if constexpr (!Pool<Node>::bulkRelease)
+        {
+            destroyAll();
+        }
+    }
+
+    /**
+     * @brief Inserts a value as a new one-node half tree.
+     *
+     * @param value The value to be inserted.
+     * @return A handle to the new node, valid until it is popped.
+     */
+    Node *insert(const T &value) override
+    {
+        counters.push();
+        Node *node = pool.create(value);
+        addRoot(node);
+        return node;
+    }
+
+    /**
+     * @brief Lowers the value of a queued node.
+     *
+     * A non-root node is cut out together with its left subtree, which becomes a
+     * new half tree; its right subtree takes its place. Ranks are then lowered
+     * along the path to the root until they satisfy the type-2 rank rule again.
+     *
+     * @param node The handle returned by insert().
+     * @param value The new value, which must not be greater than the current one.
+     * @throws std::invalid_argument If the new value is greater than the current one.
+     */
+    void decrease_key(Node *node, const T &value) override;
+
+    /**
+     * @brief Removes and returns the minimum element.
+     *
+     * The right spine of the minimum's left subtree falls apart into half trees,
+     * which are linked with the remaining roots in a single pass by rank.
+     *
+     * @return The minimum element.
+     * @throws std::runtime_error If the heap is empty.
+     */
+    T pop() override;
+
+    /**
+     * @brief Checks if the heap is empty.
+     */
+    bool empty() const override
+    {
+        return minNode == nullptr;
+    }
+
+    /**
+     * @brief Removes all elements; with a bulk-release pool this is O(1) and keeps the node memory.
+     */
+    void clear() override
+    {
+        if constexpr (Pool<Node>::bulkRelease)
+        {
+            pool.releaseAll();
+        }
+        else
+        {
+            destroyAll();
+        }
+        roots = nullptr;
+        minNode = nullptr;
+        counters.clear();
+    }
+
+    Stats &stats()
+    {
+        return counters;
+    }
+
+private:
+    // Ranks are O(log n); 64 buckets cover every heap that fits in memory
+    static constexpr int MAX_RANK = 64;
+
+    Node *roots;                          ///< Head of the root list, linked through right.
+    Node *minNode;                        ///< The root holding the minimum.
+    std::array<Node *, MAX_RANK> buckets; ///< Scratch table of unpaired half trees by rank, used by pop.
+    Pool<Node> pool;                      ///< Storage for the nodes.
+    [[no_unique_address]] Stats counters; ///< The operation counts.
+
+    // Return every node to the pool
+    void destroyAll()
+    {
+        std::vector<Node *> stack;
+        for (Node *r = roots; r != nullptr;)
+        {
+            Node *next = r->right;
+            r->right = nullptr;
+            stack.push_back(r);
+            r = next;
+        }
+        while (!stack.empty())
+        {
+            Node *node = stack.back();
+            stack.pop_back();
+            if (node->left != nullptr)
+                stack.push_back(node->left);
+            if (node->right != nullptr)
+                stack.push_back(node->right);
+            pool.destroy(node);
+        }
+    }
+
+    static int rankOf(const Node *node)
+    {
+        return node == nullptr ? -1 : node->rank;
+    }
+
+    // Push a half tree onto the root list and update the minimum
+    void addRoot(Node *node)
+    {
+        node->parent = nullptr;
+        node->right = roots;
+        roots = node;
+        if (minNode == nullptr || node->value < minNode->value)
+        {
+            minNode = node;
+        }
+    }
+
+    // Link two half trees of equal rank; the loser becomes the left child of the winner
+    static Node *link(Node *a, Node *b)
+    {
+        if (b->value < a->value)
+        {
+            std::swap(a, b);
+        }
+        b->right = a->left;
+        if (b->right != nullptr)
+        {
+            b->right->parent = b;
+        }
+        b->parent = a;
+        a->left = b;
+        a->rank = b->rank + 1;
+        a->right = nullptr;
+        return a;
+    }
+
+    // Feed one half tree to the one-pass linking: pair it with a waiting tree of the same rank, or wait
+    void collect(Node *tree, Node *&linked)
+    {
+        Node *&slot = buckets[tree->rank];
+        if (slot == nullptr)
+        {
+            slot = tree;
+            return;
+        }
+        Node *result = link(slot, tree);
+        slot = nullptr;
+        result->right = linked;
+        linked = result;
+    }
+};
+
+template <typename T, template <typename> class Pool, typename Stats>
+void RankPairingHeap<T, Pool, Stats>::decrease_key(Node *x, const T &value)
+{
+    if (value > x->value)
+    {
+        throw std::invalid_argument("New key is greater than the current key");
+    }
+    counters.decreaseKey();
+    x->value = value;
+
+    Node *parent = x->parent;
+    if (parent == nullptr)
+    {
+        if (x->value < minNode->value)
+        {
+            minNode = x;
+        }
+        return;
+    }
+
+    // Replace x by its right subtree and make x with its left subtree a new half tree
+    Node *y = x->right;
+    if (parent->left == x)
+    {
+        parent->left = y;
+    }
+    else
+    {
+        parent->right = y;
+    }
+    if (y != nullptr)
+    {
+        y->parent = parent;
+    }
+    x->rank = rankOf(x->left) + 1;
+    addRoot(x);
+
+    // Restore the type-2 rank rule upwards from the old parent
+    for (Node *u = parent; u != nullptr; u = u->parent)
+    {
+        if (u->parent == nullptr)
+        {
+            u->rank = rankOf(u->left) + 1;
+            break;
+        }
+        int a = rankOf(u->left);
+        int b = rankOf(u->right);
+        int rank = std::abs(a - b) > 1 ? std::max(a, b) : std::max(a, b) + 1;
+        if (rank >= u->rank)
+        {
+            break;
+        }
+        u->rank = rank;
+    }
+}
+
+template <typename T, template <typename> class Pool, typename Stats>
+T RankPairingHeap<T, Pool, Stats>::pop()
+{
+    if (empty())
+    {
+        throw std::runtime_error("Heap is empty");
+    }
+    counters.pop();
+    Node *z = minNode;
+    T minValue = z->value;
+
+    Node *linked = nullptr; // half trees produced by links, no longer eligible for pairing
+
+    // The right spine of z's left subtree falls apart into new half trees
+    for (Node *y = z->left; y != nullptr;)
+    {
+        Node *next = y->right;
+        y->parent = nullptr;
+        y->right = nullptr;
+        y->rank = rankOf(y->left) + 1;
+        collect(y, linked);
+        y = next;
+    }
+
+    // The remaining roots take part in the same single linking pass
+    for (Node *r = roots; r != nullptr;)
+    {
+        Node *next = r->right;
+        if (r != z)
+        {
+            r->right = nullptr;
+            collect(r, linked);
+        }
+        r = next;
+    }
+    pool.destroy(z);
+
+    // Rebuild the root list from the linked trees and the unpaired ones
+    roots = nullptr;
+    minNode = nullptr;
+    while (linked != nullptr)
+    {
+        Node *next = linked->right;
+        addRoot(linked);
+        linked = next;
+    }
+    for (Node *&slot : buckets)
+    {
+        if (slot != nullptr)
+        {
+            addRoot(slot);
+            slot = nullptr;
+        }
+    }
+
+    return minValue;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <functional>
+#include <iterator>
+#include <set>
+#include <stdexcept>
+
+#include "heap.hpp"
+
+/**
+ * @class ReferenceHeap
+ * @brief A deliberately simple heap on std::multiset, used as the oracle of the heap tests.
+ *
+ * Like std::priority_queue, pop() returns the element that orders last under
+ * Compare: the largest with the default std::less, the smallest with
+ * std::greater, which is the order of the other heaps in this project. Every
+ * operation is O(log n) on a balanced tree, so the class is meant for checking
+ * results, not for running searches.
+ *
+ * @tparam T The type of elements stored in the heap.
+ * @tparam Compare The strict weak ordering of the elements.
+ */
+template <typename T, typename Compare = std::less<T>>
+class ReferenceHeap : public Heap<T>
+{
+public:
+    ReferenceHeap() : elements() {}
+
+    void push(const T &value) override
+    {
+        elements.insert(value);
+    }
+
+    /**
+     * @brief Removes and returns the element that orders last.
+     *
+     * @throws std::out_of_range If the heap is empty.
+     */
+    T pop() override
+    {
+        if (elements.empty())
+        {
+            throw std::out_of_range("Heap is empty");
+        }
+        auto last = std::prev(elements.end());
+        T value = *last;
+        elements.erase(last);
+        return value;
+    }
+
+    bool empty() const override
+    {
+        return elements.empty();
+    }
+
+    void clear() override
+    {
+        elements.clear();
+    }
+
+    // The element pop() would return; the heap must not be empty
+    const T &top() const
+    {
+        return *std::prev(elements.end());
+    }
+
+    size_t size() const
+    {
+        return elements.size();
+    }
+
+    /**
+     * @brief Removes one element equivalent to the given one, which mirrors a decrease_key as erase and push.
+     *
+     * @return true if such an element was found.
+     */
+    bool erase(const T &value)
+    {
+        auto found = elements.find(value);
+        if (found == elements.end())
+        {
+            return false;
+        }
+        elements.erase(found);
+        return true;
+    }
+
+private:
+    std::multiset<T, Compare> elements; ///< The elements, ordered by Compare.
+};
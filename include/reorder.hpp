@@ -0,0 +1,392 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "alt.hpp"
+#include "graph.hpp"
+
+/**
+ * @file reorder.hpp
+ * @brief Renumbering of the vertices of a graph for memory locality.
+ *
+ * The vertex IDs of the DIMACS files follow no particular order, so the
+ * neighbours of a vertex, and with them their distances and adjacency lists,
+ * are spread over the whole graph. After renumbering, vertices that are close
+ * in the graph get close IDs: a search that grows a ball then touches a few
+ * dense regions of every array, which saves cache and TLB misses.
+ *
+ * The searches run on the renumbered (internal) IDs; VertexPermutation maps the
+ * IDs of the input files (external) in and out.
+ */
+
+/**
+ * @enum VertexOrder
+ * @brief How the vertices of a graph are renumbered.
+ */
+enum class VertexOrder
+{
+    Original,     ///< Keep the order of the input file.
+    CuthillMcKee, ///< Breadth-first, visiting neighbours by increasing degree; starts each component at a vertex of minimum degree.
+    DepthFirst,   ///< Depth-first preorder.
+    Hilbert       ///< Position along a Hilbert curve over the vertex coordinates.
+};
+
+/**
+ * @brief Parses the name of a vertex order as it is given on the command line.
+ *
+ * @param name One of "none", "bfs" (or "cuthill-mckee"), "dfs" and "hilbert".
+ * @throws std::invalid_argument If the name is unknown.
+ */
+inline VertexOrder parseVertexOrder(const std::string &name)
+{
+    if (name == "none")
+    {
+        return VertexOrder::Original;
+    }
+    if (name == "bfs" || name == "cuthill-mckee")
+    {
+        return VertexOrder::CuthillMcKee;
+    }
+    if (name == "dfs")
+    {
+        return VertexOrder::DepthFirst;
+    }
+    if (name == "hilbert")
+    {
+        return VertexOrder::Hilbert;
+    }
+    throw std::invalid_argument("Unknown vertex order " + name);
+}
+
+/**
+ * @class VertexPermutation
+ * @brief A bijection between the vertex IDs of the input files and those the graph is stored with.
+ *
+ * A default-constructed permutation is the identity and costs nothing to apply.
+ */
+class VertexPermutation
+{
+public:
+    VertexPermutation() : internalId(), externalId() {}
+
+    /**
+     * @brief Builds the permutation from the external IDs in their new order.
+     *
+     * @param order order[i] is the external ID of internal vertex i.
+     * @throws std::invalid_argument If order is not a permutation of 0, ..., n - 1.
+     */
+    explicit VertexPermutation(std::vector<int> order) : internalId(order.size(), -1), externalId(std::move(order))
+    {
+        for (size_t i = 0; i < externalId.size(); i++)
+        {
+            int v = externalId[i];
+            if (v < 0 || static_cast<size_t>(v) >= externalId.size() || internalId[v] != -1)
+            {
+                throw std::invalid_argument("Vertex order is not a permutation");
+            }
+            internalId[v] = static_cast<int>(i);
+        }
+    }
+
+    bool isIdentity() const
+    {
+        return externalId.empty();
+    }
+
+    int toInternal(int v) const
+    {
+        return internalId.empty() ? v : internalId[v];
+    }
+
+    int toExternal(int v) const
+    {
+        return externalId.empty() ? v : externalId[v];
+    }
+
+private:
+    std::vector<int> internalId; ///< Internal ID of every external vertex; empty for the identity.
+    std::vector<int> externalId; ///< External ID of every internal vertex; empty for the identity.
+};
+
+// Calls visit(w) for the targets of the arcs leaving and entering v; graph must have its reverse
+template <typename Visit>
+void forEachNeighbour(const Graph &graph, int v, Visit visit)
+{
+    for (const Graph *g : {&graph, &graph.reverse()})
+    {
+        for (int e = g->beginArc(v), last = g->endArc(v); e < last; e++)
+        {
+            visit(g->target(e));
+        }
+    }
+}
+
+// Breadth-first order in which the unvisited neighbours of a vertex are visited by increasing degree
+inline std::vector<int> cuthillMcKeeOrder(const Graph &graph)
+{
+    int n = graph.vertexCount();
+    std::vector<int> degree(static_cast<size_t>(n));
+    for (int v = 0; v < n; v++)
+    {
+        degree[v] = graph.endArc(v) - graph.beginArc(v) + graph.reverse().endArc(v) - graph.reverse().beginArc(v);
+    }
+    auto byDegree = [&](int a, int b)
+    { return degree[a] < degree[b] || (degree[a] == degree[b] && a < b); };
+
+    // Every component starts at its unvisited vertex of minimum degree
+    std::vector<int> starts(static_cast<size_t>(n));
+    std::iota(starts.begin(), starts.end(), 0);
+    std::sort(starts.begin(), starts.end(), byDegree);
+
+    std::vector<char> visited(static_cast<size_t>(n), 0);
+    std::vector<int> order;
+    order.reserve(static_cast<size_t>(n));
+    for (int start : starts)
+    {
+        if (visited[start])
+            continue;
+        visited[start] = 1;
+        order.push_back(start);
+
+        // order doubles as the queue of the breadth-first search
+        for (size_t head = order.size() - 1; head < order.size(); head++)
+        {
+            size_t first = order.size();
+            forEachNeighbour(graph, order[head], [&](int w)
+                             {
+                if (!visited[w])
+                {
+                    visited[w] = 1;
+                    order.push_back(w);
+                } });
+            std::sort(order.begin() + static_cast<std::ptrdiff_t>(first), order.end(), byDegree);
+        }
+    }
+    return order;
+}
+
+// Depth-first preorder over the arcs in both directions, starting the components by ID
+inline std::vector<int> depthFirstOrder(const Graph &graph)
+{
+    int n = graph.vertexCount();
+    const Graph &reverse = graph.reverse();
+    std::vector<char> visited(static_cast<size_t>(n), 0);
+    std::vector<int> order;
+    order.reserve(static_cast<size_t>(n));
+
+    // Every stack entry is a vertex and the position of its next neighbour: out-arcs first, then in-arcs
+    std::vector<std::pair<int, int>> stack;
+    for (int start = 0; start < n; start++)
+    {
+        if (visited[start])
+            continue;
+        visited[start] = 1;
+        order.push_back(start);
+        stack.push_back({start, 0});
+
+        while (!stack.empty())
+        {
+            auto &[v, next] = stack.back();
+            int outDegree = graph.endArc(v) - graph.beginArc(v);
+            int inDegree = reverse.endArc(v) - reverse.beginArc(v);
+            if (next == outDegree + inDegree)
+            {
+                stack.pop_back();
+                continue;
+            }
+            int w = next < outDegree ? graph.target(graph.beginArc(v) + next) : reverse.target(reverse.beginArc(v) + next - outDegree);
+            next++;
+            if (!visited[w])
+            {
+                visited[w] = 1;
+                order.push_back(w);
+                stack.push_back({w, 0});
+            }
+        }
+    }
+    return order;
+}
+
+// Position of a point along the Hilbert curve that fills the 2^32 x 2^32 grid
+inline uint64_t hilbertIndex(uint32_t x, uint32_t y)
+{
+    uint64_t index = 0;
+    for (uint32_t s = 1u << 31; s > 0; s >>= 1)
+    {
+        uint32_t rx = (x & s) ? 1 : 0;
+        uint32_t ry = (y & s) ? 1 : 0;
+        index += static_cast<uint64_t>(s) * s * ((3 * rx) ^ ry);
+
+        // Rotate the quadrant so the curve inside it starts and ends at the right corners
+        if (ry == 0)
+        {
+            if (rx == 1)
+            {
+                x = ~x;
+                y = ~y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return index;
+}
+
+// Vertices sorted by the Hilbert index of their coordinates
+inline std::vector<int> hilbertOrder(const std::vector<Coordinate> &coordinates)
+{
+    // Shift the signed coordinates into unsigned range, preserving their order
+    std::vector<std::pair<uint64_t, int>> keys;
+    keys.reserve(coordinates.size());
+    for (size_t v = 0; v < coordinates.size(); v++)
+    {
+        uint32_t x = static_cast<uint32_t>(coordinates[v].longitude) ^ 0x80000000u;
+        uint32_t y = static_cast<uint32_t>(coordinates[v].latitude) ^ 0x80000000u;
+        keys.push_back({hilbertIndex(x, y), static_cast<int>(v)});
+    }
+    std::sort(keys.begin(), keys.end());
+
+    std::vector<int> order;
+    order.reserve(keys.size());
+    for (const auto &key : keys)
+    {
+        order.push_back(key.second);
+    }
+    return order;
+}
+
+/**
+ * @brief Computes a renumbering of the vertices of a graph.
+ *
+ * @param graph The graph, in the numbering of the input files.
+ * @param method The order to compute.
+ * @param coordinates The vertex positions; only read, and then required, by VertexOrder::Hilbert.
+ * @return The permutation; the identity for VertexOrder::Original.
+ * @throws std::invalid_argument If the Hilbert order lacks one coordinate per vertex.
+ */
+inline VertexPermutation computeVertexOrder(const Graph &graph, VertexOrder method, const std::vector<Coordinate> *coordinates = nullptr)
+{
+    Graph reversible = graph;
+    if (method == VertexOrder::CuthillMcKee || method == VertexOrder::DepthFirst)
+    {
+        if (!reversible.hasReverse())
+        {
+            reversible.computeReverse();
+        }
+    }
+
+    switch (method)
+    {
+    case VertexOrder::Original:
+        return VertexPermutation();
+    case VertexOrder::CuthillMcKee:
+        return VertexPermutation(cuthillMcKeeOrder(reversible));
+    case VertexOrder::DepthFirst:
+        return VertexPermutation(depthFirstOrder(reversible));
+    case VertexOrder::Hilbert:
+        if (coordinates == nullptr || static_cast<int>(coordinates->size()) != graph.vertexCount())
+        {
+            throw std::invalid_argument("The Hilbert order needs one coordinate per vertex");
+        }
+        return VertexPermutation(hilbertOrder(*coordinates));
+    }
+    throw std::invalid_argument("Unknown vertex order");
+}
+
+/**
+ * @brief Returns a copy of the graph with its vertices renumbered.
+ *
+ * The arcs of a vertex keep their order. Calibers and the reverse graph are not
+ * carried over; compute them on the result.
+ *
+ * @param graph The graph, in external IDs.
+ * @param permutation The renumbering.
+ * @return The graph in internal IDs.
+ */
+inline Graph permuteGraph(const Graph &graph, const VertexPermutation &permutation)
+{
+    if (permutation.isIdentity())
+    {
+        return graph;
+    }
+
+    int n = graph.vertexCount();
+    std::vector<int> offsets(static_cast<size_t>(n) + 1, 0);
+    std::vector<int> targets;
+    std::vector<int> weights;
+    targets.reserve(static_cast<size_t>(graph.arcCount()));
+    weights.reserve(static_cast<size_t>(graph.arcCount()));
+    for (int u = 0; u < n; u++)
+    {
+        int v = permutation.toExternal(u);
+        for (int e = graph.beginArc(v), last = graph.endArc(v); e < last; e++)
+        {
+            targets.push_back(permutation.toInternal(graph.target(e)));
+            weights.push_back(graph.weight(e));
+        }
+        offsets[u + 1] = static_cast<int>(targets.size());
+    }
+    return Graph::fromArrays(std::move(offsets), std::move(targets), std::move(weights));
+}
+
+/**
+ * @brief Returns the coordinates indexed by internal IDs.
+ */
+inline std::vector<Coordinate> permuteCoordinates(const std::vector<Coordinate> &coordinates, const VertexPermutation &permutation)
+{
+    if (permutation.isIdentity())
+    {
+        return coordinates;
+    }
+
+    std::vector<Coordinate> permuted;
+    permuted.reserve(coordinates.size());
+    for (size_t u = 0; u < coordinates.size(); u++)
+    {
+        permuted.push_back(coordinates[permutation.toExternal(static_cast<int>(u))]);
+    }
+    return permuted;
+}
+
+/**
+ * @brief Returns a landmark table, built on the graph in external IDs, for the graph in internal IDs.
+ *
+ * The rows of the table move to their internal vertex, and the landmarks are renamed.
+ */
+inline LandmarkTable permuteLandmarkTable(const LandmarkTable &table, const VertexPermutation &permutation)
+{
+    if (permutation.isIdentity())
+    {
+        return table;
+    }
+
+    struct OwnedArrays
+    {
+        std::vector<int> landmarks;
+        std::vector<int> fromLandmark;
+        std::vector<int> toLandmark;
+    };
+
+    auto n = static_cast<size_t>(table.vertexCount());
+    auto k = static_cast<size_t>(table.landmarkCount());
+    auto owned = std::make_shared<OwnedArrays>(OwnedArrays{std::vector<int>(k), std::vector<int>(n * k), std::vector<int>(n * k)});
+    for (size_t i = 0; i < k; i++)
+    {
+        owned->landmarks[i] = permutation.toInternal(table.landmarkArray()[i]);
+    }
+    for (size_t u = 0; u < n; u++)
+    {
+        int v = permutation.toExternal(static_cast<int>(u));
+        std::copy_n(table.fromRow(v), k, owned->fromLandmark.begin() + static_cast<std::ptrdiff_t>(u * k));
+        std::copy_n(table.toRow(v), k, owned->toLandmark.begin() + static_cast<std::ptrdiff_t>(u * k));
+    }
+
+    std::span<const int> l = owned->landmarks, f = owned->fromLandmark, t = owned->toLandmark;
+    return LandmarkTable(std::move(owned), table.vertexCount(), l, f, t);
+}
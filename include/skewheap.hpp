@@ -1,6 +1,8 @@
 #pragma once
 
 #include "heap.hpp"
+#include "nodepool.hpp"
+#include "stats.hpp"
 #include <stdexcept>
 
 /**
@@ -14,42 +16,57 @@
  * @tparam T The type of elements stored in the heap.
  */
 
+/**
+ * @struct SkewHeapNode
+ * @brief A node in the Skew Heap.
+ *
+ * The node represents a single element of the Skew Heap, containing a value
+ * and pointers to its children and its parent. Pointers to nodes serve as the
+ * handles returned by SkewHeap::insert.
+ *
+ * @tparam T The type of the value stored in the node.
+ */
+template <typename T>
+struct SkewHeapNode
+{
+    T value;              ///< The value stored in the node.
+    SkewHeapNode *left;   ///< Pointer to the left child.
+    SkewHeapNode *right;  ///< Pointer to the right child.
+    SkewHeapNode *parent; ///< Pointer to the parent, or nullptr for the root.
+
+    /**
+     * @brief Constructs a new Node.
+     *
+     * @param val The value to be stored in the node.
+     */
+    SkewHeapNode(const T &val) : value(val), left(nullptr), right(nullptr), parent(nullptr) {}
+
+    SkewHeapNode(const SkewHeapNode &) = delete;
+    SkewHeapNode &operator=(const SkewHeapNode &) = delete;
+};
+
 /**
  * @class SkewHeap
  * @brief A Skew Heap implementation.
  *
  * The SkewHeap class provides methods to insert elements, remove the
  * minimum element, and check if the heap is empty. It supports efficient
- * merging of two heaps.
+ * merging of two heaps, and decreasing a key by cutting the node's subtree
+ * and merging it back into the root.
  *
  * @tparam T The type of elements stored in the heap.
+ * @tparam Pool The allocator for the nodes, NodePool or NewDeletePool (see nodepool.hpp).
+ * @tparam Stats The operation counting policy; see stats.hpp.
  */
-template <typename T>
-class SkewHeap : public Heap<T>
+template <typename T, template <typename> class Pool = DefaultNodePool, typename Stats = NoStats>
+class SkewHeap : public AddressableHeap<T, SkewHeapNode<T> *>
 {
 private:
-    /**
-     * @struct Node
-     * @brief A node in the Skew Heap.
-     *
-     * The Node struct represents a single node in the Skew Heap, containing
-     * a value and pointers to its left and right children.
-     */
-    struct Node
-    {
-        T value;     ///< The value stored in the node.
-        Node *left;  ///< Pointer to the left child.
-        Node *right; ///< Pointer to the right child.
+    using Node = SkewHeapNode<T>;
 
-        /**
-         * @brief Constructs a new Node.
-         *
-         * @param val The value to be stored in the node.
-         */
-        Node(const T &val) : value(val), left(nullptr), right(nullptr) {}
-    };
-
-    Node *root; ///< Pointer to the root of the Skew Heap.
+    Node *root;      ///< Pointer to the root of the Skew Heap.
+    Pool<Node> pool; ///< Storage for the nodes.
+    [[no_unique_address]] Stats counters; ///< The operation counts.
 
     /**
      * @brief Merges two Skew Heaps.
@@ -70,6 +87,7 @@ private:
         if (h1->value > h2->value)
             std::swap(h1, h2);
         h1->right = merge(h1->right, h2);
+        h1->right->parent = h1;
         std::swap(h1->left, h1->right);
         return h1;
     }
@@ -87,7 +105,7 @@ private:
         {
             deleteTree(node->left);
             deleteTree(node->right);
-            delete node;
+            pool.destroy(node);
         }
     }
 
@@ -99,11 +117,11 @@ public:
      *
      * @param other The SkewHeap to copy.
      */
-    SkewHeap(const SkewHeap &other) : root(nullptr)
+    SkewHeap(const SkewHeap &other) : root(nullptr), pool(), counters(other.counters)
     {
         if (other.root)
         {
-            root = new Node(other.root->value);
+            root = pool.create(other.root->value);
             copyTree(root, other.root);
         }
     }
@@ -120,11 +138,11 @@ public:
     {
         if (this != &other)
         {
-            deleteTree(root);
-            root = nullptr;
+            clear();
+            counters = other.counters;
             if (other.root)
             {
-                root = new Node(other.root->value);
+                root = pool.create(other.root->value);
                 copyTree(root, other.root);
             }
         }
@@ -133,16 +151,19 @@ public:
     /**
      * @brief Constructs a new SkewHeap.
      */
-    SkewHeap() : root(nullptr) {}
+    SkewHeap() : root(nullptr), pool(), counters() {}
 
     /**
      * @brief Destroys the SkewHeap.
      *
-     * This destructor deletes all nodes in the heap.
+     * This destructor deletes all nodes in the heap, or leaves them to a bulk-release pool.
      */
     ~SkewHeap()
     {
-        deleteTree(root);
+        if constexpr (!Pool<Node>::bulkRelease)
+        {
+            deleteTree(root);
+        }
     }
 
     /**
@@ -152,11 +173,52 @@ public:
      * new node with the existing heap.
      *
      * @param value The value to be inserted.
+     * @return Node* A handle to the new node, valid until it is popped.
      */
-    void push(const T &value) override
+    Node *insert(const T &value) override
     {
-        Node *newNode = new Node(value);
+        counters.push();
+        Node *newNode = pool.create(value);
         root = merge(root, newNode);
+        root->parent = nullptr;
+        return newNode;
+    }
+
+    /**
+     * @brief Lowers the value of a queued node.
+     *
+     * The node's subtree is cut from its parent and merged with the rest of
+     * the heap; the subtree stays heap-ordered because only its root changed.
+     *
+     * @param node The handle returned by insert().
+     * @param value The new value, which must not be greater than the current one.
+     * @throws std::invalid_argument If the new value is greater than the current one.
+     */
+    void decrease_key(Node *node, const T &value) override
+    {
+        if (value > node->value)
+        {
+            throw std::invalid_argument("New key is greater than the current key");
+        }
+        counters.decreaseKey();
+        node->value = value;
+
+        Node *parent = node->parent;
+        if (parent == nullptr || !(node->value < parent->value))
+        {
+            return;
+        }
+        if (parent->left == node)
+        {
+            parent->left = nullptr;
+        }
+        else
+        {
+            parent->right = nullptr;
+        }
+        node->parent = nullptr;
+        root = merge(root, node);
+        root->parent = nullptr;
     }
 
     /**
@@ -174,10 +236,17 @@ public:
         {
             throw std::runtime_error("Heap is empty");
         }
+        counters.pop();
         T minValue = root->value;
         Node *oldRoot = root;
+        if (root->left)
+            root->left->parent = nullptr;
+        if (root->right)
+            root->right->parent = nullptr;
         root = merge(root->left, root->right);
-        delete oldRoot;
+        if (root)
+            root->parent = nullptr;
+        pool.destroy(oldRoot);
         return minValue;
     }
 
@@ -193,6 +262,28 @@ public:
         return root == nullptr;
     }
 
+    /**
+     * @brief Removes all elements; with a bulk-release pool this is O(1) and keeps the node memory.
+     */
+    void clear() override
+    {
+        if constexpr (Pool<Node>::bulkRelease)
+        {
+            pool.releaseAll();
+        }
+        else
+        {
+            deleteTree(root);
+        }
+        root = nullptr;
+        counters.clear();
+    }
+
+    Stats &stats()
+    {
+        return counters;
+    }
+
 private:
     /**
      * @brief Copies the tree from the source node to the destination node.
@@ -209,12 +300,14 @@ private:
         {
             if (src->left)
             {
-                dest->left = new Node(src->left->value);
+                dest->left = pool.create(src->left->value);
+                dest->left->parent = dest;
                 copyTree(dest->left, src->left);
             }
             if (src->right)
             {
-                dest->right = new Node(src->right->value);
+                dest->right = pool.create(src->right->value);
+                dest->right->parent = dest;
                 copyTree(dest->right, src->right);
             }
         }
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+
+/**
+ * @file stats.hpp
+ * @brief Compile-time policies that count the work done by the heaps and by dijkstra.
+ *
+ * Every heap takes a Stats policy as its last template parameter and calls its
+ * hooks from push, pop, decrease_key and clear; dijkstra adds the stale pops,
+ * settled vertices and scanned arcs to the policy of its heap. With NoStats,
+ * the default, every hook is an empty inline function and the policy object
+ * takes no space, so the heaps compile to exactly what they were without it.
+ * With CountingStats, the counts of a query are read and restarted with take().
+ */
+
+/**
+ * @struct OperationCounts
+ * @brief The operations counted during one query.
+ */
+struct OperationCounts
+{
+    int64_t pushes = 0;         ///< Elements pushed or inserted.
+    int64_t pops = 0;           ///< Elements popped, stale ones included.
+    int64_t stalePops = 0;      ///< Pops of vertices whose distance had improved since the push.
+    int64_t decreaseKeys = 0;   ///< Calls of decrease_key.
+    int64_t peakSize = 0;       ///< The largest number of elements in the heap at once.
+    int64_t settled = 0;        ///< Vertices whose final distance the search fixed.
+    int64_t relaxed = 0;        ///< Arcs scanned from settled vertices.
+    int64_t links = 0;          ///< Trees linked under another tree (Fibonacci heap).
+    int64_t consolidations = 0; ///< Passes over the root list that merge trees of equal degree (Fibonacci heap).
+
+    // Add the counts of another heap or query; the peak sizes add up to a bound for heaps used side by side
+    OperationCounts &operator+=(const OperationCounts &other)
+    {
+        pushes += other.pushes;
+        pops += other.pops;
+        stalePops += other.stalePops;
+        decreaseKeys += other.decreaseKeys;
+        peakSize += other.peakSize;
+        settled += other.settled;
+        relaxed += other.relaxed;
+        links += other.links;
+        consolidations += other.consolidations;
+        return *this;
+    }
+};
+
+/**
+ * @struct NoStats
+ * @brief The policy that counts nothing and costs nothing.
+ */
+struct NoStats
+{
+    static constexpr bool enabled = false;
+
+    void push() {}
+    void pop() {}
+    void decreaseKey() {}
+    void clear() {}
+    void link() {}
+    void consolidate() {}
+    void stalePop() {}
+    void settle() {}
+    void relax() {}
+};
+
+/**
+ * @class CountingStats
+ * @brief The policy that counts every operation.
+ *
+ * The current number of elements is tracked here rather than asked from the
+ * heap, since not every heap knows its size.
+ */
+class CountingStats
+{
+public:
+    static constexpr bool enabled = true;
+
+    CountingStats() : counts(), size(0) {}
+
+    void push()
+    {
+        counts.pushes++;
+        size++;
+        counts.peakSize = std::max(counts.peakSize, size);
+    }
+
+    void pop()
+    {
+        counts.pops++;
+        size--;
+    }
+
+    void decreaseKey()
+    {
+        counts.decreaseKeys++;
+    }
+
+    void clear()
+    {
+        size = 0;
+    }
+
+    void link()
+    {
+        counts.links++;
+    }
+
+    void consolidate()
+    {
+        counts.consolidations++;
+    }
+
+    void stalePop()
+    {
+        counts.stalePops++;
+    }
+
+    void settle()
+    {
+        counts.settled++;
+    }
+
+    void relax()
+    {
+        counts.relaxed++;
+    }
+
+    /**
+     * @brief Returns the counts since the last call and starts over from zero.
+     *
+     * Elements still in the heap stay counted in its size, so the next push measures the peak from there.
+     */
+    OperationCounts take()
+    {
+        OperationCounts taken = counts;
+        counts = OperationCounts();
+        return taken;
+    }
+
+private:
+    OperationCounts counts; ///< The counts since the last take().
+    int64_t size;           ///< The number of elements in the heap.
+};
+
+// Build with -DPATHFINDER_COUNT_OPERATIONS=1 to run the benchmark with counting heaps
+#ifndef PATHFINDER_COUNT_OPERATIONS
+#define PATHFINDER_COUNT_OPERATIONS 0
+#endif
+
+// The policy the benchmark builds its heaps with
+using BenchmarkStats = std::conditional_t<PATHFINDER_COUNT_OPERATIONS != 0, CountingStats, NoStats>;
+
+/**
+ * @brief Returns the stats policy of a heap, or a NoStats for heaps that have none.
+ */
+template <typename PriorityQueue>
+decltype(auto) heapStats(PriorityQueue &pq)
+{
+    if constexpr (requires { pq.stats(); })
+    {
+        return (pq.stats());
+    }
+    else
+    {
+        static thread_local NoStats none;
+        return (none);
+    }
+}
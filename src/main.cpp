@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -7,127 +8,827 @@
 #include <limits>
 #include <chrono>
 #include <functional>
+#include <memory>
 
 #include "pathfinder.hpp"
+#include "astar.hpp"
+#include "alt.hpp"
+#include "benchmark.hpp"
+#include "contractionhierarchy.hpp"
+#include "distancetable.hpp"
+#include "hublabels.hpp"
+#include "graphcache.hpp"
+#include "dimacs.hpp"
+#include "parallel.hpp"
+#include "reorder.hpp"
+#include "generators.hpp"
+#include "heaptrace.hpp"
 #include "fiboheap.hpp"
 #include "binaryheap.hpp"
+#include "indexedbinaryheap.hpp"
+#include "daryheap.hpp"
+#include "radixheap.hpp"
+#include "multilevelbuckets.hpp"
+#include "pairingheap.hpp"
+#include "rankpairingheap.hpp"
 #include "skewheap.hpp"
 
 using namespace std;
 using namespace std::chrono;
 
-vector<vector<Edge>> readGraphFromFile(const string &filename)
+// Load a graph from either a binary graph cache or a DIMACS .gr text file
+Graph loadGraph(const string &filename)
 {
-    vector<vector<Edge>> graph;
+    if (isGraphCache(filename))
+    {
+        return loadGraphCache(filename);
+    }
+    return readGraphFromFile(filename);
+}
+
+// One section of the benchmark: an algorithm run with one heap on the whole query batch
+struct Section
+{
+    string name;                                               // Title in the reports
+    string algorithm;                                          // Key that --algorithms selects it by
+    string heap;                                               // Key that --heaps selects it by
+    function<BenchmarkResult(const BenchmarkOptions &)> run; // Runs and times the batch
+};
+
+template <class T, class Strategy = LazyInsertion>
+Section dijkstraSection(string name, string algorithm, string heap, const Graph &graph, const vector<pair<int, int>> &queries)
+{
+    return {move(name), move(algorithm), move(heap), [&graph, &queries](const BenchmarkOptions &options)
+            { return runBenchmark<QueryWorkspace<T>>(graph.vertexCount(), queries, options, [&](int start, int end, QueryWorkspace<T> &workspace)
+                                                     { return dijkstra<T, Strategy>(start, end, graph, workspace); }); }};
+}
 
-    ifstream file(filename);
-    if (!file.is_open())
+template <class T>
+Section bidirectionalSection(string name, string heap, const Graph &graph, const vector<pair<int, int>> &queries)
+{
+    return {move(name), "bidirectional", move(heap), [&graph, &queries](const BenchmarkOptions &options)
+            { return runBenchmark<BidirectionalWorkspace<T>>(graph.vertexCount(), queries, options, [&](int start, int end, BidirectionalWorkspace<T> &workspace)
+                                                             { return bidirectional_dijkstra<T>(start, end, graph, workspace); }); }};
+}
+
+template <class T, class Potential>
+Section astarSection(string name, string algorithm, string heap, const Graph &graph, shared_ptr<const Potential> potential,
+                     const vector<pair<int, int>> &queries)
+{
+    return {move(name), move(algorithm), move(heap), [&graph, potential, &queries](const BenchmarkOptions &options)
+            { return runBenchmark<QueryWorkspace<T>>(graph.vertexCount(), queries, options, [&](int start, int end, QueryWorkspace<T> &workspace)
+                                                     { return astar<T>(start, end, graph, *potential, workspace); }); }};
+}
+
+// The hierarchy and the hub labels are built from the graph file, so they take the queries in its IDs
+template <class T>
+Section contractionHierarchySection(string name, string heap, shared_ptr<const ContractionHierarchy> hierarchy, const vector<pair<int, int>> &queries)
+{
+    return {move(name), "ch", move(heap), [hierarchy, &queries](const BenchmarkOptions &options)
+            { return runBenchmark<BidirectionalWorkspace<T>>(hierarchy->vertexCount(), queries, options, [&](int start, int end, BidirectionalWorkspace<T> &workspace)
+                                                             { return ch_query<T>(start, end, *hierarchy, workspace); }); }};
+}
+
+// Hub label queries keep no per-thread state
+struct NoWorkspace
+{
+    explicit NoWorkspace(int) {}
+};
+
+Section hubLabelSection(shared_ptr<const HubLabels> labels, const vector<pair<int, int>> &queries)
+{
+    return {"Hub Labels", "hub-labels", "none", [labels, &queries](const BenchmarkOptions &options)
+            { return runBenchmark<NoWorkspace>(labels->vertexCount(), queries, options, [&](int start, int end, NoWorkspace &)
+                                               { return hub_label_query(start, end, *labels); }); }};
+}
+
+// Split a comma-separated list of keys
+vector<string> splitList(const string &list)
+{
+    vector<string> items;
+    stringstream stream(list);
+    string item;
+    while (getline(stream, item, ','))
     {
-        cerr << "Error opening file" << endl;
-        exit(1);
+        if (!item.empty())
+        {
+            items.push_back(item);
+        }
     }
+    return items;
+}
 
-    string line;
-    int n = 0, m = 0; // n: number of nodes, m: number of arcs
+// Convert a DIMACS .gr file into a binary graph cache and verify the result
+int convertGraph(const string &input_filename, const string &output_filename)
+{
+    auto graph = readGraphFromFile(input_filename);
+    writeGraphCache(graph, output_filename);
+    auto cached = loadGraphCache(output_filename, true);
+    cout << "Wrote " << cached.vertexCount() << " vertices and " << cached.arcCount()
+         << " arcs to " << output_filename << endl;
+    return 0;
+}
 
-    // Pre-allocate a buffer for reading lines
-    line.reserve(256); // Assuming lines won't exceed 256 characters
+// Select landmarks, compute their distance table and write it to disk
+int buildLandmarks(const string &graph_filename, const string &table_filename, int count, const string &method,
+                   const string &coordinates_filename)
+{
+    auto graph = loadGraph(graph_filename);
+    vector<Coordinate> coordinates;
+    if (!coordinates_filename.empty())
+    {
+        coordinates = readCoordinatesFromFile(coordinates_filename);
+    }
+
+    LandmarkSelection selection;
+    if (method == "farthest")
+    {
+        selection = LandmarkSelection::Farthest;
+    }
+    else if (method == "avoid")
+    {
+        selection = LandmarkSelection::Avoid;
+    }
+    else if (method == "planar")
+    {
+        selection = LandmarkSelection::Planar;
+    }
+    else
+    {
+        throw invalid_argument("Unknown landmark selection method " + method);
+    }
+
+    auto start_time = high_resolution_clock::now();
+    auto table = selectLandmarkTable(graph, count, selection, coordinates.empty() ? nullptr : &coordinates);
+    auto elapsed = duration_cast<milliseconds>(high_resolution_clock::now() - start_time).count();
+    writeLandmarkTable(table, table_filename);
+    loadLandmarkTable(table_filename, graph, true);
+    cout << "Wrote " << table.landmarkCount() << " landmarks to " << table_filename << " in " << elapsed << " ms" << endl;
+    return 0;
+}
 
-    while (getline(file, line))
+// Contract a graph and write the hierarchy to disk
+int buildHierarchy(const string &graph_filename, const string &hierarchy_filename, int threads)
+{
+    auto graph = loadGraph(graph_filename);
+    auto start_time = high_resolution_clock::now();
+    auto hierarchy = buildContractionHierarchy(graph, threads);
+    auto elapsed = duration_cast<milliseconds>(high_resolution_clock::now() - start_time).count();
+    writeContractionHierarchy(hierarchy, hierarchy_filename);
+    loadContractionHierarchy(hierarchy_filename, true);
+    cout << "Wrote a hierarchy with " << hierarchy.upward().arcCount() << " upward and " << hierarchy.downward().arcCount()
+         << " downward arcs to " << hierarchy_filename << " in " << elapsed << " ms" << endl;
+    return 0;
+}
+
+// Compute the hub labels of a contraction hierarchy and write them to disk
+int buildLabels(const string &hierarchy_filename, const string &labels_filename, int threads)
+{
+    // An offline step, so it can afford to read the whole file once more for the checksum
+    auto hierarchy = loadContractionHierarchy(hierarchy_filename, true);
+    auto start_time = high_resolution_clock::now();
+    auto labels = buildHubLabels(hierarchy, threads);
+    auto elapsed = duration_cast<milliseconds>(high_resolution_clock::now() - start_time).count();
+    writeHubLabels(labels, labels_filename);
+    loadHubLabels(labels_filename, true);
+    cout << "Wrote " << labels.entryCount() << " label entries for " << labels.vertexCount() << " vertices to "
+         << labels_filename << " in " << elapsed << " ms" << endl;
+    return 0;
+}
+
+// Compute the distances from every source to every target and print them as a matrix, one row per source;
+// uses the bucket algorithm if a hierarchy file is given and one Dijkstra search per source otherwise
+int computeTable(const string &graph_filename, const string &sources_filename, const string &targets_filename, int threads,
+                 const string &hierarchy_filename)
+{
+    if (threads < 1)
+    {
+        throw invalid_argument("The number of threads must be at least 1");
+    }
+    auto graph = loadGraph(graph_filename);
+    auto sources = readVerticesFromFile(sources_filename);
+    auto targets = readVerticesFromFile(targets_filename);
+    for (const auto *vertices : {&sources, &targets})
     {
-        if (line.empty() || line[0] == 'c') // Skip comments
+        for (int v : *vertices)
         {
-            continue;
+            if (v < 0 || v >= graph.vertexCount())
+            {
+                cerr << "Vertex " << v + 1 << " is outside the graph" << endl;
+                return 1;
+            }
         }
+    }
 
-        if (line[0] == 'p') // Parse size info
+    vector<int> table;
+    auto start_time = high_resolution_clock::now();
+    if (hierarchy_filename.empty())
+    {
+        table = distance_table<BinaryHeap<NearestRecord>>(sources, targets, graph, threads);
+    }
+    else
+    {
+        auto hierarchy = loadContractionHierarchy(hierarchy_filename);
+        if (hierarchy.vertexCount() != graph.vertexCount())
+        {
+            throw runtime_error(hierarchy_filename + ": hierarchy does not belong to this graph");
+        }
+        start_time = high_resolution_clock::now();
+        table = ch_distance_table<BinaryHeap<NearestRecord>>(sources, targets, hierarchy, threads);
+    }
+    auto elapsed = duration_cast<microseconds>(high_resolution_clock::now() - start_time).count();
+
+    cout << "Distance table (" << (hierarchy_filename.empty() ? "Dijkstra" : "CH buckets") << "): "
+         << sources.size() << " x " << targets.size() << endl;
+    for (size_t i = 0; i < sources.size(); i++)
+    {
+        for (size_t j = 0; j < targets.size(); j++)
+        {
+            int distance = table[i * targets.size() + j];
+            cout << (j > 0 ? " " : "");
+            if (distance == INF)
+            {
+                cout << "INF";
+            }
+            else
+            {
+                cout << distance;
+            }
+        }
+        cout << '\n';
+    }
+    cout << "Total time: " << elapsed << " microseconds on " << threads << " threads" << endl;
+    return 0;
+}
+
+// Record the heap operations of a lazy Dijkstra search for every query and write them as a heap trace
+int recordTrace(const string &graph_filename, const string &queries_filename, const string &trace_filename)
+{
+    auto graph = loadGraph(graph_filename);
+    auto queries = readQueriesFromFile(queries_filename);
+    for (const auto &[start, end] : queries)
+    {
+        if (start < 0 || start >= graph.vertexCount() || end < 0 || end >= graph.vertexCount())
+        {
+            cerr << "Query " << start + 1 << " " << end + 1 << " refers to a vertex outside the graph\n";
+            return 1;
+        }
+    }
+
+    QueryWorkspace<RecordingHeap<>> workspace(graph.vertexCount());
+    for (const auto &[start, end] : queries)
+    {
+        dijkstra<RecordingHeap<>>(start, end, graph, workspace);
+    }
+    const HeapTrace &trace = workspace.queue().trace();
+    writeHeapTrace(trace, trace_filename);
+    cout << "Recorded " << trace.operationCount() << " heap operations (" << trace.pushCount() << " pushes) of "
+         << queries.size() << " queries in " << trace.bytes().size() << " bytes to " << trace_filename << endl;
+    return 0;
+}
+
+// Print the usage of the query benchmark and of every subcommand; to stdout when asked for with --help
+void printUsage(const string &program, ostream &out = cerr)
+{
+    out << "Usage: " << program << " [options] <graph_filename> <queries_filename> [threads [coordinates_filename|- [landmarks_filename|- [hierarchy_filename|- [labels_filename]]]]]\n"
+        << "       " << program << " convert <graph_filename> <cache_filename>\n"
+        << "       " << program << " landmarks <graph_filename> <table_filename> [count [farthest|avoid|planar [coordinates_filename]]]\n"
+        << "       " << program << " contract <graph_filename> <hierarchy_filename> [threads]\n"
+        << "       " << program << " labels <hierarchy_filename> <labels_filename> [threads]\n"
+        << "       " << program << " table <graph_filename> <sources_filename> <targets_filename> [threads [hierarchy_filename]]\n"
+        << "       " << program << " trace <graph_filename> <queries_filename> <trace_filename>\n"
+        << "       " << program << " generate <family> <vertices> <graph_filename> [coordinates_filename|- [queries_filename|- [degree|- [min_weight max_weight [seed]]]]]\n"
+        << "       " << program << " sweep [options] <family> <sizes> [queries [threads [degree|- [min_weight max_weight [seed]]]]]\n"
+        << "Families: grid, geometric, delaunay, power-law; sizes is a comma-separated list of vertex counts\n"
+        << "Options:\n"
+        << "  --algorithms <list>   comma-separated algorithms to run (default: all that the inputs allow)\n"
+        << "  --heaps <list>        comma-separated heaps to run (default: all)\n"
+        << "  --list                print the sections with their algorithm and heap keys instead of running them\n"
+        << "  --perf                measure every query with hardware performance counters, where the system allows it\n"
+        << "  --warmup <n>          untimed runs of the query batch before the measured ones (default 0)\n"
+        << "  --repetitions <n>     measured runs of the query batch (default 1)\n"
+        << "  --shuffle <seed>      answer the queries in a random order, reshuffled for every run\n"
+        << "  --format <format>     text, json or csv (default text)\n"
+        << "  --order <method>      renumber the vertices first: none, bfs, dfs or hilbert (default none)\n"
+        << "  --help, -h            print this help and exit\n";
+}
+
+// The options shared by the query benchmark and the size sweep, plus the remaining positional arguments
+struct BenchmarkArguments
+{
+    BenchmarkOptions options{};
+    ReportFormat format = ReportFormat::Text;
+    string order_method = "none";
+    vector<string> algorithms{};
+    vector<string> heaps{};
+    bool list = false;
+    bool help = false;
+    vector<string> positional{};
+};
+
+// Parse the benchmark options, which may appear before, between or after the positional arguments
+BenchmarkArguments parseBenchmarkArguments(const vector<string> &args)
+{
+    BenchmarkArguments parsed;
+    BenchmarkOptions &options = parsed.options;
+    for (size_t i = 0; i < args.size(); i++)
+    {
+        const string &arg = args[i];
+        if (arg == "--help" || arg == "-h")
+        {
+            parsed.help = true;
+            return parsed;
+        }
+        if (arg.rfind("--", 0) != 0)
+        {
+            parsed.positional.push_back(arg);
+            continue;
+        }
+        if (arg == "--list")
         {
-            // Use sscanf for faster parsing
-            sscanf(line.c_str(), "p %*s %d %d", &n, &m);
-            graph.resize(n); // Pre-allocate space for the graph
+            parsed.list = true;
             continue;
         }
+        if (arg == "--perf")
+        {
+            options.perfCounters = true;
+            continue;
+        }
+        if (i + 1 == args.size())
+        {
+            throw invalid_argument("Option " + arg + " needs a value");
+        }
+        const string &value = args[++i];
+        if (arg == "--algorithms")
+        {
+            parsed.algorithms = splitList(value);
+        }
+        else if (arg == "--heaps")
+        {
+            parsed.heaps = splitList(value);
+        }
+        else if (arg == "--warmup")
+        {
+            options.warmup = stoi(value);
+        }
+        else if (arg == "--repetitions")
+        {
+            options.repetitions = stoi(value);
+        }
+        else if (arg == "--shuffle")
+        {
+            options.shuffle = true;
+            options.seed = static_cast<unsigned>(stoul(value));
+        }
+        else if (arg == "--format")
+        {
+            parsed.format = parseReportFormat(value);
+        }
+        else if (arg == "--order")
+        {
+            parsed.order_method = value;
+        }
+        else
+        {
+            throw invalid_argument("Unknown option " + arg);
+        }
+    }
 
-        if (line[0] == 'a') // Parse arc information
+    if (options.warmup < 0 || options.repetitions < 1)
+    {
+        throw invalid_argument("The warmup must not be negative and there must be at least one repetition");
+    }
+    return parsed;
+}
+
+// Take the thread count from a positional argument and check that the hardware counters can be read, if asked for
+void configureRun(BenchmarkArguments &arguments, size_t threads_index)
+{
+    BenchmarkOptions &options = arguments.options;
+    options.threads = arguments.positional.size() > threads_index ? stoi(arguments.positional[threads_index]) : 1;
+    if (options.threads < 1)
+    {
+        throw invalid_argument("The number of threads must be at least 1");
+    }
+    if (options.perfCounters)
+    {
+        // Without a PMU, or with perf_event_paranoid above 2, the benchmark runs without counters
+        PerfCounters probe;
+        if (!probe.available())
         {
-            int u, v, w;
-            // Use sscanf for faster parsing
-            sscanf(line.c_str(), "a %d %d %d", &u, &v, &w);
-            graph[u - 1].push_back({v - 1, w});
+            cerr << "Hardware counters are unavailable (" << probe.error() << "); running without them\n";
+            options.perfCounters = false;
+        }
+        else if (!probe.error().empty())
+        {
+            cerr << "Some hardware counters are unavailable (" << probe.error() << ")\n";
         }
     }
+}
+
+// The sections that search the graph itself: every heap with Dijkstra, bidirectional Dijkstra and, given coordinates, A*
+vector<Section> graphSections(const Graph &graph, const vector<Coordinate> &coordinates, const vector<pair<int, int>> &q)
+{
+    vector<Section> sections = {
+        dijkstraSection<FiboHeap<NearestRecord, DefaultNodePool, BenchmarkStats>>("Fibonacci Heap", "dijkstra", "fibonacci", graph, q),
+        dijkstraSection<BinaryHeap<NearestRecord, BenchmarkStats>>("Binary Heap", "dijkstra", "binary", graph, q),
+        dijkstraSection<SkewHeap<NearestRecord, DefaultNodePool, BenchmarkStats>>("Skew Heap", "dijkstra", "skew", graph, q),
+        dijkstraSection<DaryHeap<NearestRecord, 4, BenchmarkStats>>("4-ary Heap", "dijkstra", "4-ary", graph, q),
+        dijkstraSection<DaryHeap<NearestRecord, 8, BenchmarkStats>>("8-ary Heap", "dijkstra", "8-ary", graph, q),
+        dijkstraSection<DaryHeap<NearestRecord, 16, BenchmarkStats>>("16-ary Heap", "dijkstra", "16-ary", graph, q),
+        dijkstraSection<PairingHeap<NearestRecord, TwoPass, DefaultNodePool, BenchmarkStats>>("Pairing Heap (two-pass)", "dijkstra", "pairing", graph, q),
+        dijkstraSection<PairingHeap<NearestRecord, MultiPass, DefaultNodePool, BenchmarkStats>>("Pairing Heap (multipass)", "dijkstra", "pairing-multipass", graph, q),
+        dijkstraSection<RankPairingHeap<NearestRecord, DefaultNodePool, BenchmarkStats>>("Rank-Pairing Heap", "dijkstra", "rank-pairing", graph, q),
+        dijkstraSection<RadixHeap<NearestRecord, BenchmarkStats>>("Radix Heap", "dijkstra", "radix", graph, q),
+        dijkstraSection<BucketQueue<NearestRecord, BenchmarkStats>>("Bucket Queue", "dijkstra", "bucket", graph, q),
+        dijkstraSection<MultiLevelBuckets<NearestRecord, 8, BenchmarkStats>>("Multi-Level Buckets", "dijkstra", "multilevel", graph, q),
+        dijkstraSection<MultiLevelBuckets<NearestRecord, 8, BenchmarkStats>, Caliber>("Multi-Level Buckets (caliber)", "caliber", "multilevel", graph, q),
+        dijkstraSection<FiboHeap<NearestRecord, DefaultNodePool, BenchmarkStats>, DecreaseKey>("Fibonacci Heap (decrease-key)", "decrease-key", "fibonacci", graph, q),
+        dijkstraSection<IndexedBinaryHeap<NearestRecord, BenchmarkStats>, DecreaseKey>("Indexed Binary Heap (decrease-key)", "decrease-key", "indexed-binary", graph, q),
+        dijkstraSection<SkewHeap<NearestRecord, DefaultNodePool, BenchmarkStats>, DecreaseKey>("Skew Heap (decrease-key)", "decrease-key", "skew", graph, q),
+        dijkstraSection<PairingHeap<NearestRecord, TwoPass, DefaultNodePool, BenchmarkStats>, DecreaseKey>("Pairing Heap (two-pass, decrease-key)", "decrease-key", "pairing", graph, q),
+        dijkstraSection<PairingHeap<NearestRecord, MultiPass, DefaultNodePool, BenchmarkStats>, DecreaseKey>("Pairing Heap (multipass, decrease-key)", "decrease-key", "pairing-multipass", graph, q),
+        dijkstraSection<RankPairingHeap<NearestRecord, DefaultNodePool, BenchmarkStats>, DecreaseKey>("Rank-Pairing Heap (decrease-key)", "decrease-key", "rank-pairing", graph, q),
+        dijkstraSection<FiboHeap<NearestRecord, NewDeletePool, BenchmarkStats>>("Fibonacci Heap (new/delete)", "dijkstra", "fibonacci-new-delete", graph, q),
+        dijkstraSection<SkewHeap<NearestRecord, NewDeletePool, BenchmarkStats>>("Skew Heap (new/delete)", "dijkstra", "skew-new-delete", graph, q),
+        bidirectionalSection<BinaryHeap<NearestRecord, BenchmarkStats>>("Bidirectional Binary Heap", "binary", graph, q),
+        bidirectionalSection<DaryHeap<NearestRecord, 4, BenchmarkStats>>("Bidirectional 4-ary Heap", "4-ary", graph, q),
+        bidirectionalSection<PairingHeap<NearestRecord, TwoPass, DefaultNodePool, BenchmarkStats>>("Bidirectional Pairing Heap", "pairing", graph, q),
+        bidirectionalSection<RadixHeap<NearestRecord, BenchmarkStats>>("Bidirectional Radix Heap", "radix", graph, q),
+    };
 
-    file.close();
-    return graph;
+    if (!coordinates.empty())
+    {
+        auto potential = make_shared<const GeometricPotential>(graph, coordinates);
+        sections.push_back(astarSection<BinaryHeap<NearestRecord, BenchmarkStats>>("A* Binary Heap", "astar", "binary", graph, potential, q));
+        sections.push_back(astarSection<DaryHeap<NearestRecord, 4, BenchmarkStats>>("A* 4-ary Heap", "astar", "4-ary", graph, potential, q));
+        sections.push_back(astarSection<RadixHeap<NearestRecord, BenchmarkStats>>("A* Radix Heap", "astar", "radix", graph, potential, q));
+    }
+    return sections;
 }
 
+// Keep the sections that match both filters; a key that matches nothing is most likely a typo
+void selectSections(vector<Section> &sections, const vector<string> &algorithms, const vector<string> &heaps)
+{
+    auto selected = [](const vector<string> &keys, const string &key)
+    { return keys.empty() || find(keys.begin(), keys.end(), key) != keys.end(); };
+    for (const auto &[keys, field] : {pair{&algorithms, &Section::algorithm}, pair{&heaps, &Section::heap}})
+    {
+        for (const string &key : *keys)
+        {
+            if (none_of(sections.begin(), sections.end(), [&](const Section &section)
+                        { return section.*field == key; }))
+            {
+                throw invalid_argument("No section matches " + key + "; see --list");
+            }
+        }
+    }
+    erase_if(sections, [&](const Section &section)
+             { return !selected(algorithms, section.algorithm) || !selected(heaps, section.heap); });
+}
 
-vector<pair<int, int>> readQueriesFromFile(const string &filename)
+// Print the key of every section instead of running it
+void listSections(const vector<Section> &sections)
 {
-    vector<pair<int, int>> queries;
-    ifstream file(filename);
-    if (!file.is_open())
+    for (const Section &section : sections)
     {
-        cerr << "Error opening file" << endl;
-        exit(1);
+        cout << section.algorithm << '\t' << section.heap << '\t' << section.name << '\n';
     }
+}
 
-    int start, end;
-    while (file >> start >> end)
+// Build the caliber and reverse arrays only if a selected section searches with them
+void prepareGraph(Graph &graph, const vector<Section> &sections)
+{
+    auto selected = [&](const string &algorithm)
+    { return any_of(sections.begin(), sections.end(), [&](const Section &section)
+                    { return section.algorithm == algorithm; }); };
+    if (selected("caliber"))
     {
-        queries.emplace_back(start - 1, end - 1);
+        graph.computeCalibers();
     }
+    if (selected("bidirectional"))
+    {
+        graph.computeReverse();
+    }
+}
 
-    file.close();
-    return queries;
+// Run every section and add its results, labelled with the graph it ran on, to the report
+void runSections(const vector<Section> &sections, const BenchmarkOptions &options, const Graph &graph, const string &suffix,
+                 BenchmarkReport &report)
+{
+    for (const Section &section : sections)
+    {
+        BenchmarkResult result = section.run(options);
+        result.name = section.name + suffix;
+        result.algorithm = section.algorithm;
+        result.heap = section.heap;
+        result.vertices = graph.vertexCount();
+        result.arcs = graph.arcCount();
+        report.add(result);
+    }
 }
 
-template <class T>
-void runDijkstra(vector<vector<Edge>> &graph, const vector<pair<int, int>> &queries)
+// Run the selected sections on a query batch and report them; args are the command-line arguments after the program name
+int runQueryBenchmark(const string &program, const vector<string> &args)
 {
-    int64_t total_time = 0;
-    for (const auto &query : queries)
+    BenchmarkArguments arguments = parseBenchmarkArguments(args);
+    if (arguments.help)
     {
-        int start = query.first;
-        int end = query.second;
-        auto start_time = high_resolution_clock::now();
-        int shortest_distance = dijkstra<T>(start, end, graph);
-        auto end_time = high_resolution_clock::now();
-        auto duration = duration_cast<microseconds>(end_time - start_time).count();
-        total_time += duration;
+        printUsage(program, cout);
+        return 0;
+    }
+    const vector<string> &positional = arguments.positional;
+    if (positional.size() < 2)
+    {
+        printUsage(program);
+        return 1;
+    }
+    configureRun(arguments, 2);
+    auto optionalFile = [&](size_t index)
+    { return positional.size() > index && positional[index] != "-" ? positional[index] : string(); };
+    string coordinates_filename = optionalFile(3);
+    string landmarks_filename = optionalFile(4);
+    string hierarchy_filename = optionalFile(5);
+    string labels_filename = optionalFile(6);
 
-        cout << "Shortest distance from vertex " << start + 1 << " to vertex " << end + 1 << ": ";
-        if (shortest_distance == INF)
+    auto graph = loadGraph(positional[0]);
+    auto queries = readQueriesFromFile(positional[1]);
+    for (const auto &[start, end] : queries)
+    {
+        if (start < 0 || start >= graph.vertexCount() || end < 0 || end >= graph.vertexCount())
         {
-            cout << "INF" << endl;
+            cerr << "Query " << start + 1 << " " << end + 1 << " refers to a vertex outside the graph\n";
+            return 1;
         }
-        else
+    }
+
+    // Goal-directed search needs the vertex positions of the matching .co file
+    vector<Coordinate> coordinates;
+    if (!coordinates_filename.empty())
+    {
+        coordinates = readCoordinatesFromFile(coordinates_filename);
+    }
+
+    // Searches run on the renumbered graph; queries and results keep the IDs of the input files
+    VertexPermutation order;
+    VertexOrder method = parseVertexOrder(arguments.order_method);
+    if (method != VertexOrder::Original)
+    {
+        auto start_time = steady_clock::now();
+        order = computeVertexOrder(graph, method, coordinates.empty() ? nullptr : &coordinates);
+        graph = permuteGraph(graph, order);
+        coordinates = permuteCoordinates(coordinates, order);
+        auto elapsed = duration_cast<milliseconds>(steady_clock::now() - start_time).count();
+        cerr << "Renumbered the vertices (" << arguments.order_method << ") in " << elapsed << " ms\n";
+    }
+    vector<pair<int, int>> internal_queries;
+    internal_queries.reserve(queries.size());
+    for (const auto &[start, end] : queries)
+    {
+        internal_queries.emplace_back(order.toInternal(start), order.toInternal(end));
+    }
+
+    vector<Section> sections = graphSections(graph, coordinates, internal_queries);
+
+    // ALT needs a landmark table built with the landmarks subcommand
+    if (!landmarks_filename.empty())
+    {
+        const auto &q = internal_queries;
+        auto potential = make_shared<const LandmarkPotential>(permuteLandmarkTable(loadLandmarkTable(landmarks_filename, graph), order));
+        sections.push_back(astarSection<BinaryHeap<NearestRecord, BenchmarkStats>>("ALT Binary Heap", "alt", "binary", graph, potential, q));
+        sections.push_back(astarSection<DaryHeap<NearestRecord, 4, BenchmarkStats>>("ALT 4-ary Heap", "alt", "4-ary", graph, potential, q));
+        sections.push_back(astarSection<RadixHeap<NearestRecord, BenchmarkStats>>("ALT Radix Heap", "alt", "radix", graph, potential, q));
+    }
+
+    // Contraction hierarchy queries need a hierarchy built with the contract subcommand
+    if (!hierarchy_filename.empty())
+    {
+        auto hierarchy = make_shared<const ContractionHierarchy>(loadContractionHierarchy(hierarchy_filename));
+        if (hierarchy->vertexCount() != graph.vertexCount())
         {
-            cout << shortest_distance << endl;
+            throw runtime_error(hierarchy_filename + ": hierarchy does not belong to this graph");
         }
+        sections.push_back(contractionHierarchySection<BinaryHeap<NearestRecord, BenchmarkStats>>("CH Binary Heap", "binary", hierarchy, queries));
+        sections.push_back(contractionHierarchySection<DaryHeap<NearestRecord, 4, BenchmarkStats>>("CH 4-ary Heap", "4-ary", hierarchy, queries));
+        sections.push_back(contractionHierarchySection<PairingHeap<NearestRecord, TwoPass, DefaultNodePool, BenchmarkStats>>("CH Pairing Heap", "pairing", hierarchy, queries));
+        sections.push_back(contractionHierarchySection<RadixHeap<NearestRecord, BenchmarkStats>>("CH Radix Heap", "radix", hierarchy, queries));
+    }
+
+    // Hub labels are computed from a hierarchy with the labels subcommand
+    if (!labels_filename.empty())
+    {
+        auto labels = make_shared<const HubLabels>(loadHubLabels(labels_filename));
+        if (labels->vertexCount() != graph.vertexCount())
+        {
+            throw runtime_error(labels_filename + ": labels do not belong to this graph");
+        }
+        sections.push_back(hubLabelSection(labels, queries));
+    }
+
+    selectSections(sections, arguments.algorithms, arguments.heaps);
+    if (arguments.list)
+    {
+        listSections(sections);
+        return 0;
+    }
+    prepareGraph(graph, sections);
+
+    BenchmarkReport report(cout, arguments.format, queries, arguments.options);
+    runSections(sections, arguments.options, graph, "", report);
+    report.finish();
+    return 0;
+}
+
+// Read the optional degree, weight range and seed of a generated graph, starting at positional[first]
+GeneratorOptions generatorOptions(const string &family, const vector<string> &positional, size_t first)
+{
+    GeneratorOptions options;
+    options.family = parseGraphFamily(family);
+    if (positional.size() > first && positional[first] != "-")
+    {
+        options.degree = stod(positional[first]);
+    }
+    if (positional.size() > first + 2)
+    {
+        options.minWeight = stoi(positional[first + 1]);
+        options.maxWeight = stoi(positional[first + 2]);
     }
-    cout << "Total time: " << total_time << " microseconds" << endl;
+    if (positional.size() > first + 3)
+    {
+        options.seed = static_cast<unsigned>(stoul(positional[first + 3]));
+    }
+    return options;
 }
 
-int main(int argc, char *argv[])
+// The number of random queries that generate writes and that sweep runs unless told otherwise
+constexpr int GENERATED_QUERIES = 1000;
+
+// Generate a graph and write it as DIMACS files, with its coordinates and random queries where file names are given;
+// args are the arguments after "generate"
+int generateGraphFiles(const vector<string> &args)
+{
+    GeneratorOptions options = generatorOptions(args[0], args, 5);
+    options.vertices = stoi(args[1]);
+    auto optionalFile = [&](size_t index)
+    { return args.size() > index && args[index] != "-" ? args[index] : string(); };
+    string coordinates_filename = optionalFile(3);
+    string queries_filename = optionalFile(4);
+    if (!coordinates_filename.empty() && options.family == GraphFamily::PowerLaw)
+    {
+        throw invalid_argument("power-law graphs have no coordinates");
+    }
+
+    auto start_time = steady_clock::now();
+    GeneratedGraph generated = generateGraph(options);
+    auto elapsed = duration_cast<milliseconds>(steady_clock::now() - start_time).count();
+    writeGraphToFile(generated.graph, args[2]);
+    cout << "Generated " << generated.graph.vertexCount() << " vertices and " << generated.graph.arcCount() << " arcs in "
+         << elapsed << " ms; wrote them to " << args[2] << endl;
+    if (!coordinates_filename.empty())
+    {
+        writeCoordinatesToFile(generated.coordinates, coordinates_filename);
+        cout << "Wrote the coordinates to " << coordinates_filename << endl;
+    }
+    if (!queries_filename.empty())
+    {
+        writeQueriesToFile(randomQueries(generated.graph.vertexCount(), GENERATED_QUERIES, options.seed), queries_filename);
+        cout << "Wrote " << GENERATED_QUERIES << " random queries to " << queries_filename << endl;
+    }
+    return 0;
+}
+
+// Generate graphs of growing size and run the selected sections on random queries in each;
+// args are the arguments after "sweep"
+int runSweep(const string &program, const vector<string> &args)
 {
-    if (argc < 3)
+    BenchmarkArguments arguments = parseBenchmarkArguments(args);
+    if (arguments.help)
     {
-        cerr << "Usage: " << argv[0] << " <graph_filename> <queries_filename>" << endl;
+        printUsage(program, cout);
+        return 0;
+    }
+    const vector<string> &positional = arguments.positional;
+    if (positional.size() < 2)
+    {
+        printUsage(program);
         return 1;
     }
+    configureRun(arguments, 3);
+    GeneratorOptions generator = generatorOptions(positional[0], positional, 4);
+    vector<string> sizes = splitList(positional[1]);
+    int query_count = positional.size() > 2 ? stoi(positional[2]) : GENERATED_QUERIES;
+    VertexOrder method = parseVertexOrder(arguments.order_method);
 
-    string graph_filename = argv[1];
-    string queries_filename = argv[2];
+    // The report starts with the queries of the first size and switches with every graph
+    vector<pair<int, int>> queries;
+    BenchmarkReport report(cout, arguments.format, queries, arguments.options);
+    for (const string &size : sizes)
+    {
+        generator.vertices = stoi(size);
+        GeneratedGraph generated = generateGraph(generator);
+        Graph &graph = generated.graph;
+        if (method != VertexOrder::Original)
+        {
+            VertexPermutation order = computeVertexOrder(graph, method, generated.coordinates.empty() ? nullptr : &generated.coordinates);
+            graph = permuteGraph(graph, order);
+            generated.coordinates = permuteCoordinates(generated.coordinates, order);
+        }
+        queries = randomQueries(graph.vertexCount(), query_count, generator.seed);
+        report.setQueries(queries);
 
-    auto graph = readGraphFromFile(graph_filename);
-    auto queries = readQueriesFromFile(queries_filename);
+        vector<Section> sections = graphSections(graph, generated.coordinates, queries);
+        selectSections(sections, arguments.algorithms, arguments.heaps);
+        if (arguments.list)
+        {
+            listSections(sections);
+            return 0;
+        }
+        prepareGraph(graph, sections);
+        runSections(sections, arguments.options, graph, " (" + positional[0] + ", " + size + " vertices)", report);
+    }
+    report.finish();
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        if (argc >= 2 && string(argv[1]) == "convert")
+        {
+            if (argc < 4)
+            {
+                cerr << "Usage: " << argv[0] << " convert <graph_filename> <cache_filename>" << endl;
+                return 1;
+            }
+            return convertGraph(argv[2], argv[3]);
+        }
+        if (argc >= 2 && string(argv[1]) == "landmarks")
+        {
+            if (argc < 4)
+            {
+                cerr << "Usage: " << argv[0] << " landmarks <graph_filename> <table_filename> [count [farthest|avoid|planar [coordinates_filename]]]" << endl;
+                return 1;
+            }
+            return buildLandmarks(argv[2], argv[3], argc >= 5 ? stoi(argv[4]) : 16, argc >= 6 ? argv[5] : "avoid",
+                                  argc >= 7 ? argv[6] : "");
+        }
+        if (argc >= 2 && string(argv[1]) == "contract")
+        {
+            if (argc < 4)
+            {
+                cerr << "Usage: " << argv[0] << " contract <graph_filename> <hierarchy_filename> [threads]" << endl;
+                return 1;
+            }
+            return buildHierarchy(argv[2], argv[3], argc >= 5 ? stoi(argv[4]) : defaultThreadCount());
+        }
+        if (argc >= 2 && string(argv[1]) == "table")
+        {
+            if (argc < 5)
+            {
+                cerr << "Usage: " << argv[0] << " table <graph_filename> <sources_filename> <targets_filename> [threads [hierarchy_filename]]" << endl;
+                return 1;
+            }
+            return computeTable(argv[2], argv[3], argv[4], argc >= 6 ? stoi(argv[5]) : defaultThreadCount(), argc >= 7 ? argv[6] : "");
+        }
+        if (argc >= 2 && string(argv[1]) == "labels")
+        {
+            if (argc < 4)
+            {
+                cerr << "Usage: " << argv[0] << " labels <hierarchy_filename> <labels_filename> [threads]" << endl;
+                return 1;
+            }
+            return buildLabels(argv[2], argv[3], argc >= 5 ? stoi(argv[4]) : defaultThreadCount());
+        }
+        if (argc >= 2 && string(argv[1]) == "trace")
+        {
+            if (argc < 5)
+            {
+                cerr << "Usage: " << argv[0] << " trace <graph_filename> <queries_filename> <trace_filename>" << endl;
+                return 1;
+            }
+            return recordTrace(argv[2], argv[3], argv[4]);
+        }
+        if (argc >= 2 && string(argv[1]) == "generate")
+        {
+            if (argc < 5)
+            {
+                cerr << "Usage: " << argv[0] << " generate <family> <vertices> <graph_filename> [coordinates_filename|- [queries_filename|- [degree|- [min_weight max_weight [seed]]]]]" << endl;
+                return 1;
+            }
+            return generateGraphFiles(vector<string>(argv + 2, argv + argc));
+        }
+        if (argc >= 2 && string(argv[1]) == "sweep")
+        {
+            return runSweep(argv[0], vector<string>(argv + 2, argv + argc));
+        }
 
-    cout << "Fibonacci Heap:" << endl;
-    runDijkstra<FiboHeap<NearestRecord>>(graph, queries);
-    cout << "Binary Heap:" << endl;
-    runDijkstra<BinaryHeap<NearestRecord>>(graph, queries);
-    cout << "Skew Heap:" << endl;
-    runDijkstra<SkewHeap<NearestRecord>>(graph, queries);
+        return runQueryBenchmark(argv[0], vector<string>(argv + 1, argv + argc));
+    }
+    catch (const exception &e)
+    {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
     return 0;
-}
\ No newline at end of file
+}
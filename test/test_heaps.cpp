@@ -0,0 +1,241 @@
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <iterator>
+#include <random>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "binaryheap.hpp"
+#include "daryheap.hpp"
+#include "fiboheap.hpp"
+#include "generators.hpp"
+#include "heaptrace.hpp"
+#include "indexedbinaryheap.hpp"
+#include "multilevelbuckets.hpp"
+#include "pairingheap.hpp"
+#include "radixheap.hpp"
+#include "rankpairingheap.hpp"
+#include "referenceheap.hpp"
+#include "skewheap.hpp"
+
+// Every heap checked here is compared against this one, which pops the smallest distance first
+using Reference = ReferenceHeap<NearestRecord, std::greater<NearestRecord>>;
+
+// Heaps that only accept keys at least as large as the last popped one
+template <typename PriorityQueue>
+struct MonotoneOnly : std::false_type
+{
+};
+
+template <typename T, typename Stats>
+struct MonotoneOnly<RadixHeap<T, Stats>> : std::true_type
+{
+};
+
+template <typename T, typename Stats>
+struct MonotoneOnly<BucketQueue<T, Stats>> : std::true_type
+{
+};
+
+template <typename T, int BITS, typename Stats>
+struct MonotoneOnly<MultiLevelBuckets<T, BITS, Stats>> : std::true_type
+{
+};
+
+// Run the operations on the heap and on the reference side by side, checking every pop
+template <typename PriorityQueue>
+void expectSameAsReference(const std::vector<HeapOperation> &operations, PriorityQueue &pq)
+{
+    Reference reference;
+    size_t index = 0;
+    for (const HeapOperation &operation : operations)
+    {
+        switch (operation.kind)
+        {
+        case HeapOperationKind::Push:
+            pq.push({operation.key, operation.vertex});
+            reference.push({operation.key, operation.vertex});
+            break;
+        case HeapOperationKind::Pop:
+            ASSERT_EQ(pq.pop().dist, reference.pop().dist) << "at operation " << index;
+            break;
+        case HeapOperationKind::Clear:
+            pq.clear();
+            reference.clear();
+            break;
+        }
+        ASSERT_EQ(pq.empty(), reference.empty()) << "at operation " << index;
+        index++;
+    }
+}
+
+template <typename PriorityQueue>
+class HeapTest : public ::testing::Test
+{
+};
+
+using Heaps = ::testing::Types<
+    BinaryHeap<NearestRecord>,
+    DaryHeap<NearestRecord, 4>,
+    DaryHeap<NearestRecord, 8>,
+    DaryHeap<NearestRecord, 16>,
+    IndexedBinaryHeap<NearestRecord>,
+    FiboHeap<NearestRecord>,
+    FiboHeap<NearestRecord, NewDeletePool>,
+    SkewHeap<NearestRecord>,
+    SkewHeap<NearestRecord, NewDeletePool>,
+    PairingHeap<NearestRecord, TwoPass>,
+    PairingHeap<NearestRecord, MultiPass>,
+    RankPairingHeap<NearestRecord>,
+    RadixHeap<NearestRecord>,
+    BucketQueue<NearestRecord>,
+    MultiLevelBuckets<NearestRecord>,
+    MultiLevelBuckets<NearestRecord, 6>>;
+
+TYPED_TEST_SUITE(HeapTest, Heaps);
+
+TYPED_TEST(HeapTest, MatchesReferenceOnMonotoneKeys)
+{
+    TypeParam pq;
+    expectSameAsReference(syntheticHeapTrace(HeapPattern::Monotone, 20000, 1).operations(), pq);
+}
+
+TYPED_TEST(HeapTest, MatchesReferenceOnDuplicateKeys)
+{
+    TypeParam pq;
+    expectSameAsReference(syntheticHeapTrace(HeapPattern::Duplicates, 20000, 2).operations(), pq);
+}
+
+TYPED_TEST(HeapTest, MatchesReferenceOnRandomKeys)
+{
+    if constexpr (MonotoneOnly<TypeParam>::value)
+    {
+        GTEST_SKIP() << "monotone heap";
+    }
+    else
+    {
+        TypeParam pq;
+        expectSameAsReference(syntheticHeapTrace(HeapPattern::Random, 20000, 3).operations(), pq);
+    }
+}
+
+// A cleared heap must accept keys below the ones popped before the clear, as the next query pushes them
+TYPED_TEST(HeapTest, ClearStartsOver)
+{
+    TypeParam pq;
+    HeapTrace trace;
+    for (int query = 0; query < 3; query++)
+    {
+        trace.clear();
+        for (int i = 0; i < 100; i++)
+        {
+            trace.push(1000 + 7 * i % 101, i);
+        }
+        for (int i = 0; i < 60; i++)
+        {
+            trace.pop();
+        }
+        trace.push(1500, 100);
+        trace.pop();
+    }
+    trace.clear();
+    trace.push(5, 0);
+    trace.pop();
+    expectSameAsReference(trace.operations(), pq);
+    EXPECT_TRUE(pq.empty());
+}
+
+// The operations of real searches, recorded once on a generated road-like graph
+const std::vector<HeapOperation> &recordedSearches()
+{
+    static const std::vector<HeapOperation> operations = []
+    {
+        GeneratorOptions options;
+        options.family = GraphFamily::Delaunay;
+        options.vertices = 5000;
+        GeneratedGraph generated = generateGraph(options);
+        QueryWorkspace<RecordingHeap<>> workspace(generated.graph.vertexCount());
+        for (const auto &[start, end] : randomQueries(generated.graph.vertexCount(), 20, 1))
+        {
+            dijkstra<RecordingHeap<>>(start, end, generated.graph, workspace);
+        }
+        return workspace.queue().trace().operations();
+    }();
+    return operations;
+}
+
+TYPED_TEST(HeapTest, MatchesReferenceOnRecordedSearches)
+{
+    TypeParam pq;
+    expectSameAsReference(recordedSearches(), pq);
+}
+
+TYPED_TEST(HeapTest, ReplayChecksumMatchesReference)
+{
+    TypeParam pq;
+    Reference reference;
+    EXPECT_EQ(replayHeapTrace(recordedSearches(), pq), replayHeapTrace(recordedSearches(), reference));
+}
+
+template <typename PriorityQueue>
+class AddressableHeapTest : public ::testing::Test
+{
+};
+
+using AddressableHeaps = ::testing::Types<
+    IndexedBinaryHeap<NearestRecord>,
+    FiboHeap<NearestRecord>,
+    FiboHeap<NearestRecord, NewDeletePool>,
+    SkewHeap<NearestRecord>,
+    PairingHeap<NearestRecord, TwoPass>,
+    PairingHeap<NearestRecord, MultiPass>,
+    RankPairingHeap<NearestRecord>>;
+
+TYPED_TEST_SUITE(AddressableHeapTest, AddressableHeaps);
+
+// Mix inserts, decrease_key calls and pops; the reference mirrors a decrease_key as erase and push
+TYPED_TEST(AddressableHeapTest, MatchesReferenceWithDecreaseKey)
+{
+    using Handle = typename TypeParam::handle_type;
+    TypeParam pq;
+    Reference reference;
+    std::unordered_map<int, std::pair<Handle, int>> queued; // vertex -> handle and distance
+    std::mt19937 random(4);
+    std::uniform_int_distribution<int> action(0, 9);
+    std::uniform_int_distribution<int> key(0, 1'000'000);
+    int next = 0;
+
+    for (int step = 0; step < 30000; step++)
+    {
+        int choice = action(random);
+        if (choice < 4 || queued.empty())
+        {
+            int dist = key(random);
+            queued[next] = {pq.insert({dist, next}), dist};
+            reference.push({dist, next});
+            next++;
+        }
+        else if (choice < 7)
+        {
+            auto entry = queued.begin();
+            std::advance(entry, std::uniform_int_distribution<size_t>(0, queued.size() - 1)(random));
+            auto &[handle, dist] = entry->second;
+            int lower = std::uniform_int_distribution<int>(0, dist)(random);
+            pq.decrease_key(handle, {lower, entry->first});
+            ASSERT_TRUE(reference.erase({dist, entry->first}));
+            reference.push({lower, entry->first});
+            dist = lower;
+        }
+        else
+        {
+            NearestRecord popped = pq.pop();
+            ASSERT_EQ(popped.dist, reference.pop().dist) << "at step " << step;
+            ASSERT_EQ(queued.at(popped.vertex).second, popped.dist);
+            queued.erase(popped.vertex);
+        }
+        ASSERT_EQ(pq.empty(), reference.empty());
+    }
+}
@@ -0,0 +1,183 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "generators.hpp"
+#include "heaptrace.hpp"
+#include "referenceheap.hpp"
+
+// Compare decoded operations field by field
+void expectSameOperations(const std::vector<HeapOperation> &actual, const std::vector<HeapOperation> &expected)
+{
+    ASSERT_EQ(actual.size(), expected.size());
+    for (size_t i = 0; i < actual.size(); i++)
+    {
+        EXPECT_EQ(actual[i].kind, expected[i].kind) << "at operation " << i;
+        EXPECT_EQ(actual[i].key, expected[i].key) << "at operation " << i;
+        EXPECT_EQ(actual[i].vertex, expected[i].vertex) << "at operation " << i;
+    }
+}
+
+// A trace that exercises rising, falling, repeated and extreme keys
+HeapTrace sampleTrace(std::vector<HeapOperation> &expected)
+{
+    HeapTrace trace;
+    auto push = [&](int key, int vertex)
+    {
+        trace.push(key, vertex);
+        expected.push_back({HeapOperationKind::Push, key, vertex});
+    };
+    auto pop = [&]
+    {
+        trace.pop();
+        expected.push_back({HeapOperationKind::Pop, 0, 0});
+    };
+    auto clear = [&]
+    {
+        trace.clear();
+        expected.push_back({HeapOperationKind::Clear, 0, 0});
+    };
+
+    clear();
+    push(0, 7);
+    push(0, 8);
+    push(900, 23'947'346);
+    pop();
+    push(INF, 1);
+    push(3, 2);
+    pop();
+    pop();
+    clear();
+    push(1'000'000, 0);
+    push(999'999, 1);
+    pop();
+    return trace;
+}
+
+TEST(HeapTraceTest, DecodesWhatWasEncoded)
+{
+    std::vector<HeapOperation> expected;
+    HeapTrace trace = sampleTrace(expected);
+    expectSameOperations(trace.operations(), expected);
+    EXPECT_EQ(trace.operationCount(), expected.size());
+    EXPECT_EQ(trace.pushCount(), 7u);
+    EXPECT_EQ(trace.clearCount(), 2u);
+}
+
+TEST(HeapTraceTest, FileRoundTrip)
+{
+    std::vector<HeapOperation> expected;
+    HeapTrace trace = sampleTrace(expected);
+    std::string filename = ::testing::TempDir() + "round_trip.trace";
+    writeHeapTrace(trace, filename);
+
+    HeapTrace loaded = loadHeapTrace(filename);
+    EXPECT_EQ(loaded.bytes(), trace.bytes());
+    EXPECT_EQ(loaded.pushCount(), trace.pushCount());
+    EXPECT_EQ(loaded.clearCount(), trace.clearCount());
+    expectSameOperations(loaded.operations(), expected);
+
+    // Appending to a loaded trace continues its key deltas
+    loaded.push(1'000'005, 3);
+    trace.push(1'000'005, 3);
+    expectSameOperations(loaded.operations(), trace.operations());
+}
+
+TEST(HeapTraceTest, RejectsDamagedFiles)
+{
+    std::vector<HeapOperation> expected;
+    HeapTrace trace = sampleTrace(expected);
+    std::string filename = ::testing::TempDir() + "damaged.trace";
+    writeHeapTrace(trace, filename);
+    std::ifstream in(filename, std::ios::binary);
+    std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    auto rewrite = [&](const std::string &data)
+    {
+        std::ofstream(filename, std::ios::binary | std::ios::trunc) << data;
+    };
+    rewrite(contents.substr(0, contents.size() - 1));
+    EXPECT_THROW(loadHeapTrace(filename), std::runtime_error);
+    rewrite("X" + contents.substr(1));
+    EXPECT_THROW(loadHeapTrace(filename), std::runtime_error);
+    rewrite(contents + '\x01');
+    EXPECT_THROW(loadHeapTrace(filename), std::runtime_error);
+    // A header that claims more bytes than the file holds is rejected before anything is allocated
+    std::string huge = contents;
+    uint64_t claimed = uint64_t{1} << 60;
+    std::memcpy(huge.data() + offsetof(HeapTraceHeader, bytes), &claimed, sizeof(claimed));
+    rewrite(huge);
+    EXPECT_THROW(loadHeapTrace(filename), std::runtime_error);
+    EXPECT_THROW(loadHeapTrace(::testing::TempDir() + "missing.trace"), std::runtime_error);
+}
+
+TEST(HeapTraceTest, RejectsMismatchedCounts)
+{
+    std::vector<HeapOperation> expected;
+    HeapTrace trace = sampleTrace(expected);
+    EXPECT_THROW(HeapTrace(trace.bytes(), trace.operationCount() + 1, trace.pushCount(), trace.clearCount()), std::runtime_error);
+    std::vector<uint8_t> truncated(trace.bytes().begin(), trace.bytes().end() - 2);
+    EXPECT_THROW(HeapTrace(truncated, trace.operationCount(), trace.pushCount(), trace.clearCount()), std::runtime_error);
+}
+
+TEST(HeapTraceTest, RecordsOneClearPerQuery)
+{
+    GeneratorOptions options;
+    options.vertices = 400;
+    GeneratedGraph generated = generateGraph(options);
+    auto queries = randomQueries(generated.graph.vertexCount(), 10, 2);
+    QueryWorkspace<RecordingHeap<>> workspace(generated.graph.vertexCount());
+    QueryWorkspace<BinaryHeap<NearestRecord>> plain(generated.graph.vertexCount());
+    for (const auto &[start, end] : queries)
+    {
+        EXPECT_EQ(dijkstra<RecordingHeap<>>(start, end, generated.graph, workspace),
+                  dijkstra<BinaryHeap<NearestRecord>>(start, end, generated.graph, plain));
+    }
+
+    const HeapTrace &trace = workspace.queue().trace();
+    EXPECT_EQ(trace.clearCount(), queries.size());
+    EXPECT_GE(trace.pushCount(), queries.size());
+    std::vector<HeapOperation> operations = trace.operations();
+    ASSERT_FALSE(operations.empty());
+    EXPECT_EQ(operations.front().kind, HeapOperationKind::Clear);
+}
+
+// Monotone patterns never push below the last popped key; the random one does
+TEST(HeapTraceTest, SyntheticPatternsHaveTheirKeyOrder)
+{
+    for (HeapPattern pattern : {HeapPattern::Monotone, HeapPattern::Duplicates, HeapPattern::Random})
+    {
+        ReferenceHeap<NearestRecord, std::greater<NearestRecord>> reference;
+        int lastPopped = 0;
+        bool belowLastPopped = false;
+        size_t pops = 0;
+        size_t pushes = 0;
+        for (const HeapOperation &operation : syntheticHeapTrace(pattern, 5000, 1).operations())
+        {
+            if (operation.kind == HeapOperationKind::Push)
+            {
+                belowLastPopped |= operation.key < lastPopped;
+                reference.push({operation.key, operation.vertex});
+                pushes++;
+            }
+            else if (operation.kind == HeapOperationKind::Pop)
+            {
+                lastPopped = reference.pop().dist;
+                pops++;
+            }
+        }
+        EXPECT_EQ(belowLastPopped, pattern == HeapPattern::Random);
+        EXPECT_EQ(pops, pushes);
+        EXPECT_TRUE(reference.empty());
+    }
+    EXPECT_EQ(parseHeapPattern("duplicates"), HeapPattern::Duplicates);
+    EXPECT_THROW(parseHeapPattern("sorted"), std::invalid_argument);
+}
@@ -0,0 +1,227 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "alt.hpp"
+#include "astar.hpp"
+#include "binaryheap.hpp"
+#include "contractionhierarchy.hpp"
+#include "distancetable.hpp"
+#include "generators.hpp"
+#include "hublabels.hpp"
+#include "pathfinder.hpp"
+#include "reorder.hpp"
+
+// Every speed-up technique must return the distances of plain Dijkstra, on each generated family
+class SearchTest : public ::testing::TestWithParam<std::string>
+{
+protected:
+    static GeneratedGraph generate(const std::string &family)
+    {
+        GeneratorOptions options;
+        options.family = parseGraphFamily(family);
+        options.vertices = 2000;
+        GeneratedGraph generated = generateGraph(options);
+        generated.graph.computeReverse();
+        return generated;
+    }
+
+    SearchTest() : generated(generate(GetParam())), queries(randomQueries(generated.graph.vertexCount(), 200, 5)), expected()
+    {
+        QueryWorkspace<BinaryHeap<NearestRecord>> workspace(generated.graph.vertexCount());
+        for (const auto &[start, end] : queries)
+        {
+            expected.push_back(dijkstra<BinaryHeap<NearestRecord>>(start, end, generated.graph, workspace));
+        }
+    }
+
+    GeneratedGraph generated;
+    std::vector<std::pair<int, int>> queries;
+    std::vector<int> expected; ///< The distance of every query according to dijkstra
+};
+
+TEST_P(SearchTest, BidirectionalMatchesDijkstra)
+{
+    BidirectionalWorkspace<BinaryHeap<NearestRecord>> workspace(generated.graph.vertexCount());
+    for (size_t i = 0; i < queries.size(); i++)
+    {
+        const auto &[start, end] = queries[i];
+        EXPECT_EQ(bidirectional_dijkstra(start, end, generated.graph, workspace), expected[i]) << start << " -> " << end;
+    }
+}
+
+// The straight-line bound is scaled and rounded from floating point, so it is the easiest to make inadmissible
+TEST_P(SearchTest, GeometricAstarMatchesDijkstra)
+{
+    if (generated.coordinates.empty())
+    {
+        GTEST_SKIP() << "power-law graphs have no positions";
+    }
+    GeometricPotential potential(generated.graph, generated.coordinates);
+    QueryWorkspace<BinaryHeap<NearestRecord>> workspace(generated.graph.vertexCount());
+    for (size_t i = 0; i < queries.size(); i++)
+    {
+        const auto &[start, end] = queries[i];
+        EXPECT_EQ(astar<BinaryHeap<NearestRecord>>(start, end, generated.graph, potential, workspace), expected[i])
+            << start << " -> " << end;
+    }
+}
+
+TEST_P(SearchTest, AltMatchesDijkstra)
+{
+    for (LandmarkSelection method : {LandmarkSelection::Farthest, LandmarkSelection::Avoid})
+    {
+        LandmarkPotential potential(selectLandmarkTable(generated.graph, 8, method));
+        QueryWorkspace<BinaryHeap<NearestRecord>> workspace(generated.graph.vertexCount());
+        for (size_t i = 0; i < queries.size(); i++)
+        {
+            const auto &[start, end] = queries[i];
+            EXPECT_EQ(astar<BinaryHeap<NearestRecord>>(start, end, generated.graph, potential, workspace), expected[i])
+                << start << " -> " << end;
+        }
+    }
+}
+
+// The avoid table is filled during selection; it must equal the table built afterwards from the same landmarks
+TEST_P(SearchTest, AvoidTableMatchesBuiltTable)
+{
+    LandmarkTable selected = selectLandmarkTable(generated.graph, 8, LandmarkSelection::Avoid);
+    std::vector<int> landmarks = selectLandmarks(generated.graph, 8, LandmarkSelection::Avoid);
+    ASSERT_TRUE(std::ranges::equal(selected.landmarkArray(), landmarks));
+    LandmarkTable built = buildLandmarkTable(generated.graph, landmarks);
+    size_t k = landmarks.size();
+    for (int v = 0; v < generated.graph.vertexCount(); v++)
+    {
+        ASSERT_TRUE(std::equal(selected.fromRow(v), selected.fromRow(v) + k, built.fromRow(v))) << "vertex " << v;
+        ASSERT_TRUE(std::equal(selected.toRow(v), selected.toRow(v) + k, built.toRow(v))) << "vertex " << v;
+    }
+}
+
+TEST_P(SearchTest, ContractionHierarchyAndHubLabelsMatchDijkstra)
+{
+    ContractionHierarchy hierarchy = buildContractionHierarchy(generated.graph, 2);
+    HubLabels labels = buildHubLabels(hierarchy, 2);
+    BidirectionalWorkspace<BinaryHeap<NearestRecord>> workspace(hierarchy.vertexCount());
+    for (size_t i = 0; i < queries.size(); i++)
+    {
+        const auto &[start, end] = queries[i];
+        EXPECT_EQ(ch_query(start, end, hierarchy, workspace), expected[i]) << start << " -> " << end;
+        EXPECT_EQ(hub_label_query(start, end, labels), expected[i]) << start << " -> " << end;
+    }
+}
+
+// The generated graph plus one isolated vertex, so that every table has unreachable pairs
+Graph withIsolatedVertex(const Graph &graph)
+{
+    std::vector<Arc> arcs;
+    for (int u = 0; u < graph.vertexCount(); u++)
+    {
+        for (int e = graph.beginArc(u); e < graph.endArc(u); e++)
+        {
+            arcs.push_back({u, graph.target(e), graph.weight(e)});
+        }
+    }
+    return Graph(graph.vertexCount() + 1, arcs);
+}
+
+TEST_P(SearchTest, DistanceTablesMatchDijkstra)
+{
+    Graph graph = withIsolatedVertex(generated.graph);
+    int isolated = graph.vertexCount() - 1;
+    std::vector<int> sources, targets;
+    for (size_t i = 0; i < 6; i++)
+    {
+        sources.push_back(queries[i].first);
+        targets.push_back(queries[i + 6].second);
+    }
+    // Repeated rows and columns, and the isolated vertex on both sides
+    sources.push_back(sources.front());
+    sources.push_back(isolated);
+    targets.push_back(targets.back());
+    targets.push_back(isolated);
+    targets.push_back(sources.front());
+
+    ContractionHierarchy hierarchy = buildContractionHierarchy(graph, 2);
+    std::vector<int> plain = distance_table<BinaryHeap<NearestRecord>>(sources, targets, graph, 2);
+    std::vector<int> buckets = ch_distance_table<BinaryHeap<NearestRecord>>(sources, targets, hierarchy, 2);
+    ASSERT_EQ(plain.size(), sources.size() * targets.size());
+    ASSERT_EQ(buckets.size(), sources.size() * targets.size());
+
+    QueryWorkspace<BinaryHeap<NearestRecord>> workspace(graph.vertexCount());
+    for (size_t i = 0; i < sources.size(); i++)
+    {
+        for (size_t j = 0; j < targets.size(); j++)
+        {
+            int distance = dijkstra<BinaryHeap<NearestRecord>>(sources[i], targets[j], graph, workspace);
+            EXPECT_EQ(plain[i * targets.size() + j], distance) << sources[i] << " -> " << targets[j];
+            EXPECT_EQ(buckets[i * targets.size() + j], distance) << sources[i] << " -> " << targets[j];
+        }
+    }
+    EXPECT_EQ(plain[(sources.size() - 1) * targets.size()], INF);
+    EXPECT_EQ(plain.back(), INF);
+}
+
+// Renumbering must keep every arc and distance; queries and landmarks go through the permutation
+TEST_P(SearchTest, RenumberingKeepsDistances)
+{
+    const Graph &graph = generated.graph;
+    LandmarkTable table = selectLandmarkTable(graph, 8, LandmarkSelection::Avoid);
+    for (std::string name : {"bfs", "dfs", "hilbert"})
+    {
+        if (name == "hilbert" && generated.coordinates.empty())
+        {
+            continue; // power-law graphs have no positions
+        }
+        SCOPED_TRACE(name);
+        VertexPermutation order = computeVertexOrder(graph, parseVertexOrder(name), &generated.coordinates);
+        ASSERT_FALSE(order.isIdentity());
+        Graph permuted = permuteGraph(graph, order);
+        ASSERT_EQ(permuted.vertexCount(), graph.vertexCount());
+        ASSERT_EQ(permuted.arcCount(), graph.arcCount());
+
+        // Every vertex keeps its arcs, in external IDs
+        for (int v = 0; v < graph.vertexCount(); v++)
+        {
+            ASSERT_EQ(order.toExternal(order.toInternal(v)), v);
+            std::vector<std::pair<int, int>> original, renamed;
+            for (int e = graph.beginArc(v); e < graph.endArc(v); e++)
+            {
+                original.emplace_back(graph.target(e), graph.weight(e));
+            }
+            int u = order.toInternal(v);
+            for (int e = permuted.beginArc(u); e < permuted.endArc(u); e++)
+            {
+                renamed.emplace_back(order.toExternal(permuted.target(e)), permuted.weight(e));
+            }
+            std::ranges::sort(original);
+            std::ranges::sort(renamed);
+            ASSERT_EQ(renamed, original) << "vertex " << v;
+        }
+
+        LandmarkTable permutedTable = permuteLandmarkTable(table, order);
+        for (size_t i = 0; i < table.landmarkArray().size(); i++)
+        {
+            EXPECT_EQ(order.toExternal(permutedTable.landmarkArray()[i]), table.landmarkArray()[i]);
+        }
+        LandmarkPotential potential(permutedTable);
+        QueryWorkspace<BinaryHeap<NearestRecord>> workspace(permuted.vertexCount());
+        for (size_t i = 0; i < queries.size(); i++)
+        {
+            int start = order.toInternal(queries[i].first);
+            int end = order.toInternal(queries[i].second);
+            EXPECT_EQ(dijkstra<BinaryHeap<NearestRecord>>(start, end, permuted, workspace), expected[i]) << start << " -> " << end;
+            EXPECT_EQ(astar<BinaryHeap<NearestRecord>>(start, end, permuted, potential, workspace), expected[i]) << start << " -> " << end;
+        }
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(Families, SearchTest, ::testing::Values("grid", "geometric", "delaunay", "power-law"),
+                         [](const ::testing::TestParamInfo<std::string> &info)
+                         {
+                             std::string name = info.param;
+                             std::erase(name, '-');
+                             return name;
+                         });